@@ -0,0 +1,223 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#include <benchmark/benchmark.h>
+
+#include <flatbuffers/flatbuffers.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "roq/api.h"
+
+#include "roq/fbs/encode.h"
+
+#include "roq/samples/import/encoder.h"
+
+using namespace std::chrono_literals;
+using namespace roq::literals;
+
+// throughput (events/s) of the import encoder for each message type
+// note! the *_fbs variants use fbs::encode directly (for comparison)
+
+namespace {
+static const auto EXCHANGE = "CME"_sv;
+static const auto SYMBOL = "GEZ1"_sv;
+static const size_t DEPTH = 10;
+
+struct Data final {
+  Data() {
+    for (size_t i = 0; i < DEPTH; ++i) {
+      auto offset = static_cast<double>(i) * 0.0025;
+      bids.push_back({.price = 99.785 - offset, .quantity = 1.0 + i});
+      asks.push_back({.price = 99.800 + offset, .quantity = 1.0 + i});
+      order_ids.emplace_back(std::to_string(1000000 + i));
+      trade_ids.emplace_back(std::to_string(2000000 + i));
+    }
+    for (size_t i = 0; i < DEPTH; ++i) {
+      mbo_bids.push_back({
+          .price = bids[i].price,
+          .remaining_quantity = bids[i].quantity,
+          .action = roq::OrderUpdateAction::NEW,
+          .priority = {},
+          .order_id = order_ids[i],
+      });
+      mbo_asks.push_back({
+          .price = asks[i].price,
+          .remaining_quantity = asks[i].quantity,
+          .action = roq::OrderUpdateAction::NEW,
+          .priority = {},
+          .order_id = order_ids[i],
+      });
+      trades.push_back({
+          .side = i % 2 ? roq::Side::SELL : roq::Side::BUY,
+          .price = bids[i].price,
+          .quantity = bids[i].quantity,
+          .trade_id = trade_ids[i],
+      });
+    }
+  }
+
+  std::vector<roq::MBPUpdate> bids, asks;
+  std::vector<roq::MBOUpdate> mbo_bids, mbo_asks;
+  std::vector<roq::Trade> trades;
+  std::vector<std::string> order_ids, trade_ids;
+};
+
+static roq::MessageInfo create_message_info() {
+  return roq::MessageInfo{
+      .source = {},
+      .source_name = {},
+      .source_session_id = {},
+      .source_seqno = 1,
+      .receive_time_utc = 1ns,
+      .receive_time = 1ns,
+      .source_send_time = 1ns,
+      .source_receive_time = 1ns,
+      .origin_create_time = 1ns,
+      .origin_create_time_utc = 1ns,
+      .is_last = true,
+      .opaque = {},
+  };
+}
+
+template <typename T>
+static void run_encoder(benchmark::State &state, const T &value) {
+  roq::samples::import::Encoder encoder;
+  auto message_info = create_message_info();
+  roq::Event<T> event(message_info, value);
+  size_t bytes = 0;
+  for (auto _ : state) {
+    encoder(event);
+    benchmark::DoNotOptimize(encoder.data());
+    bytes += encoder.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(bytes);
+}
+
+template <typename T>
+static void run_fbs(benchmark::State &state, const T &value) {
+  flatbuffers::FlatBufferBuilder builder(roq::samples::import::Encoder::INITIAL_SIZE);
+  auto message_info = create_message_info();
+  roq::Event<T> event(message_info, value);
+  size_t bytes = 0;
+  for (auto _ : state) {
+    builder.Clear();
+    builder.FinishSizePrefixed(roq::fbs::encode(builder, event));
+    benchmark::DoNotOptimize(builder.GetBufferPointer());
+    bytes += builder.GetSize();
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(bytes);
+}
+}  // namespace
+
+static void BM_import_Encoder_ReferenceData(benchmark::State &state) {
+  run_encoder(
+      state,
+      roq::ReferenceData{
+          .stream_id = {},
+          .exchange = EXCHANGE,
+          .symbol = SYMBOL,
+          .description = {},
+          .security_type = {},
+          .currency = {},
+          .settlement_currency = {},
+          .commission_currency = {},
+          .tick_size = 0.0025,
+          .multiplier = 2500.0,
+          .min_trade_vol = 1.0,
+          .option_type = {},
+          .strike_currency = {},
+          .strike_price = {},
+          .underlying = {},
+          .time_zone = {},
+          .issue_date = {},
+          .settlement_date = {},
+          .expiry_datetime = {},
+          .expiry_datetime_utc = {},
+      });
+}
+
+BENCHMARK(BM_import_Encoder_ReferenceData);
+
+static void BM_import_Encoder_MarketStatus(benchmark::State &state) {
+  run_encoder(
+      state,
+      roq::MarketStatus{
+          .stream_id = {},
+          .exchange = EXCHANGE,
+          .symbol = SYMBOL,
+          .trading_status = roq::TradingStatus::OPEN,
+      });
+}
+
+BENCHMARK(BM_import_Encoder_MarketStatus);
+
+static void BM_import_Encoder_MarketByPriceUpdate(benchmark::State &state) {
+  Data data;
+  run_encoder(
+      state,
+      roq::MarketByPriceUpdate{
+          .stream_id = {},
+          .exchange = EXCHANGE,
+          .symbol = SYMBOL,
+          .bids = {data.bids.data(), static_cast<size_t>(state.range(0))},
+          .asks = {data.asks.data(), static_cast<size_t>(state.range(0))},
+          .snapshot = false,
+          .exchange_time_utc = 1ns,
+      });
+}
+
+BENCHMARK(BM_import_Encoder_MarketByPriceUpdate)->Arg(1)->Arg(DEPTH);
+
+static roq::MarketByOrderUpdate create_market_by_order_update(Data &data, size_t length) {
+  return roq::MarketByOrderUpdate{
+      .stream_id = {},
+      .exchange = EXCHANGE,
+      .symbol = SYMBOL,
+      .bids = {data.mbo_bids.data(), length},
+      .asks = {data.mbo_asks.data(), length},
+      .snapshot = false,
+      .exchange_time_utc = 1ns,
+  };
+}
+
+static void BM_import_Encoder_MarketByOrderUpdate(benchmark::State &state) {
+  Data data;
+  run_encoder(state, create_market_by_order_update(data, state.range(0)));
+}
+
+BENCHMARK(BM_import_Encoder_MarketByOrderUpdate)->Arg(1)->Arg(DEPTH);
+
+static void BM_import_fbs_MarketByOrderUpdate(benchmark::State &state) {
+  Data data;
+  run_fbs(state, create_market_by_order_update(data, state.range(0)));
+}
+
+BENCHMARK(BM_import_fbs_MarketByOrderUpdate)->Arg(1)->Arg(DEPTH);
+
+static roq::TradeSummary create_trade_summary(Data &data, size_t length) {
+  return roq::TradeSummary{
+      .stream_id = {},
+      .exchange = EXCHANGE,
+      .symbol = SYMBOL,
+      .trades = {data.trades.data(), length},
+      .exchange_time_utc = 1ns,
+  };
+}
+
+static void BM_import_Encoder_TradeSummary(benchmark::State &state) {
+  Data data;
+  run_encoder(state, create_trade_summary(data, state.range(0)));
+}
+
+BENCHMARK(BM_import_Encoder_TradeSummary)->Arg(1)->Arg(DEPTH);
+
+static void BM_import_fbs_TradeSummary(benchmark::State &state) {
+  Data data;
+  run_fbs(state, create_trade_summary(data, state.range(0)));
+}
+
+BENCHMARK(BM_import_fbs_TradeSummary)->Arg(1)->Arg(DEPTH);
@@ -0,0 +1,70 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "roq/api.h"
+
+#include "roq/samples/example-3/features.h"
+
+// throughput of computing model features for many instruments
+// note! items_per_second in M/s is the same as instruments/us
+// note! the *_scalar variant uses the reference implementation (for comparison)
+
+namespace {
+static const double ALPHA = 0.33;
+
+static void populate(roq::samples::example_3::Features &features) {
+  std::mt19937_64 generator(1);
+  std::uniform_int_distribution<int> quantity(1, 9);
+  std::vector<roq::Layer> layers(features.depth());
+  for (size_t i = 0; i < features.capacity(); ++i) {
+    auto mid = 1000.0 + static_cast<double>(i);
+    for (size_t j = 0; j < layers.size(); ++j) {
+      auto offset = static_cast<double>(j + 1);
+      layers[j] = {
+          .bid_price = mid - offset,
+          .bid_quantity = static_cast<double>(quantity(generator)),
+          .ask_price = mid + offset,
+          .ask_quantity = static_cast<double>(quantity(generator)),
+      };
+    }
+    features.set(i, {layers.data(), layers.size()});
+  }
+}
+
+template <typename F>
+static void run(benchmark::State &state, F &&update) {
+  roq::samples::example_3::Features features(state.range(0), state.range(1), ALPHA);
+  populate(features);
+  for (auto _ : state) {
+    update(features);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * features.capacity());
+}
+}  // namespace
+
+static void BM_example_3_Features(benchmark::State &state) {
+  state.SetLabel(std::string(roq::samples::example_3::Features::implementation()));
+  run(state, [](auto &features) { features.update(); });
+}
+
+BENCHMARK(BM_example_3_Features)
+    ->Args({256, 3})
+    ->Args({256, 10})
+    ->Args({4096, 3})
+    ->Args({4096, 10});
+
+static void BM_example_3_Features_scalar(benchmark::State &state) {
+  run(state, [](auto &features) { features.update_scalar(); });
+}
+
+BENCHMARK(BM_example_3_Features_scalar)
+    ->Args({256, 3})
+    ->Args({256, 10})
+    ->Args({4096, 3})
+    ->Args({4096, 10});
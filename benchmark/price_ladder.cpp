@@ -0,0 +1,165 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "roq/api.h"
+#include "roq/client.h"
+
+#include "roq/samples/common/price_ladder.h"
+
+using namespace std::chrono_literals;
+using namespace roq::literals;
+
+// latency of maintaining the top levels (per market by price update)
+// note! the *_weighted_mid variants also update a model when the depth changed
+// note! the *_DepthBuilder variant uses client::DepthBuilder (for comparison)
+
+namespace {
+static const auto EXCHANGE = "CME"_sv;
+static const auto SYMBOL = "GEZ1"_sv;
+static const double TICK_SIZE = 0.0025;
+static const size_t DEPTH = 5;
+static const size_t MAX_DEPTH = 50;
+static const size_t LEVELS = 100;     // populated levels (per side)
+static const size_t UPDATES = 65536;  // note! power of two
+
+// random walk: the mid price drifts and most updates happen close to the top
+struct Data final {
+  Data() {
+    std::mt19937_64 generator(1);
+    std::geometric_distribution<int64_t> distance(0.2);
+    std::uniform_int_distribution<int> quantity(0, 9);
+    int64_t mid = 40000;
+    for (int64_t i = 1; i <= static_cast<int64_t>(LEVELS); ++i) {
+      snapshot_bids.push_back({.price = (mid - i) * TICK_SIZE, .quantity = 1.0});
+      snapshot_asks.push_back({.price = (mid + i) * TICK_SIZE, .quantity = 1.0});
+    }
+    for (size_t i = 0; i < UPDATES; ++i) {
+      if ((i % 64) == 0)
+        mid += static_cast<int64_t>(generator() % 3) - 1;
+      auto offset = 1 + std::min<int64_t>(distance(generator), LEVELS - 1);
+      auto tick = (i % 2) ? (mid + offset) : (mid - offset);
+      updates.push_back({
+          .price = tick * TICK_SIZE,
+          .quantity = static_cast<double>(quantity(generator)),
+      });
+    }
+  }
+
+  std::vector<roq::MBPUpdate> snapshot_bids, snapshot_asks;
+  std::vector<roq::MBPUpdate> updates;
+};
+
+static roq::ReferenceData create_reference_data() {
+  return roq::ReferenceData{
+      .stream_id = {},
+      .exchange = EXCHANGE,
+      .symbol = SYMBOL,
+      .description = {},
+      .security_type = {},
+      .currency = {},
+      .settlement_currency = {},
+      .commission_currency = {},
+      .tick_size = TICK_SIZE,
+      .multiplier = 2500.0,
+      .min_trade_vol = 1.0,
+      .option_type = {},
+      .strike_currency = {},
+      .strike_price = {},
+      .underlying = {},
+      .time_zone = {},
+      .issue_date = {},
+      .settlement_date = {},
+      .expiry_datetime = {},
+      .expiry_datetime_utc = {},
+  };
+}
+
+static roq::MarketByPriceUpdate create_market_by_price_update(
+    const roq::span<roq::MBPUpdate> &bids, const roq::span<roq::MBPUpdate> &asks, bool snapshot) {
+  return roq::MarketByPriceUpdate{
+      .stream_id = {},
+      .exchange = EXCHANGE,
+      .symbol = SYMBOL,
+      .bids = bids,
+      .asks = asks,
+      .snapshot = snapshot,
+      .exchange_time_utc = 1ns,
+  };
+}
+
+template <typename T, typename F>
+static void run(benchmark::State &state, T &builder, F &&model) {
+  Data data;
+  builder.update(create_reference_data());
+  builder.update(create_market_by_price_update(
+      {data.snapshot_bids.data(), data.snapshot_bids.size()},
+      {data.snapshot_asks.data(), data.snapshot_asks.size()},
+      true));
+  size_t index = 0;
+  for (auto _ : state) {
+    auto &update = data.updates[index];
+    roq::span<roq::MBPUpdate> update_span{&update, 1};
+    auto market_by_price_update = (index % 2)
+                                      ? create_market_by_price_update({}, update_span, false)
+                                      : create_market_by_price_update(update_span, {}, false);
+    if (builder.update(market_by_price_update) > 0)
+      benchmark::DoNotOptimize(model());
+    index = (index + 1) & (UPDATES - 1);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+template <typename T>
+static void run(benchmark::State &state, T &builder) {
+  run(state, builder, []() { return 0.0; });
+}
+}  // namespace
+
+static void BM_common_PriceLadder(benchmark::State &state) {
+  std::vector<roq::Layer> depth(state.range(0));
+  roq::samples::common::PriceLadder<> price_ladder({depth.data(), depth.size()});
+  run(state, price_ladder);
+}
+
+BENCHMARK(BM_common_PriceLadder)->Arg(DEPTH)->Arg(MAX_DEPTH);
+
+static void BM_common_DepthBuilder(benchmark::State &state) {
+  std::vector<roq::Layer> depth(state.range(0));
+  auto depth_builder =
+      roq::client::DepthBuilderFactory::create(SYMBOL, {depth.data(), depth.size()});
+  run(state, *depth_builder);
+}
+
+BENCHMARK(BM_common_DepthBuilder)->Arg(DEPTH)->Arg(MAX_DEPTH);
+
+// weighted mid price: incremental (price ladder) vs re-summing the depth
+
+static void BM_common_PriceLadder_weighted_mid(benchmark::State &state) {
+  std::vector<roq::Layer> depth(state.range(0));
+  roq::samples::common::PriceLadder<> price_ladder({depth.data(), depth.size()});
+  run(state, price_ladder, [&]() { return price_ladder.weighted_mid(); });
+}
+
+BENCHMARK(BM_common_PriceLadder_weighted_mid)->Arg(DEPTH)->Arg(MAX_DEPTH);
+
+static void BM_common_PriceLadder_weighted_mid_loop(benchmark::State &state) {
+  std::vector<roq::Layer> depth(state.range(0));
+  roq::samples::common::PriceLadder<> price_ladder({depth.data(), depth.size()});
+  run(state, price_ladder, [&]() {
+    double sum_1 = 0.0, sum_2 = 0.0;
+    for (auto &[bid_price, bid_quantity, ask_price, ask_quantity] : depth) {
+      sum_1 += bid_price * bid_quantity + ask_price * ask_quantity;
+      sum_2 += bid_quantity + ask_quantity;
+    }
+    return sum_1 / sum_2;
+  });
+}
+
+BENCHMARK(BM_common_PriceLadder_weighted_mid_loop)->Arg(DEPTH)->Arg(MAX_DEPTH);
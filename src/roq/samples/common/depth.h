@@ -0,0 +1,133 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <variant>
+
+#include "roq/api.h"
+
+#include "roq/samples/common/price_ladder.h"
+
+namespace roq {
+namespace samples {
+namespace common {
+
+// compile-time depth specialization
+//
+// Depth<N> owns the top N levels and the price ladder maintaining them
+// N is a compile-time constant, i.e. loops over the levels are fully unrolled
+//
+// DepthVariant holds one of the supported instantiations, DepthFactory picks
+// the instantiation from GatewaySettings::mbp_max_depth and std::visit
+// dispatches to the specialized code (one jump per event)
+
+template <size_t N>
+class Depth final {
+ public:
+  static_assert(N > 0, "depth must be positive");
+
+  static constexpr size_t SIZE = N;
+
+  Depth() : price_ladder_({layers_.data(), layers_.size()}) {}
+
+  Depth(Depth &&) = delete;
+  Depth(const Depth &) = delete;
+
+  constexpr size_t size() const { return N; }
+
+  const Layer &operator[](size_t index) const { return layers_[index]; }
+
+  auto begin() const { return layers_.begin(); }
+  auto end() const { return layers_.end(); }
+
+  const PriceLadder<> &price_ladder() const { return price_ladder_; }
+
+  // note! O(1), maintained incrementally by the price ladder
+  double weighted_bid() const { return price_ladder_.weighted_bid(); }
+  double weighted_ask() const { return price_ladder_.weighted_ask(); }
+  double weighted_mid() const { return price_ladder_.weighted_mid(); }
+
+  // all levels populated (both sides)
+  bool is_full() const {
+    auto result = true;
+    for (size_t i = 0; i < N; ++i)
+      result &= layers_[i].bid_quantity > 0.0 && layers_[i].ask_quantity > 0.0;
+    return result;
+  }
+
+  // not crossed (or locked) when both sides are populated
+  // note! an empty or one-sided book is valid, callers check for two sides
+  bool is_valid() const {
+    auto &top = layers_[0];
+    return !(top.bid_quantity > 0.0 && top.ask_quantity > 0.0) ||
+           top.ask_price > top.bid_price;
+  }
+
+  void reset() { price_ladder_.reset(); }
+
+  void set_tick_size(double tick_size) { price_ladder_.set_tick_size(tick_size); }
+
+  // returns the number of levels if the depth may have changed, zero otherwise
+  size_t update(const MarketByPriceUpdate &market_by_price_update) {
+    return price_ladder_.update(market_by_price_update);
+  }
+
+ private:
+  std::array<Layer, N> layers_;
+  PriceLadder<> price_ladder_;
+};
+
+// note! the first alternative is the default
+using DepthVariant = std::variant<Depth<1>, Depth<3>, Depth<5>, Depth<10>, Depth<20>>;
+
+struct DepthFactory final {
+  static constexpr std::array<size_t, 5> SUPPORTED{1, 3, 5, 10, 20};
+
+  // largest supported depth not exceeding what we want (max_depth) and what the
+  // gateway can deliver (mbp_max_depth, zero means unlimited)
+  static size_t select(size_t max_depth, uint32_t mbp_max_depth) {
+    auto limit = mbp_max_depth == 0 ? max_depth : std::min<size_t>(max_depth, mbp_max_depth);
+    auto result = SUPPORTED[0];
+    for (auto depth : SUPPORTED)
+      if (depth <= limit)
+        result = depth;
+    return result;
+  }
+
+  // note! constructs in-place (any previous depth is destroyed)
+  static void create(DepthVariant &result, size_t depth) {
+    switch (depth) {
+      case 1:
+        result.emplace<Depth<1>>();
+        break;
+      case 3:
+        result.emplace<Depth<3>>();
+        break;
+      case 5:
+        result.emplace<Depth<5>>();
+        break;
+      case 10:
+        result.emplace<Depth<10>>();
+        break;
+      case 20:
+        result.emplace<Depth<20>>();
+        break;
+      default:
+        assert(false);  // note! use select()
+        result.emplace<Depth<1>>();
+    }
+  }
+
+  static size_t size(const DepthVariant &depth) {
+    return std::visit([](auto &value) { return value.size(); }, depth);
+  }
+};
+
+}  // namespace common
+}  // namespace samples
+}  // namespace roq
@@ -0,0 +1,171 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+
+#include "roq/api.h"
+
+#include "roq/samples/common/depth.h"
+
+namespace roq {
+namespace samples {
+namespace common {
+
+// recent depth (fixed memory)
+//
+// a ring buffer of compact depth snapshots, each with the change from the
+// previous snapshot (order flow imbalance of the top of book)
+//
+// * SIZE entries are allocated up front (power of two), i.e. the memory per
+//   instrument is SIZE * sizeof(Entry) and known at compile-time
+// * entries are cache-aligned (two cache lines)
+// * O(1) append (the oldest entry is overwritten) and O(1) lookback by age
+//
+// note!
+//   prices are stored as ticks (best price plus offsets), quantities as float
+//   (compact, sufficient for features)
+//   levels beyond LEVELS are not stored, nor are levels (and the levels
+//   after) more than MAX_OFFSET ticks from the best price
+
+template <size_t SIZE = 256, size_t LEVELS = 8>
+class DepthHistory final {
+ public:
+  static_assert(SIZE >= 2 && (SIZE & (SIZE - 1)) == 0, "SIZE must be a power of two");
+  static_assert(LEVELS > 0 && LEVELS < 256, "LEVELS must fit uint8_t");
+
+  struct alignas(64) Entry final {
+    std::chrono::nanoseconds exchange_time;
+    int64_t bid_tick;  // note! best price
+    int64_t ask_tick;  // note! best price
+    // order flow imbalance (change of the top of book from the previous entry)
+    //   positive: bid improved or grew / ask retreated or shrank
+    //   https://arxiv.org/abs/1011.6402
+    float order_flow_imbalance;
+    uint8_t bid_levels;
+    uint8_t ask_levels;
+    std::array<uint16_t, LEVELS> bid_offset;  // note! ticks worse than the best price
+    std::array<uint16_t, LEVELS> ask_offset;  // note! ticks worse than the best price
+    std::array<float, LEVELS> bid_quantity;
+    std::array<float, LEVELS> ask_quantity;
+
+    int64_t bid(size_t level) const { return bid_tick - bid_offset[level]; }
+    int64_t ask(size_t level) const { return ask_tick + ask_offset[level]; }
+  };
+
+  // bytes per instrument
+  static constexpr size_t MEMORY = SIZE * sizeof(Entry);
+
+  static constexpr int64_t MAX_OFFSET = std::numeric_limits<uint16_t>::max();
+
+  DepthHistory() : entries_(std::make_unique<Entry[]>(SIZE)) {}
+
+  DepthHistory(DepthHistory &&) = delete;
+  DepthHistory(const DepthHistory &) = delete;
+
+  // number of entries available for lookback
+  size_t size() const { return std::min<uint64_t>(count_, SIZE); }
+
+  bool empty() const { return count_ == 0; }
+
+  // total number of entries appended
+  uint64_t count() const { return count_; }
+
+  // note! age 0 is the latest entry
+  const Entry &operator[](size_t age) const {
+    assert(age < size());
+    return entries_[(count_ - 1 - age) & (SIZE - 1)];
+  }
+
+  void clear() { count_ = {}; }
+
+  // sum of the order flow imbalance of the latest entries (at most size())
+  double order_flow_imbalance(size_t entries) const {
+    double result = 0.0;
+    for (size_t age = 0; age < std::min(entries, size()); ++age)
+      result += (*this)[age].order_flow_imbalance;
+    return result;
+  }
+
+  template <size_t N>
+  void append(const Depth<N> &depth, double tick_size, std::chrono::nanoseconds exchange_time) {
+    append({&depth[0], N}, tick_size, exchange_time);
+  }
+
+  void append(
+      const roq::span<const Layer> &layers,
+      double tick_size,
+      std::chrono::nanoseconds exchange_time) {
+    auto &entry = entries_[count_ & (SIZE - 1)];
+    entry.exchange_time = exchange_time;
+    entry.bid_tick = {};
+    entry.ask_tick = {};
+    entry.bid_levels = {};
+    entry.ask_levels = {};
+    auto levels = std::min(LEVELS, layers.size());
+    // note! a side stops at the first level which can't be represented (or is out of order)
+    auto bid = true, ask = true;
+    for (size_t i = 0; i < levels; ++i) {
+      auto &layer = layers[i];
+      if (bid && layer.bid_quantity > 0.0) {
+        auto tick = std::llround(layer.bid_price / tick_size);
+        if (entry.bid_levels == 0)
+          entry.bid_tick = tick;
+        auto offset = entry.bid_tick - tick;
+        bid = offset >= 0 && offset <= MAX_OFFSET;
+        if (bid) {
+          entry.bid_offset[entry.bid_levels] = static_cast<uint16_t>(offset);
+          entry.bid_quantity[entry.bid_levels++] = static_cast<float>(layer.bid_quantity);
+        }
+      }
+      if (ask && layer.ask_quantity > 0.0) {
+        auto tick = std::llround(layer.ask_price / tick_size);
+        if (entry.ask_levels == 0)
+          entry.ask_tick = tick;
+        auto offset = tick - entry.ask_tick;
+        ask = offset >= 0 && offset <= MAX_OFFSET;
+        if (ask) {
+          entry.ask_offset[entry.ask_levels] = static_cast<uint16_t>(offset);
+          entry.ask_quantity[entry.ask_levels++] = static_cast<float>(layer.ask_quantity);
+        }
+      }
+    }
+    entry.order_flow_imbalance = count_ > 0 ? order_flow_imbalance((*this)[0], entry) : 0.0f;
+    ++count_;
+  }
+
+ protected:
+  // note! a side is ignored if it's empty (before or after)
+  static float order_flow_imbalance(const Entry &previous, const Entry &current) {
+    float result = 0.0f;
+    if (previous.bid_levels > 0 && current.bid_levels > 0) {
+      if (current.bid_tick >= previous.bid_tick)
+        result += current.bid_quantity[0];
+      if (current.bid_tick <= previous.bid_tick)
+        result -= previous.bid_quantity[0];
+    }
+    if (previous.ask_levels > 0 && current.ask_levels > 0) {
+      if (current.ask_tick <= previous.ask_tick)
+        result -= current.ask_quantity[0];
+      if (current.ask_tick >= previous.ask_tick)
+        result += previous.ask_quantity[0];
+    }
+    return result;
+  }
+
+ private:
+  std::unique_ptr<Entry[]> entries_;
+  uint64_t count_ = {};
+};
+
+}  // namespace common
+}  // namespace samples
+}  // namespace roq
@@ -0,0 +1,187 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "roq/exceptions.h"
+
+namespace roq {
+namespace samples {
+namespace common {
+
+// interns (source, exchange, symbol) as dense ids
+//
+// * instruments are stored contiguously and indexed by id
+// * find is a single probe sequence into an open-addressing hash table (the
+//   hash is stored with the id, strings are only compared on a hash match)
+// * events without a symbol (connection status, download, ...) can be
+//   dispatched to all instruments of a source
+//
+// note!
+//   the capacity is fixed, instruments are constructed in-place and never
+//   moved (they may hold views into their own storage)
+
+template <typename T>
+class InstrumentRegistry final {
+ public:
+  using Id = uint32_t;
+
+  static constexpr Id NONE = std::numeric_limits<Id>::max();
+
+  explicit InstrumentRegistry(size_t capacity)
+      : capacity_(capacity), storage_(std::make_unique<Storage[]>(capacity)),
+        slots_(round_up(2 * capacity), Slot{.hash = {}, .id = NONE}),
+        mask_(slots_.size() - 1) {
+    keys_.reserve(capacity);
+  }
+
+  InstrumentRegistry(InstrumentRegistry &&) = delete;
+  InstrumentRegistry(const InstrumentRegistry &) = delete;
+
+  ~InstrumentRegistry() {
+    for (Id id = 0; id < keys_.size(); ++id)
+      (*this)[id].~T();
+  }
+
+  size_t size() const { return keys_.size(); }
+
+  T &operator[](Id id) {
+    assert(id < keys_.size());
+    return *std::launder(reinterpret_cast<T *>(&storage_[id]));
+  }
+
+  const T &operator[](Id id) const {
+    assert(id < keys_.size());
+    return *std::launder(reinterpret_cast<const T *>(&storage_[id]));
+  }
+
+  // note! arguments are forwarded to the constructor of T
+  template <typename... Args>
+  Id emplace(
+      uint8_t source,
+      const std::string_view &exchange,
+      const std::string_view &symbol,
+      Args &&...args) {
+    using namespace roq::literals;
+    if (ROQ_UNLIKELY(keys_.size() == capacity_))
+      throw RuntimeErrorException("Unexpected: capacity={} exceeded"_fmt, capacity_);
+    auto hash = hash_key(source, exchange, symbol);
+    if (ROQ_UNLIKELY(probe(hash, source, exchange, symbol) != NONE))
+      throw RuntimeErrorException(
+          R"(Unexpected: source={}, exchange="{}", symbol="{}" already exists)"_fmt,
+          source,
+          exchange,
+          symbol);
+    auto id = static_cast<Id>(keys_.size());
+    new (&storage_[id]) T(std::forward<Args>(args)...);
+    keys_.push_back({
+        .source = source,
+        .exchange = std::string(exchange),
+        .symbol = std::string(symbol),
+    });
+    auto i = hash & mask_;
+    while (slots_[i].id != NONE)
+      i = (i + 1) & mask_;
+    slots_[i] = {.hash = hash, .id = id};
+    if (sources_.size() <= source)
+      sources_.resize(source + 1);
+    sources_[source].push_back(id);
+    return id;
+  }
+
+  // returns NONE if not found
+  Id find(uint8_t source, const std::string_view &exchange, const std::string_view &symbol) const {
+    return probe(hash_key(source, exchange, symbol), source, exchange, symbol);
+  }
+
+  // all instruments of a source
+  template <typename F>
+  void for_each(uint8_t source, F &&f) {
+    if (source >= sources_.size())
+      return;
+    for (auto id : sources_[source])
+      f((*this)[id]);
+  }
+
+  // returns false if not found
+  template <typename F>
+  bool dispatch(
+      uint8_t source, const std::string_view &exchange, const std::string_view &symbol, F &&f) {
+    auto id = find(source, exchange, symbol);
+    if (id == NONE)
+      return false;
+    f((*this)[id]);
+    return true;
+  }
+
+ protected:
+  using Storage = std::aligned_storage_t<sizeof(T), alignof(T)>;
+
+  struct Key final {
+    uint8_t source;
+    std::string exchange;
+    std::string symbol;
+  };
+
+  struct Slot final {
+    uint64_t hash;
+    Id id;
+  };
+
+  static size_t round_up(size_t value) {
+    size_t result = 16;
+    while (result < value)
+      result <<= 1;
+    return result;
+  }
+
+  static uint64_t hash_key(
+      uint8_t source, const std::string_view &exchange, const std::string_view &symbol) {
+    std::hash<std::string_view> hash;
+    auto result = hash(symbol);
+    result ^= hash(exchange) + 0x9e3779b97f4a7c15ull + (result << 6) + (result >> 2);
+    result ^= source + 0x9e3779b97f4a7c15ull + (result << 6) + (result >> 2);
+    return result;
+  }
+
+  Id probe(
+      uint64_t hash,
+      uint8_t source,
+      const std::string_view &exchange,
+      const std::string_view &symbol) const {
+    for (auto i = hash & mask_;; i = (i + 1) & mask_) {
+      auto &slot = slots_[i];
+      if (slot.id == NONE)
+        return NONE;
+      if (slot.hash != hash)
+        continue;
+      auto &key = keys_[slot.id];
+      if (key.source == source && key.symbol == symbol && key.exchange == exchange)
+        return slot.id;
+    }
+  }
+
+ private:
+  const size_t capacity_;
+  std::unique_ptr<Storage[]> storage_;
+  std::vector<Key> keys_;
+  std::vector<Slot> slots_;
+  const size_t mask_;
+  std::vector<std::vector<Id>> sources_;
+};
+
+}  // namespace common
+}  // namespace samples
+}  // namespace roq
@@ -0,0 +1,350 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "roq/api.h"
+
+namespace roq {
+namespace samples {
+namespace common {
+
+// flat price ladder (replaces client::DepthBuilder for market by price)
+//
+// each side is a ring buffer of quantities indexed by price / tick_size
+// covering a window of SIZE ticks which is re-centred as the market moves
+//
+// * O(1) level updates (no search, no allocation, no node churn)
+// * the best price is tracked incrementally, the next level is found by
+//   scanning a bit-mask of non-empty levels (count-trailing-zeros)
+// * the top levels are adjacent in memory (cache resident)
+// * sum(quantity) and sum(price * quantity) of the visible levels (the depth)
+//   are maintained incrementally, i.e. weighted prices, microprice and
+//   imbalance are O(1) regardless of the depth
+//
+// the depth (top N levels) is written to the span given to the constructor
+// and only when an update could have changed it
+//
+// note!
+//   levels outside the window are ignored, i.e. the window must be large
+//   enough to cover the depth you care about (the best price is placed a
+//   quarter into the window, so SIZE / 4 ticks better and 3 * SIZE / 4
+//   ticks worse than the best price can be represented)
+//   ask keys are ticks and bid keys are negated ticks, i.e. the best price
+//   of either side is always the *lowest* key
+
+template <size_t SIZE = 4096>
+class PriceLadder final {
+ public:
+  static_assert(SIZE >= 64 && (SIZE & (SIZE - 1)) == 0, "SIZE must be a power of two");
+
+  explicit PriceLadder(const roq::span<Layer> &depth)
+      : depth_(depth), bids_(depth.size()), asks_(depth.size()) {
+    reset();
+  }
+
+  PriceLadder(PriceLadder &&) = delete;
+  PriceLadder(const PriceLadder &) = delete;
+
+  // visible levels
+  size_t bid_levels() const { return bids_.count(); }
+  size_t ask_levels() const { return asks_.count(); }
+
+  // sum(quantity) of the visible levels
+  double bid_quantity() const { return bids_.quantity(); }
+  double ask_quantity() const { return asks_.quantity(); }
+
+  // sum(price * quantity) / sum(quantity) of the visible levels
+  double weighted_bid() const { return -bids_.weighted_key() * tick_size_; }
+  double weighted_ask() const { return asks_.weighted_key() * tick_size_; }
+
+  // both sides
+  double weighted_mid() const {
+    auto bid_quantity = bids_.quantity(), ask_quantity = asks_.quantity();
+    return (weighted_bid() * bid_quantity + weighted_ask() * ask_quantity) /
+           (bid_quantity + ask_quantity);
+  }
+
+  // best prices weighted by the opposite quantity
+  double microprice() const {
+    auto &top = depth_[0];
+    return (top.bid_price * top.ask_quantity + top.ask_price * top.bid_quantity) /
+           (top.bid_quantity + top.ask_quantity);
+  }
+
+  // (bid - ask) / (bid + ask) using sum(quantity) of the visible levels
+  double imbalance() const {
+    auto bid_quantity = bids_.quantity(), ask_quantity = asks_.quantity();
+    return (bid_quantity - ask_quantity) / (bid_quantity + ask_quantity);
+  }
+
+  void reset() {
+    tick_size_ = NaN;
+    bids_.clear();
+    asks_.clear();
+    extract();
+  }
+
+  void update(const ReferenceData &reference_data) { set_tick_size(reference_data.tick_size); }
+
+  void set_tick_size(double tick_size) {
+    if (tick_size == tick_size_ || !(tick_size > 0.0))
+      return;
+    // note! existing keys are meaningless with a different tick size
+    tick_size_ = tick_size;
+    bids_.clear();
+    asks_.clear();
+    extract();
+  }
+
+  // returns the depth (number of levels) if the top levels may have changed, zero otherwise
+  size_t update(const MarketByPriceUpdate &market_by_price_update) {
+    if (ROQ_UNLIKELY(std::isnan(tick_size_)))  // note! requires reference data
+      return 0;
+    if (market_by_price_update.snapshot) {
+      bids_.clear();
+      asks_.clear();
+    }
+    auto dirty = market_by_price_update.snapshot;
+    for (auto &[price, quantity] : market_by_price_update.bids)
+      dirty |= bids_.update(-to_tick(price), quantity);
+    for (auto &[price, quantity] : market_by_price_update.asks)
+      dirty |= asks_.update(to_tick(price), quantity);
+    if (!dirty)
+      return 0;
+    return extract();
+  }
+
+ protected:
+  class Side final {
+   public:
+    static constexpr int64_t EMPTY = std::numeric_limits<int64_t>::max();
+
+    explicit Side(size_t limit) : limit_(limit) {}
+
+    size_t count() const { return count_; }
+
+    double quantity() const { return quantity_sum_; }
+
+    // note! fractional key (NaN if empty)
+    double weighted_key() const {
+      return static_cast<double>(base_) + notional_sum_ / quantity_sum_;
+    }
+
+    // note! only touches non-empty levels
+    void clear() {
+      for (size_t i = 0; i < mask_.size(); ++i) {
+        for (auto bits = mask_[i]; bits != 0; bits &= bits - 1)
+          quantity_[(i << 6) + __builtin_ctzll(bits)] = 0.0;
+        mask_[i] = 0u;
+      }
+      best_ = EMPTY;
+      base_ = {};
+      last_ = EMPTY;
+      count_ = {};
+      quantity_sum_ = {};
+      notional_sum_ = {};
+    }
+
+    // returns true if the update changed the visible levels
+    bool update(int64_t key, double quantity) {
+      if (quantity > 0.0) {
+        if (ROQ_UNLIKELY(best_ == EMPTY)) {
+          base_ = key - static_cast<int64_t>(SIZE / 4);
+        } else if (ROQ_UNLIKELY(key < base_)) {
+          shift(key - static_cast<int64_t>(SIZE / 4));
+        } else if (ROQ_UNLIKELY(key >= (base_ + static_cast<int64_t>(SIZE)))) {
+          // note! re-centre (if the best price has moved) before dropping the level
+          if (best_ > (base_ + static_cast<int64_t>(SIZE / 4)))
+            shift(best_ - static_cast<int64_t>(SIZE / 4));
+          if (key >= (base_ + static_cast<int64_t>(SIZE)))
+            return false;  // note! too deep
+        }
+        auto index = to_index(key);
+        auto previous = quantity_[index];
+        quantity_[index] = quantity;
+        mask_[index >> 6] |= uint64_t{1} << (index & 63);
+        if (key < best_)
+          best_ = key;
+        if (previous > 0.0) {
+          if (key > last_)
+            return false;
+          accumulate(key, quantity - previous);
+          return true;
+        }
+        if (count_ < limit_) {
+          ++count_;
+          accumulate(key, quantity);
+          if (last_ == EMPTY || key > last_)
+            last_ = key;
+          return true;
+        }
+        if (key > last_)
+          return false;
+        // note! the deepest visible level is pushed out
+        accumulate(key, quantity);
+        accumulate(last_, -quantity_[to_index(last_)]);
+        last_ = prev(last_ - 1);
+        return true;
+      }
+      if (best_ == EMPTY || key < base_ || key >= (base_ + static_cast<int64_t>(SIZE)))
+        return false;
+      auto index = to_index(key);
+      auto previous = quantity_[index];
+      if (!(previous > 0.0))
+        return false;
+      quantity_[index] = 0.0;
+      mask_[index >> 6] &= ~(uint64_t{1} << (index & 63));
+      if (key == best_)
+        best_ = next(key + 1);
+      if (key > last_)
+        return false;
+      accumulate(key, -previous);
+      --count_;
+      // note! the next level (if any) becomes visible
+      auto candidate = next(last_ + 1);
+      if (candidate != EMPTY) {
+        ++count_;
+        accumulate(candidate, quantity_[to_index(candidate)]);
+        last_ = candidate;
+      } else if (key == last_) {
+        last_ = count_ > 0 ? prev(key - 1) : EMPTY;
+      }
+      if (count_ == 0) {
+        quantity_sum_ = {};  // note! avoids accumulated rounding errors
+        notional_sum_ = {};
+      }
+      if (best_ != EMPTY && best_ > (base_ + static_cast<int64_t>(SIZE / 2)))
+        shift(best_ - static_cast<int64_t>(SIZE / 4));
+      return true;
+    }
+
+    // visits the visible levels
+    template <typename F>
+    void extract(F &&f) const {
+      auto key = best_;
+      for (size_t i = 0; i < count_; ++i, key = next(key + 1))
+        f(i, key, quantity_[to_index(key)]);
+    }
+
+   protected:
+    static size_t to_index(int64_t key) { return static_cast<uint64_t>(key) & (SIZE - 1); }
+
+    // note! keys are relative to the window (small numbers, better precision)
+    void accumulate(int64_t key, double quantity) {
+      quantity_sum_ += quantity;
+      notional_sum_ += static_cast<double>(key - base_) * quantity;
+    }
+
+    // first non-empty key >= key (within the window)
+    int64_t next(int64_t key) const {
+      auto end = base_ + static_cast<int64_t>(SIZE);
+      while (key < end) {
+        auto index = to_index(key);
+        auto bits = mask_[index >> 6] >> (index & 63);
+        if (bits != 0) {
+          key += __builtin_ctzll(bits);
+          // note! the window is not aligned, the word could wrap around
+          return key < end ? key : EMPTY;
+        }
+        key += 64 - static_cast<int64_t>(index & 63);
+      }
+      return EMPTY;
+    }
+
+    // last non-empty key <= key (within the window)
+    int64_t prev(int64_t key) const {
+      while (key >= base_) {
+        auto index = to_index(key);
+        auto bits = mask_[index >> 6] << (63 - (index & 63));
+        if (bits != 0) {
+          key -= __builtin_clzll(bits);
+          // note! the window is not aligned, the word could wrap around
+          return key >= base_ ? key : EMPTY;
+        }
+        key -= static_cast<int64_t>(index & 63) + 1;
+      }
+      return EMPTY;
+    }
+
+    // move the window, levels falling out of the window are dropped
+    void shift(int64_t base) {
+      auto delta = base - base_;
+      if (delta <= -static_cast<int64_t>(SIZE) || delta >= static_cast<int64_t>(SIZE)) {
+        clear();  // note! nothing survives
+        base_ = base;
+        return;
+      }
+      // note! keys leaving the window share ring positions with keys entering it
+      auto begin = delta < 0 ? base + static_cast<int64_t>(SIZE) : base_;
+      auto end = delta < 0 ? base_ + static_cast<int64_t>(SIZE) : base;
+      for (auto key = begin; key < end; ++key) {
+        auto index = to_index(key);
+        quantity_[index] = 0.0;
+        mask_[index >> 6] &= ~(uint64_t{1} << (index & 63));
+      }
+      base_ = base;
+      if (best_ != EMPTY && best_ >= (base_ + static_cast<int64_t>(SIZE)))
+        best_ = EMPTY;  // note! everything was dropped
+      recompute();
+    }
+
+    // note! O(depth), only used when the window moves
+    void recompute() {
+      count_ = {};
+      last_ = EMPTY;
+      quantity_sum_ = {};
+      notional_sum_ = {};
+      for (auto key = best_; key != EMPTY && count_ < limit_; key = next(key + 1)) {
+        ++count_;
+        accumulate(key, quantity_[to_index(key)]);
+        last_ = key;
+      }
+    }
+
+   private:
+    const size_t limit_;
+    std::array<double, SIZE> quantity_ = {};
+    std::array<uint64_t, SIZE / 64> mask_ = {};
+    int64_t best_ = EMPTY;
+    int64_t base_ = {};     // note! lowest key of the window
+    int64_t last_ = EMPTY;  // note! deepest visible key
+    size_t count_ = {};     // note! visible levels
+    double quantity_sum_ = {};
+    double notional_sum_ = {};  // note! relative to base_
+  };
+
+  int64_t to_tick(double price) const { return std::llround(price / tick_size_); }
+
+  double to_price(int64_t tick) const { return static_cast<double>(tick) * tick_size_; }
+
+  size_t extract() {
+    for (auto &layer : depth_)
+      layer = {};
+    bids_.extract([&](auto index, auto key, auto quantity) {
+      depth_[index].bid_price = to_price(-key);
+      depth_[index].bid_quantity = quantity;
+    });
+    asks_.extract([&](auto index, auto key, auto quantity) {
+      depth_[index].ask_price = to_price(key);
+      depth_[index].ask_quantity = quantity;
+    });
+    return std::max(bids_.count(), asks_.count());
+  }
+
+ private:
+  const roq::span<Layer> depth_;
+  double tick_size_ = NaN;
+  Side bids_;
+  Side asks_;
+};
+
+}  // namespace common
+}  // namespace samples
+}  // namespace roq
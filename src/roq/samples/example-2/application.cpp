@@ -5,8 +5,10 @@
 #include <vector>
 
 #include "roq/exceptions.h"
+#include "roq/logging.h"
 
 #include "roq/samples/example-2/config.h"
+#include "roq/samples/example-2/flags.h"
 #include "roq/samples/example-2/strategy.h"
 
 using namespace roq::literals;
@@ -23,6 +25,10 @@ int Application::main_helper(const roq::span<std::string_view> &args) {
     throw RuntimeErrorException(
         "Expected exactly two arguments: "
         "futures exchange then cash exchange"_sv);
+  if (Flags::basis_window() == 0)
+    throw RuntimeErrorException("Expected --basis_window > 0"_sv);
+  if (!Flags::futures_symbol().empty())
+    log::warn("--futures_symbol is deprecated, use --futures_symbols"_sv);
   Config config;
   // note!
   //   absl::flags will have removed all flags and we're left with arguments
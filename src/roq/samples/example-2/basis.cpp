@@ -0,0 +1,81 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#include "roq/samples/example-2/basis.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace roq {
+namespace samples {
+namespace example_2 {
+
+Basis::Basis(size_t futures, size_t window, double alpha, std::chrono::nanoseconds max_skew)
+    : alpha_(alpha), max_skew_(max_skew) {
+  assert(window > 0);
+  legs_.reserve(futures);
+  for (size_t i = 0; i < futures; ++i)
+    legs_.emplace_back(window);
+}
+
+void Basis::reset_futures(size_t index) {
+  auto &leg = legs_[index];
+  leg.futures = {};
+  reset(leg);
+}
+
+void Basis::reset_cash() {
+  cash_ = {};
+  for (auto &leg : legs_)
+    reset(leg);
+}
+
+void Basis::reset(Leg &leg) {
+  auto &window = leg.window;
+  window.index = {};
+  window.count = {};
+  window.reference = NaN;
+  window.sum = {};
+  window.sum_squares = {};
+  leg.result = {};
+}
+
+bool Basis::sample(Leg &leg, const Price &updated, const Price &other) {
+  if (std::isnan(leg.futures.value) || std::isnan(cash_.value))
+    return false;
+  if ((updated.time + max_skew_) < other.time)  // note! delayed
+    return false;
+  update(leg.window, leg.result, leg.futures.value - cash_.value);
+  return true;
+}
+
+void Basis::update(Window &window, Result &result, double value) {
+  result.value = value;
+  if (std::isnan(result.ema))
+    result.ema = value;  // initialize
+  else
+    result.ema = alpha_ * value + (1.0 - alpha_) * result.ema;
+  if (std::isnan(window.reference))
+    window.reference = value;
+  auto sample = value - window.reference;
+  auto &slot = window.samples[window.index];
+  if (window.count == window.samples.size()) {
+    window.sum -= slot;
+    window.sum_squares -= slot * slot;
+  } else {
+    ++window.count;
+  }
+  slot = sample;
+  window.sum += sample;
+  window.sum_squares += sample * sample;
+  window.index = (window.index + 1) % window.samples.size();
+  auto count = static_cast<double>(window.count);
+  auto mean = window.sum / count;
+  auto variance = std::max(0.0, window.sum_squares / count - mean * mean);
+  result.mean = window.reference + mean;
+  result.stddev = std::sqrt(variance);
+  result.zscore = result.stddev > 0.0 ? (sample - mean) / result.stddev : NaN;
+}
+
+}  // namespace example_2
+}  // namespace samples
+}  // namespace roq
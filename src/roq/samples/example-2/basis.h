@@ -0,0 +1,129 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#pragma once
+
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "roq/api.h"
+
+namespace roq {
+namespace samples {
+namespace example_2 {
+
+// futures/cash basis (futures price minus cash price)
+//
+// one leg per futures contract, all against the same cash price
+// * updated incrementally when either price changes (a futures update
+//   refreshes one leg, a cash update refreshes all legs)
+// * exponential moving average and rolling mean / standard deviation over a
+//   fixed window of samples (z-score), maintained by running sums, i.e. O(1)
+//   per leg and no allocation after construction
+//
+// note!
+//   an update is not used if its time is older than the last update of the
+//   other side by more than max_skew, i.e. a delayed feed is never mixed with
+//   fresher prices from the other venue
+//   a price which didn't change is not stale (a quiet book is still valid)
+
+class Basis final {
+ public:
+  struct Result final {
+    double value = NaN;
+    double ema = NaN;
+    double mean = NaN;
+    double stddev = NaN;
+    double zscore = NaN;
+  };
+
+  Basis(size_t futures, size_t window, double alpha, std::chrono::nanoseconds max_skew);
+
+  Basis(Basis &&) = delete;
+  Basis(const Basis &) = delete;
+
+  size_t size() const { return legs_.size(); }
+
+  const Result &operator[](size_t index) const { return legs_[index].result; }
+
+  // note! prices are unavailable and the samples (and ema) are discarded
+  void reset_futures(size_t index);
+  void reset_cash();  // note! all legs
+
+  // note! the callback receives (index, result) for each leg with a new sample
+
+  // NaN price means unavailable
+  template <typename Callback>
+  void update_futures(
+      size_t index, double price, std::chrono::nanoseconds time, Callback &&callback) {
+    auto &leg = legs_[index];
+    if (!update_price(leg.futures, price, time))
+      return;
+    if (sample(leg, leg.futures, cash_))
+      callback(index, leg.result);
+  }
+
+  // NaN price means unavailable
+  template <typename Callback>
+  void update_cash(double price, std::chrono::nanoseconds time, Callback &&callback) {
+    if (!update_price(cash_, price, time))
+      return;
+    for (size_t index = 0; index < legs_.size(); ++index) {
+      auto &leg = legs_[index];
+      if (sample(leg, cash_, leg.futures))
+        callback(index, leg.result);
+    }
+  }
+
+ protected:
+  struct Price final {
+    double value = NaN;
+    std::chrono::nanoseconds time = {};
+  };
+
+  // rolling window (ring buffer)
+  // note! samples are relative to the first sample (avoids cancellation)
+  struct Window final {
+    explicit Window(size_t size) : samples(size) {}
+    std::vector<double> samples;
+    size_t index = {};
+    size_t count = {};
+    double reference = NaN;
+    double sum = {};
+    double sum_squares = {};
+  };
+
+  struct Leg final {
+    explicit Leg(size_t window) : window(window) {}
+    Price futures;
+    Window window;
+    Result result;
+  };
+
+  // returns true if the price changed
+  static bool update_price(Price &price, double value, std::chrono::nanoseconds time) {
+    price.time = time;
+    if (value == price.value || (std::isnan(value) && std::isnan(price.value)))
+      return false;
+    price.value = value;
+    return true;
+  }
+
+  static void reset(Leg &);
+
+  // returns true if a new sample was added
+  bool sample(Leg &, const Price &updated, const Price &other);
+
+  void update(Window &, Result &, double value);
+
+ private:
+  const double alpha_;
+  const std::chrono::nanoseconds max_skew_;
+  Price cash_;
+  std::vector<Leg> legs_;
+};
+
+}  // namespace example_2
+}  // namespace samples
+}  // namespace roq
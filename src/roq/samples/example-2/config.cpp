@@ -10,10 +10,11 @@ namespace example_2 {
 
 void Config::dispatch(Handler &handler) const {
   // callback for each subscription pattern
-  handler(client::Symbol{
-      .regex = Flags::futures_symbol(),
-      .exchange = Flags::futures_exchange(),
-  });
+  for (auto &symbol : Flags::futures_symbols())
+    handler(client::Symbol{
+        .regex = symbol,
+        .exchange = Flags::futures_exchange(),
+    });
   handler(client::Symbol{
       .regex = Flags::cash_symbol(),
       .exchange = Flags::cash_exchange(),
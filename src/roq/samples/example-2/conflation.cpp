@@ -0,0 +1,64 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#include "roq/samples/example-2/conflation.h"
+
+#include "roq/logging.h"
+
+using namespace roq::literals;
+
+namespace roq {
+namespace samples {
+namespace example_2 {
+
+Conflation::Conflation(std::chrono::nanoseconds threshold) : threshold_(threshold) {
+}
+
+bool Conflation::operator()(const MessageInfo &message_info, std::chrono::nanoseconds now) {
+  ++counters_.updates;
+  if (!message_info.is_last)
+    return false;
+  ++counters_.batches;
+  if (threshold_.count() == 0) {
+    ++counters_.flushes;
+    return true;
+  }
+  auto lag = now - message_info.receive_time;
+  auto lagging = lag > threshold_;
+  if (ROQ_UNLIKELY(lagging != lagging_)) {
+    lagging_ = lagging;
+    if (lagging_) {
+      log::info("conflation=true, lag={}"_fmt, lag);
+      begin_ = counters_;
+    } else {
+      // note! falls through to the model update, i.e. pending batches are drained
+      log::info(
+          "conflation=false, lag={}, updates={}, batches={}, conflated={}"_fmt,
+          lag,
+          counters_.updates - begin_.updates,
+          counters_.batches - begin_.batches,
+          counters_.conflated - begin_.conflated);
+    }
+  }
+  if (lagging_ && (message_info.receive_time - last_flush_) < threshold_) {
+    ++counters_.conflated;
+    pending_ = true;
+    return false;
+  }
+  last_flush_ = message_info.receive_time;
+  pending_ = false;
+  ++counters_.flushes;
+  return true;
+}
+
+bool Conflation::drain(std::chrono::nanoseconds now) {
+  if (!pending_ || (now - last_flush_) < threshold_)
+    return false;
+  last_flush_ = now;
+  pending_ = false;
+  ++counters_.flushes;
+  return true;
+}
+
+}  // namespace example_2
+}  // namespace samples
+}  // namespace roq
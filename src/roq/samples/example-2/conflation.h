@@ -0,0 +1,75 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include "roq/api.h"
+
+namespace roq {
+namespace samples {
+namespace example_2 {
+
+// decides when derived models should be updated
+//
+// normally at the end of each batch (MessageInfo::is_last)
+//
+// when the strategy falls behind (lag above the threshold), updates are
+// conflated: depth is still updated for every message, but the model is only
+// updated when the threshold has elapsed (measured by receive_time) since the
+// last update, i.e. the model runs on the latest book instead of every stale
+// book in between
+//
+// a conflated batch is pending until the next model update, i.e. it is
+// drained by the next batch (always when leaving conflation) or by a timer
+// when no further updates arrive
+//
+// note!
+//   lag is the current time minus MessageInfo::receive_time (both using the
+//   monotonic clock)
+//   a zero threshold disables conflation
+//   the throttle is global (not per symbol), all instruments are updated
+//   together, i.e. basis legs are never computed from books of different ages
+
+class Conflation final {
+ public:
+  struct Counters final {
+    uint64_t updates = {};    // messages
+    uint64_t batches = {};    // MessageInfo::is_last
+    uint64_t flushes = {};    // model updates
+    uint64_t conflated = {};  // batches without a model update
+  };
+
+  explicit Conflation(std::chrono::nanoseconds threshold);
+
+  Conflation(Conflation &&) = delete;
+  Conflation(const Conflation &) = delete;
+
+  bool is_lagging() const { return lagging_; }
+
+  // a batch has been conflated since the last model update
+  bool is_pending() const { return pending_; }
+
+  const Counters &counters() const { return counters_; }
+
+  // returns true if derived models should be updated now
+  // note! now is the monotonic clock (only used at the end of a batch)
+  bool operator()(const MessageInfo &, std::chrono::nanoseconds now);
+
+  // returns true if a conflated batch should be drained now (e.g. from a timer)
+  // note! now is the monotonic clock
+  bool drain(std::chrono::nanoseconds now);
+
+ private:
+  const std::chrono::nanoseconds threshold_;
+  bool lagging_ = false;
+  bool pending_ = false;
+  std::chrono::nanoseconds last_flush_ = {};
+  Counters counters_;
+  Counters begin_;  // note! when lagging started
+};
+
+}  // namespace example_2
+}  // namespace samples
+}  // namespace roq
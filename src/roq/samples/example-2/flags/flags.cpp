@@ -5,6 +5,7 @@
 #include <absl/flags/flag.h>
 
 #include <string>
+#include <vector>
 
 ABSL_FLAG(  //
     std::string,
@@ -12,11 +13,17 @@ ABSL_FLAG(  //
     "deribit",
     "futures exchange");
 
+ABSL_FLAG(  //
+    std::vector<std::string>,
+    futures_symbols,
+    std::vector<std::string>({"BTC-PERPETUAL"}),
+    "futures symbols (comma separated, each is a leg of the basis)");
+
 ABSL_FLAG(  //
     std::string,
     futures_symbol,
-    "BTC-PERPETUAL",
-    "futures symbol");
+    "",
+    "deprecated, use --futures_symbols (a single symbol, takes precedence when set)");
 
 ABSL_FLAG(  //
     std::string,
@@ -36,6 +43,30 @@ ABSL_FLAG(  //
     0.2,
     "alpha used to compute exponential moving average");
 
+ABSL_FLAG(  //
+    uint32_t,
+    max_depth,
+    3u,
+    "depth used by the model (capped by the gateway, rounded down to 1, 3, 5, 10 or 20)");
+
+ABSL_FLAG(  //
+    uint32_t,
+    basis_window,
+    1000u,
+    "number of samples used to compute the rolling mean and standard deviation of the basis");
+
+ABSL_FLAG(  //
+    uint32_t,
+    basis_max_skew_ms,
+    100u,
+    "an update is not used if it is older than the other side by more than this (milliseconds)");
+
+ABSL_FLAG(  //
+    uint32_t,
+    conflation_threshold_ms,
+    10u,
+    "conflate model updates when lagging by more than this (milliseconds, 0 disables)");
+
 namespace roq {
 namespace samples {
 namespace example_2 {
@@ -46,6 +77,15 @@ std::string_view Flags::futures_exchange() {
   return result;
 }
 
+const std::vector<std::string_view> &Flags::futures_symbols() {
+  // note! the deprecated --futures_symbol is accepted for existing command lines
+  static const std::vector<std::string> symbols =
+      futures_symbol().empty() ? absl::GetFlag(FLAGS_futures_symbols)
+                               : std::vector<std::string>({std::string(futures_symbol())});
+  static const std::vector<std::string_view> result(symbols.begin(), symbols.end());
+  return result;
+}
+
 std::string_view Flags::futures_symbol() {
   static const std::string result = absl::GetFlag(FLAGS_futures_symbol);
   return result;
@@ -66,6 +106,26 @@ double Flags::alpha() {
   return result;
 }
 
+uint32_t Flags::max_depth() {
+  static const uint32_t result = absl::GetFlag(FLAGS_max_depth);
+  return result;
+}
+
+uint32_t Flags::basis_window() {
+  static const uint32_t result = absl::GetFlag(FLAGS_basis_window);
+  return result;
+}
+
+uint32_t Flags::basis_max_skew_ms() {
+  static const uint32_t result = absl::GetFlag(FLAGS_basis_max_skew_ms);
+  return result;
+}
+
+uint32_t Flags::conflation_threshold_ms() {
+  static const uint32_t result = absl::GetFlag(FLAGS_conflation_threshold_ms);
+  return result;
+}
+
 }  // namespace flags
 }  // namespace example_2
 }  // namespace samples
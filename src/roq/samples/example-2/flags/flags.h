@@ -2,7 +2,9 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string_view>
+#include <vector>
 
 namespace roq {
 namespace samples {
@@ -11,10 +13,15 @@ namespace flags {
 
 struct Flags final {
   static std::string_view futures_exchange();
-  static std::string_view futures_symbol();
+  static const std::vector<std::string_view> &futures_symbols();
+  static std::string_view futures_symbol();  // note! deprecated
   static std::string_view cash_exchange();
   static std::string_view cash_symbol();
   static double alpha();
+  static uint32_t max_depth();
+  static uint32_t basis_window();
+  static uint32_t basis_max_skew_ms();
+  static uint32_t conflation_threshold_ms();
 };
 
 }  // namespace flags
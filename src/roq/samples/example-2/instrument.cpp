@@ -18,8 +18,8 @@ namespace samples {
 namespace example_2 {
 
 Instrument::Instrument(const std::string_view &exchange, const std::string_view &symbol)
-    : exchange_(exchange), symbol_(symbol),
-      depth_builder_(client::DepthBuilderFactory::create(symbol, depth_)) {
+    : exchange_(exchange), symbol_(symbol) {
+  common::DepthFactory::create(depth_, common::DepthFactory::select(Flags::max_depth(), 0));
 }
 
 void Instrument::operator()(const Connected &) {
@@ -80,11 +80,20 @@ void Instrument::operator()(const GatewayStatus &gateway_status) {
   check_ready();
 }
 
+void Instrument::operator()(const GatewaySettings &gateway_settings) {
+  // specialize for the depth supported by the gateway
+  // note! gateway settings are received before market data (download)
+  auto depth = common::DepthFactory::select(Flags::max_depth(), gateway_settings.mbp_max_depth);
+  if (depth == common::DepthFactory::size(depth_))
+    return;
+  common::DepthFactory::create(depth_, depth);
+  std::visit([&](auto &value) { value.set_tick_size(tick_size_); }, depth_);
+  log::info("[{}:{}] depth={}"_fmt, exchange_, symbol_, depth);
+}
+
 void Instrument::operator()(const ReferenceData &reference_data) {
-  assert(exchange_.compare(reference_data.exchange) == 0);
-  assert(symbol_.compare(reference_data.symbol) == 0);
-  // update the depth builder
-  depth_builder_->update(reference_data);
+  // update the price ladder (requires the tick size)
+  std::visit([&](auto &depth) { depth.set_tick_size(reference_data.tick_size); }, depth_);
   // update our cache
   if (utils::update(tick_size_, reference_data.tick_size)) {
     log::info("[{}:{}] tick_size={}"_fmt, exchange_, symbol_, tick_size_);
@@ -100,8 +109,6 @@ void Instrument::operator()(const ReferenceData &reference_data) {
 }
 
 void Instrument::operator()(const MarketStatus &market_status) {
-  assert(exchange_.compare(market_status.exchange) == 0);
-  assert(symbol_.compare(market_status.symbol) == 0);
   // update our cache
   if (utils::update(trading_status_, market_status.trading_status)) {
     log::info("[{}:{}] trading_status={}"_fmt, exchange_, symbol_, trading_status_);
@@ -111,8 +118,6 @@ void Instrument::operator()(const MarketStatus &market_status) {
 }
 
 void Instrument::operator()(const MarketByPriceUpdate &market_by_price_update) {
-  assert(exchange_.compare(market_by_price_update.exchange) == 0);
-  assert(symbol_.compare(market_by_price_update.symbol) == 0);
   if (ROQ_UNLIKELY(download_))
     log::info("MarketByPriceUpdate={}"_fmt, market_by_price_update);
   // update depth
@@ -121,55 +126,53 @@ void Instrument::operator()(const MarketByPriceUpdate &market_by_price_update) {
   //   you will most likely want to use the the price to look up
   //   the relative position in an order book and then modify the
   //   liquidity.
-  //   the depth builder helps you maintain a correct view of
+  //   the price ladder helps you maintain a correct view of
   //   the order book.
-  auto depth = depth_builder_->update(market_by_price_update);
-  log::trace_1("[{}:{}] depth=[{}]"_fmt, exchange_, symbol_, roq::join(depth_, ", "_sv));
-  if (depth > 0 && is_ready())
-    update_model();
+  //   depth is zero if the top of the book didn't change.
+  //   the model is updated when the batch ends (see flush).
+  std::visit(
+      [&](auto &depth) {
+        auto levels = depth.update(market_by_price_update);
+        log::trace_1("[{}:{}] depth=[{}]"_fmt, exchange_, symbol_, roq::join(depth, ", "_sv));
+        dirty_ |= levels > 0;
+      },
+      depth_);
 }
 
 void Instrument::operator()(const MarketByOrderUpdate &market_by_order_update) {
-  assert(exchange_.compare(market_by_order_update.exchange) == 0);
-  assert(symbol_.compare(market_by_order_update.symbol) == 0);
   if (ROQ_UNLIKELY(download_))
     log::info("MarketByOrderUpdate={}"_fmt, market_by_order_update);
-  // update depth
   // note!
-  //   market by order only gives you *changes*.
-  //   you will most likely want to use the the price and order_id
-  //   to look up the relative position in an order book and then
-  //   modify the liquidity.
-  //   the depth builder helps you maintain a correct view of
-  //   the order book.
-  auto depth = depth_builder_->update(market_by_order_update);
-  log::trace_1("[{}:{}] depth=[{}]"_fmt, exchange_, symbol_, roq::join(depth_, ", "_sv));
-  if (depth > 0 && is_ready())
-    update_model();
+  //   the price ladder only supports market by price.
+  //   this strategy requires market by price (see GatewayStatus).
 }
 
-void Instrument::update_model() {
+void Instrument::flush() {
+  if (!dirty_)
+    return;
+  dirty_ = false;
+  if (is_ready())
+    std::visit([&](auto &depth) { update_model(depth); }, depth_);
+}
+
+template <typename T>
+void Instrument::update_model(const T &depth) {
   // one sided market?
-  if (utils::compare(depth_[0].bid_quantity, 0.0) == 0 ||
-      utils::compare(depth_[0].ask_quantity, 0.0) == 0)
+  if (utils::compare(depth[0].bid_quantity, 0.0) == 0 ||
+      utils::compare(depth[0].ask_quantity, 0.0) == 0)
     return;
   // validate depth
-  auto spread = depth_[0].ask_price - depth_[0].bid_price;
-  if (ROQ_UNLIKELY(utils::compare(spread, 0.0) <= 0))
+  if (ROQ_UNLIKELY(!depth.is_valid()))
     log::fatal(
         "[{}:{}] Probably something wrong: "
         "choice price or price inversion detected. "
         "depth=[{}]"_fmt,
         exchange_,
         symbol_,
-        roq::join(depth_, ", "_sv));
+        roq::join(depth, ", "_sv));
   // compute (weighted) mid
-  double sum_1 = 0.0, sum_2 = 0.0;
-  for (auto &[bid_price, bid_quantity, ask_price, ask_quantity] : depth_) {
-    sum_1 += bid_price * bid_quantity + ask_price * ask_quantity;
-    sum_2 += bid_quantity + ask_quantity;
-  }
-  mid_price_ = sum_1 / sum_2;
+  // note! O(1), the sums are maintained incrementally by the price ladder
+  mid_price_ = depth.weighted_mid();
   // update (exponential) moving average
   if (std::isnan(avg_price_))
     avg_price_ = mid_price_;  // initialize
@@ -200,7 +203,8 @@ void Instrument::reset() {
   min_trade_vol_ = NaN;
   trading_status_ = {};
   market_data_ = {};
-  depth_builder_->reset();
+  std::visit([](auto &depth) { depth.reset(); }, depth_);
+  dirty_ = false;
   mid_price_ = NaN;
   avg_price_ = NaN;
   ready_ = false;
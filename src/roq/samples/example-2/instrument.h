@@ -3,11 +3,12 @@
 #pragma once
 
 #include <limits>
-#include <memory>
 
 #include "roq/api.h"
 #include "roq/client.h"
 
+#include "roq/samples/common/depth.h"
+
 namespace roq {
 namespace samples {
 namespace example_2 {
@@ -18,31 +19,42 @@ class Instrument final {
  public:
   Instrument(const std::string_view &exchange, const std::string_view &symbol);
 
-  Instrument(Instrument &&) = default;
+  Instrument(Instrument &&) = delete;
   Instrument(const Instrument &) = delete;
 
   bool is_ready() const { return ready_; }
 
+  // weighted mid price (NaN until computed)
+  double mid_price() const { return mid_price_; }
+
+  // depth has changed since the model was last updated
+  bool is_dirty() const { return dirty_; }
+
+  // updates the model (if dirty)
+  // note! call once per batch of updates, i.e. when MessageInfo::is_last is true
+  void flush();
+
   void operator()(const Connected &);
   void operator()(const Disconnected &);
   void operator()(const DownloadBegin &);
   void operator()(const DownloadEnd &);
   void operator()(const GatewayStatus &);
+  void operator()(const GatewaySettings &);
   void operator()(const ReferenceData &);
   void operator()(const MarketStatus &);
   void operator()(const MarketByPriceUpdate &);
   void operator()(const MarketByOrderUpdate &);
 
  protected:
-  void update_model();
+  // note! specialized for the depth
+  template <typename T>
+  void update_model(const T &depth);
 
   void check_ready();
 
   void reset();
 
  private:
-  static constexpr size_t MAX_DEPTH = 2u;
-
   const std::string_view exchange_;
   const std::string_view symbol_;
   bool connected_ = false;
@@ -52,8 +64,8 @@ class Instrument final {
   double multiplier_ = NaN;
   TradingStatus trading_status_ = {};
   bool market_data_ = {};
-  std::array<Layer, MAX_DEPTH> depth_;
-  std::unique_ptr<client::DepthBuilder> depth_builder_;
+  common::DepthVariant depth_;
+  bool dirty_ = false;
   double mid_price_ = NaN;
   double avg_price_ = NaN;
   bool ready_ = false;
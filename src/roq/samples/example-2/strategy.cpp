@@ -2,15 +2,68 @@
 
 #include "roq/samples/example-2/strategy.h"
 
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+
+#include "roq/logging.h"
+
 #include "roq/samples/example-2/flags.h"
 
+using namespace roq::literals;
+
 namespace roq {
 namespace samples {
 namespace example_2 {
 
+namespace {
+// note! source is the order of the connections given on the command-line
+static const uint8_t FUTURES_SOURCE = 0;
+static const uint8_t CASH_SOURCE = 1;
+// note! conflation counters
+static const auto REPORT_INTERVAL = std::chrono::minutes{1};
+}  // namespace
+
 Strategy::Strategy(client::Dispatcher &dispatcher)
-    : dispatcher_(dispatcher), futures_(Flags::futures_exchange(), Flags::futures_symbol()),
-      cash_(Flags::cash_exchange(), Flags::cash_symbol()) {
+    : dispatcher_(dispatcher), instruments_(Flags::futures_symbols().size() + 1),
+      basis_(
+          Flags::futures_symbols().size(),
+          Flags::basis_window(),
+          Flags::alpha(),
+          std::chrono::milliseconds{Flags::basis_max_skew_ms()}),
+      conflation_(std::chrono::milliseconds{Flags::conflation_threshold_ms()}) {
+  auto size = Flags::futures_symbols().size() + 1;
+  batch_.reserve(size);
+  update_time_.resize(size);
+  // note! futures are added first, i.e. the id is also the index of the basis leg
+  for (auto &symbol : Flags::futures_symbols())
+    futures_.push_back(instruments_.emplace(
+        FUTURES_SOURCE, Flags::futures_exchange(), symbol, Flags::futures_exchange(), symbol));
+  cash_ = instruments_.emplace(
+      CASH_SOURCE,
+      Flags::cash_exchange(),
+      Flags::cash_symbol(),
+      Flags::cash_exchange(),
+      Flags::cash_symbol());
+}
+
+void Strategy::operator()(const Event<Timer> &event) {
+  // note! drains a conflated batch when no further updates arrive
+  if (conflation_.drain(event.value.now))
+    flush();
+  if (event.value.now < next_report_)
+    return;
+  if (next_report_.count() != 0) {  // initialized?
+    auto &counters = conflation_.counters();
+    log::info(
+        "conflation={{lagging={}, updates={}, batches={}, flushes={}, conflated={}}}"_fmt,
+        conflation_.is_lagging(),
+        counters.updates,
+        counters.batches,
+        counters.flushes,
+        counters.conflated);
+  }
+  next_report_ = event.value.now + REPORT_INTERVAL;
 }
 
 void Strategy::operator()(const Event<Connected> &event) {
@@ -19,6 +72,18 @@ void Strategy::operator()(const Event<Connected> &event) {
 
 void Strategy::operator()(const Event<Disconnected> &event) {
   dispatch(event);
+  // note! reset instruments are no longer dirty and must be removed from the batch
+  batch_.erase(
+      std::remove_if(
+          batch_.begin(), batch_.end(), [&](auto id) { return !instruments_[id].is_dirty(); }),
+      batch_.end());
+  // note! prices are unavailable and samples from before the disconnect must not be used
+  if (event.message_info.source == CASH_SOURCE) {
+    basis_.reset_cash();
+  } else {
+    for (auto id : futures_)
+      basis_.reset_futures(id);
+  }
 }
 
 void Strategy::operator()(const Event<DownloadBegin> &event) {
@@ -29,38 +94,110 @@ void Strategy::operator()(const Event<DownloadEnd> &event) {
   dispatch(event);
 }
 
+void Strategy::operator()(const Event<GatewaySettings> &event) {
+  dispatch(event);
+}
+
 void Strategy::operator()(const Event<GatewayStatus> &event) {
   dispatch(event);
 }
 
 void Strategy::operator()(const Event<ReferenceData> &event) {
-  dispatch(event);
+  dispatch_by_symbol(event);
 }
 
 void Strategy::operator()(const Event<MarketStatus> &event) {
-  dispatch(event);
+  dispatch_by_symbol(event);
 }
 
 void Strategy::operator()(const Event<MarketByPriceUpdate> &event) {
-  dispatch(event);
-  if (futures_.is_ready() && cash_.is_ready()) {
-    // TODO(thraneh): compute basis
+  auto &market_by_price_update = event.value;
+  auto id = instruments_.find(
+      event.message_info.source, market_by_price_update.exchange, market_by_price_update.symbol);
+  if (id != Instruments::NONE) {
+    auto &instrument = instruments_[id];
+    auto dirty = instrument.is_dirty();
+    // note! only the depth is updated
+    instrument(market_by_price_update);
+    if (instrument.is_dirty()) {
+      if (!dirty)
+        batch_.push_back(id);
+      update_time_[id] = get_time(event.message_info);
+    }
   }
+  end_of_batch(event.message_info);
 }
 
-// helper - dispatch event to the relevant instrument
+// note!
+//   the gateway may deliver a burst of updates as one batch.
+//   any event can end the batch (not only market data).
+//   batches are conflated when we're falling behind.
+void Strategy::end_of_batch(const MessageInfo &message_info) {
+  // note! the clock is only read at the end of a batch (same clock as receive_time)
+  auto now = message_info.is_last ? std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                        std::chrono::steady_clock::now().time_since_epoch())
+                                  : std::chrono::nanoseconds{};
+  if (conflation_(message_info, now))
+    flush();
+}
+
+// derived models are updated once per batch
+void Strategy::flush() {
+  for (auto id : batch_) {
+    auto &instrument = instruments_[id];
+    if (!instrument.is_dirty())  // note! reset after it was added
+      continue;
+    instrument.flush();
+    update_basis(id, update_time_[id]);
+  }
+  batch_.clear();
+}
+
+void Strategy::update_basis(Instruments::Id id, std::chrono::nanoseconds time) {
+  auto &instrument = instruments_[id];
+  auto price = instrument.is_ready() ? instrument.mid_price() : NaN;
+  auto publish = [](auto index, auto &result) {
+    log::trace_1(
+        "[{}] basis={{value={}, ema={}, mean={}, stddev={}, zscore={}}}"_fmt,
+        Flags::futures_symbols()[index],
+        result.value,
+        result.ema,
+        result.mean,
+        result.stddev,
+        result.zscore);
+  };
+  if (id == cash_) {
+    basis_.update_cash(price, time, publish);
+  } else {
+    assert(futures_[id] == id);
+    basis_.update_futures(id, price, time, publish);
+  }
+}
+
+// note! origin_create_time is zero if not provided by the gateway
+std::chrono::nanoseconds Strategy::get_time(const MessageInfo &message_info) {
+  return message_info.origin_create_time.count() != 0 ? message_info.origin_create_time
+                                                      : message_info.receive_time;
+}
+
+// helper - dispatch event to all instruments of the source
 template <typename T>
 void Strategy::dispatch(const T &event) {
-  switch (event.message_info.source) {
-    case 0u:
-      futures_(event.value);
-      break;
-    case 1u:
-      cash_(event.value);
-      break;
-    default:
-      assert(false);  // should never happen
-  }
+  instruments_.for_each(
+      event.message_info.source, [&](auto &instrument) { instrument(event.value); });
+  end_of_batch(event.message_info);
+}
+
+// helper - dispatch event to the relevant instrument
+// note! one hash probe, events for unknown instruments are dropped
+template <typename T>
+void Strategy::dispatch_by_symbol(const T &event) {
+  auto &value = event.value;
+  instruments_.dispatch(
+      event.message_info.source, value.exchange, value.symbol, [&](auto &instrument) {
+        instrument(value);
+      });
+  end_of_batch(event.message_info);
 }
 
 }  // namespace example_2
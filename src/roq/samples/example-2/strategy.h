@@ -2,9 +2,16 @@
 
 #pragma once
 
+#include <chrono>
+#include <vector>
+
 #include "roq/api.h"
 #include "roq/client.h"
 
+#include "roq/samples/common/instrument_registry.h"
+
+#include "roq/samples/example-2/basis.h"
+#include "roq/samples/example-2/conflation.h"
 #include "roq/samples/example-2/instrument.h"
 
 namespace roq {
@@ -17,27 +24,51 @@ class Strategy final : public client::Handler {
  public:
   explicit Strategy(client::Dispatcher &);
 
-  Strategy(Strategy &&) = default;
+  Strategy(Strategy &&) = delete;
   Strategy(const Strategy &) = delete;
 
  protected:
+  void operator()(const Event<Timer> &) override;
   void operator()(const Event<Connected> &) override;
   void operator()(const Event<Disconnected> &) override;
   void operator()(const Event<DownloadBegin> &) override;
   void operator()(const Event<DownloadEnd> &) override;
+  void operator()(const Event<GatewaySettings> &) override;
   void operator()(const Event<GatewayStatus> &) override;
   void operator()(const Event<ReferenceData> &) override;
   void operator()(const Event<MarketStatus> &) override;
   void operator()(const Event<MarketByPriceUpdate> &) override;
 
-  // helper - dispatch event to the relevant instrument
+  // helper - dispatch event to all instruments of the source
   template <typename T>
   void dispatch(const T &event);
 
+  // helper - dispatch event to the relevant instrument
+  template <typename T>
+  void dispatch_by_symbol(const T &event);
+
+  using Instruments = common::InstrumentRegistry<Instrument>;
+
+  // note! derived models are updated when the batch ends (MessageInfo::is_last)
+  void end_of_batch(const MessageInfo &);
+
+  void flush();
+
+  void update_basis(Instruments::Id, std::chrono::nanoseconds time);
+
+  static std::chrono::nanoseconds get_time(const MessageInfo &);
+
  private:
   client::Dispatcher &dispatcher_;
-  Instrument futures_;
-  Instrument cash_;
+  Instruments instruments_;
+  std::vector<Instruments::Id> futures_;
+  Instruments::Id cash_ = Instruments::NONE;
+  Basis basis_;
+  Conflation conflation_;
+  // note! instruments with a dirty model (current batch)
+  std::vector<Instruments::Id> batch_;
+  std::vector<std::chrono::nanoseconds> update_time_;
+  std::chrono::nanoseconds next_report_ = {};
 };
 
 }  // namespace example_2
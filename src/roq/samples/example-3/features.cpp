@@ -0,0 +1,267 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#include "roq/samples/example-3/features.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include "roq/exceptions.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+using namespace roq::literals;
+
+namespace roq {
+namespace samples {
+namespace example_3 {
+
+namespace {
+using Output = Features::Output;
+using Input = Features::Input;
+
+struct Arguments final {
+  double *data;
+  size_t stride;  // note! doubles per column
+  size_t depth;
+  double alpha;
+  size_t count;  // note! multiple of Features::LANES
+
+  double *column(Output output) const { return data + output * stride; }
+
+  double *column(Input input, size_t level) const {
+    return data + (Features::OUTPUTS + level * Features::INPUTS + input) * stride;
+  }
+};
+
+double ema(double previous, double value, double alpha) {
+  return std::isnan(previous) ? value : alpha * value + (1.0 - alpha) * previous;
+}
+
+void compute_scalar(const Arguments &args) {
+  for (size_t i = 0; i < args.count; ++i) {
+    double bid_notional = 0.0, bid_quantity = 0.0, ask_notional = 0.0, ask_quantity = 0.0;
+    for (size_t level = 0; level < args.depth; ++level) {
+      auto bid_price = args.column(Input::BID_PRICE, level)[i];
+      auto bid_size = args.column(Input::BID_QUANTITY, level)[i];
+      auto ask_price = args.column(Input::ASK_PRICE, level)[i];
+      auto ask_size = args.column(Input::ASK_QUANTITY, level)[i];
+      bid_notional += bid_price * bid_size;
+      bid_quantity += bid_size;
+      ask_notional += ask_price * ask_size;
+      ask_quantity += ask_size;
+    }
+    auto weighted_bid = bid_notional / bid_quantity;
+    auto weighted_ask = ask_notional / ask_quantity;
+    args.column(Output::WEIGHTED_BID)[i] = weighted_bid;
+    args.column(Output::WEIGHTED_ASK)[i] = weighted_ask;
+    args.column(Output::SPREAD)[i] =
+        args.column(Input::ASK_PRICE, 0)[i] - args.column(Input::BID_PRICE, 0)[i];
+    args.column(Output::IMBALANCE)[i] =
+        (bid_quantity - ask_quantity) / (bid_quantity + ask_quantity);
+    auto &bid_ema = args.column(Output::BID_EMA)[i];
+    bid_ema = ema(bid_ema, weighted_bid, args.alpha);
+    auto &ask_ema = args.column(Output::ASK_EMA)[i];
+    ask_ema = ema(ask_ema, weighted_ask, args.alpha);
+  }
+}
+
+#if defined(__x86_64__)
+
+// note! same computation as compute_scalar, 4 instruments per instruction
+
+__attribute__((target("avx2"))) inline __m256d ema_avx2(
+    __m256d previous, __m256d value, __m256d alpha, __m256d beta) {
+  auto result = _mm256_add_pd(_mm256_mul_pd(alpha, value), _mm256_mul_pd(beta, previous));
+  auto initialize = _mm256_cmp_pd(previous, previous, _CMP_UNORD_Q);  // note! NaN
+  return _mm256_blendv_pd(result, value, initialize);
+}
+
+__attribute__((target("avx2"))) void compute_avx2(const Arguments &args) {
+  auto alpha = _mm256_set1_pd(args.alpha);
+  auto beta = _mm256_set1_pd(1.0 - args.alpha);
+  for (size_t i = 0; i < args.count; i += 4) {
+    auto bid_notional = _mm256_setzero_pd(), bid_quantity = _mm256_setzero_pd();
+    auto ask_notional = _mm256_setzero_pd(), ask_quantity = _mm256_setzero_pd();
+    for (size_t level = 0; level < args.depth; ++level) {
+      auto bid_price = _mm256_load_pd(args.column(Input::BID_PRICE, level) + i);
+      auto bid_size = _mm256_load_pd(args.column(Input::BID_QUANTITY, level) + i);
+      auto ask_price = _mm256_load_pd(args.column(Input::ASK_PRICE, level) + i);
+      auto ask_size = _mm256_load_pd(args.column(Input::ASK_QUANTITY, level) + i);
+      bid_notional = _mm256_add_pd(bid_notional, _mm256_mul_pd(bid_price, bid_size));
+      bid_quantity = _mm256_add_pd(bid_quantity, bid_size);
+      ask_notional = _mm256_add_pd(ask_notional, _mm256_mul_pd(ask_price, ask_size));
+      ask_quantity = _mm256_add_pd(ask_quantity, ask_size);
+    }
+    auto weighted_bid = _mm256_div_pd(bid_notional, bid_quantity);
+    auto weighted_ask = _mm256_div_pd(ask_notional, ask_quantity);
+    _mm256_store_pd(args.column(Output::WEIGHTED_BID) + i, weighted_bid);
+    _mm256_store_pd(args.column(Output::WEIGHTED_ASK) + i, weighted_ask);
+    auto spread = _mm256_sub_pd(
+        _mm256_load_pd(args.column(Input::ASK_PRICE, 0) + i),
+        _mm256_load_pd(args.column(Input::BID_PRICE, 0) + i));
+    _mm256_store_pd(args.column(Output::SPREAD) + i, spread);
+    auto imbalance = _mm256_div_pd(
+        _mm256_sub_pd(bid_quantity, ask_quantity), _mm256_add_pd(bid_quantity, ask_quantity));
+    _mm256_store_pd(args.column(Output::IMBALANCE) + i, imbalance);
+    auto bid_ema = args.column(Output::BID_EMA) + i;
+    _mm256_store_pd(bid_ema, ema_avx2(_mm256_load_pd(bid_ema), weighted_bid, alpha, beta));
+    auto ask_ema = args.column(Output::ASK_EMA) + i;
+    _mm256_store_pd(ask_ema, ema_avx2(_mm256_load_pd(ask_ema), weighted_ask, alpha, beta));
+  }
+}
+
+// note! same computation as compute_scalar, 8 instruments per instruction
+
+__attribute__((target("avx512f"))) inline __m512d ema_avx512(
+    __m512d previous, __m512d value, __m512d alpha, __m512d beta) {
+  auto result = _mm512_add_pd(_mm512_mul_pd(alpha, value), _mm512_mul_pd(beta, previous));
+  auto initialize = _mm512_cmp_pd_mask(previous, previous, _CMP_UNORD_Q);  // note! NaN
+  return _mm512_mask_blend_pd(initialize, result, value);
+}
+
+__attribute__((target("avx512f"))) void compute_avx512(const Arguments &args) {
+  auto alpha = _mm512_set1_pd(args.alpha);
+  auto beta = _mm512_set1_pd(1.0 - args.alpha);
+  for (size_t i = 0; i < args.count; i += 8) {
+    auto bid_notional = _mm512_setzero_pd(), bid_quantity = _mm512_setzero_pd();
+    auto ask_notional = _mm512_setzero_pd(), ask_quantity = _mm512_setzero_pd();
+    for (size_t level = 0; level < args.depth; ++level) {
+      auto bid_price = _mm512_load_pd(args.column(Input::BID_PRICE, level) + i);
+      auto bid_size = _mm512_load_pd(args.column(Input::BID_QUANTITY, level) + i);
+      auto ask_price = _mm512_load_pd(args.column(Input::ASK_PRICE, level) + i);
+      auto ask_size = _mm512_load_pd(args.column(Input::ASK_QUANTITY, level) + i);
+      bid_notional = _mm512_add_pd(bid_notional, _mm512_mul_pd(bid_price, bid_size));
+      bid_quantity = _mm512_add_pd(bid_quantity, bid_size);
+      ask_notional = _mm512_add_pd(ask_notional, _mm512_mul_pd(ask_price, ask_size));
+      ask_quantity = _mm512_add_pd(ask_quantity, ask_size);
+    }
+    auto weighted_bid = _mm512_div_pd(bid_notional, bid_quantity);
+    auto weighted_ask = _mm512_div_pd(ask_notional, ask_quantity);
+    _mm512_store_pd(args.column(Output::WEIGHTED_BID) + i, weighted_bid);
+    _mm512_store_pd(args.column(Output::WEIGHTED_ASK) + i, weighted_ask);
+    auto spread = _mm512_sub_pd(
+        _mm512_load_pd(args.column(Input::ASK_PRICE, 0) + i),
+        _mm512_load_pd(args.column(Input::BID_PRICE, 0) + i));
+    _mm512_store_pd(args.column(Output::SPREAD) + i, spread);
+    auto imbalance = _mm512_div_pd(
+        _mm512_sub_pd(bid_quantity, ask_quantity), _mm512_add_pd(bid_quantity, ask_quantity));
+    _mm512_store_pd(args.column(Output::IMBALANCE) + i, imbalance);
+    auto bid_ema = args.column(Output::BID_EMA) + i;
+    _mm512_store_pd(bid_ema, ema_avx512(_mm512_load_pd(bid_ema), weighted_bid, alpha, beta));
+    auto ask_ema = args.column(Output::ASK_EMA) + i;
+    _mm512_store_pd(ask_ema, ema_avx512(_mm512_load_pd(ask_ema), weighted_ask, alpha, beta));
+  }
+}
+
+#endif
+
+using compute_type = void (*)(const Arguments &);
+
+struct Implementation final {
+  compute_type compute;
+  std::string_view name;
+};
+
+// note! best first
+std::vector<Implementation> select_implementations() {
+  std::vector<Implementation> result;
+#if defined(__x86_64__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f"))
+    result.push_back({compute_avx512, "avx512"_sv});
+  if (__builtin_cpu_supports("avx2"))
+    result.push_back({compute_avx2, "avx2"_sv});
+#endif
+  result.push_back({compute_scalar, "scalar"_sv});
+  return result;
+}
+
+const std::vector<Implementation> &get_implementations() {
+  static const auto result = select_implementations();
+  return result;
+}
+
+const Implementation &get_implementation() {
+  static const auto &result = get_implementations().front();
+  return result;
+}
+}  // namespace
+
+Features::Features(size_t capacity, size_t depth, double alpha)
+    : capacity_(capacity), depth_(depth), alpha_(alpha), stride_((capacity + LANES - 1) / LANES),
+      blocks_((OUTPUTS + depth * INPUTS) * stride_, Block{}) {
+  assert(depth > 0);
+  for (size_t i = 0; i < capacity_; ++i)
+    reset(i);
+}
+
+std::string_view Features::implementation() {
+  return get_implementation().name;
+}
+
+std::vector<std::string_view> Features::implementations() {
+  std::vector<std::string_view> result;
+  for (auto &implementation : get_implementations())
+    result.push_back(implementation.name);
+  return result;
+}
+
+void Features::set(size_t index, const roq::span<const Layer> &layers) {
+  assert(index < capacity_);
+  for (size_t level = 0; level < depth_; ++level) {
+    auto layer = level < layers.size() ? layers[level] : Layer{};
+    column(BID_PRICE, level)[index] = layer.bid_price;
+    column(BID_QUANTITY, level)[index] = layer.bid_quantity;
+    column(ASK_PRICE, level)[index] = layer.ask_price;
+    column(ASK_QUANTITY, level)[index] = layer.ask_quantity;
+  }
+}
+
+void Features::update() {
+  (*get_implementation().compute)({
+      .data = data(),
+      .stride = stride_ * LANES,
+      .depth = depth_,
+      .alpha = alpha_,
+      .count = stride_ * LANES,
+  });
+}
+
+void Features::update_scalar() {
+  compute_scalar({
+      .data = data(),
+      .stride = stride_ * LANES,
+      .depth = depth_,
+      .alpha = alpha_,
+      .count = stride_ * LANES,
+  });
+}
+
+void Features::update(const std::string_view &name) {
+  for (auto &implementation : get_implementations()) {
+    if (implementation.name != name)
+      continue;
+    (*implementation.compute)({
+        .data = data(),
+        .stride = stride_ * LANES,
+        .depth = depth_,
+        .alpha = alpha_,
+        .count = stride_ * LANES,
+    });
+    return;
+  }
+  throw RuntimeErrorException(R"(Unexpected: implementation="{}" is not supported)"_fmt, name);
+}
+
+void Features::reset(size_t index) {
+  assert(index < capacity_);
+  column(BID_EMA)[index] = NaN;
+  column(ASK_EMA)[index] = NaN;
+}
+
+}  // namespace example_3
+}  // namespace samples
+}  // namespace roq
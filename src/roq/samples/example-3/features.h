@@ -0,0 +1,128 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+#include "roq/api.h"
+
+#include "roq/samples/common/depth.h"
+
+namespace roq {
+namespace samples {
+namespace example_3 {
+
+// model features computed for many instruments at once
+//
+// depth is stored as structure-of-arrays: one column per (field, level),
+// each column holding the value for all instruments, i.e. a vector register
+// loads the same field for consecutive instruments
+//
+// for each instrument (index)
+// * weighted bid and ask (sum(price * quantity) / sum(quantity))
+// * spread (top of book)
+// * imbalance ((bid - ask) / (bid + ask) using sum(quantity))
+// * exponential moving average of the weighted bid and ask
+//
+// the implementation (avx512, avx2 or scalar) is selected at runtime
+// depending on what the cpu supports
+//
+// note!
+//   columns are cache-aligned and padded to a multiple of 8 instruments (no
+//   tail handling), unused instruments compute NaN
+//   an ema is (re-)initialized from the first non-NaN value
+
+class Features final {
+ public:
+  Features(size_t capacity, size_t depth, double alpha);
+
+  Features(Features &&) = delete;
+  Features(const Features &) = delete;
+
+  size_t capacity() const { return capacity_; }
+
+  size_t depth() const { return depth_; }
+
+  // name of the implementation used by update()
+  static std::string_view implementation();
+
+  // names of the implementations supported by the cpu (best first)
+  static std::vector<std::string_view> implementations();
+
+  // note! levels beyond depth() are ignored, missing levels are empty
+  void set(size_t index, const roq::span<const Layer> &layers);
+
+  template <size_t N>
+  void set(size_t index, const common::Depth<N> &depth) {
+    set(index, {&depth[0], N});
+  }
+
+  // all instruments (uses the best implementation supported by the cpu)
+  void update();
+
+  // all instruments (reference implementation, for verification)
+  void update_scalar();
+
+  // all instruments (named implementation, for verification)
+  // note! throws if the implementation is not supported by the cpu
+  void update(const std::string_view &implementation);
+
+  // note! ema is reset to NaN
+  void reset(size_t index);
+
+  double weighted_bid(size_t index) const { return column(WEIGHTED_BID)[index]; }
+  double weighted_ask(size_t index) const { return column(WEIGHTED_ASK)[index]; }
+  double spread(size_t index) const { return column(SPREAD)[index]; }
+  double imbalance(size_t index) const { return column(IMBALANCE)[index]; }
+  double bid_ema(size_t index) const { return column(BID_EMA)[index]; }
+  double ask_ema(size_t index) const { return column(ASK_EMA)[index]; }
+
+  // layout (exposed for the kernels)
+  enum Output : size_t {
+    WEIGHTED_BID = 0,
+    WEIGHTED_ASK,
+    SPREAD,
+    IMBALANCE,
+    BID_EMA,
+    ASK_EMA,
+    OUTPUTS,
+  };
+
+  enum Input : size_t {
+    BID_PRICE = 0,
+    BID_QUANTITY,
+    ASK_PRICE,
+    ASK_QUANTITY,
+    INPUTS,
+  };
+
+  struct alignas(64) Block final {
+    double values[8];
+  };
+
+  static constexpr size_t LANES = sizeof(Block) / sizeof(double);
+
+ protected:
+  double *data() { return reinterpret_cast<double *>(blocks_.data()); }
+  const double *data() const { return reinterpret_cast<const double *>(blocks_.data()); }
+
+  double *column(Input input, size_t level) {
+    return data() + (OUTPUTS + level * INPUTS + input) * stride_ * LANES;
+  }
+
+  double *column(Output output) { return data() + output * stride_ * LANES; }
+  const double *column(Output output) const { return data() + output * stride_ * LANES; }
+
+ private:
+  const size_t capacity_;
+  const size_t depth_;
+  const double alpha_;
+  const size_t stride_;  // note! blocks per column
+  std::vector<Block> blocks_;
+};
+
+}  // namespace example_3
+}  // namespace samples
+}  // namespace roq
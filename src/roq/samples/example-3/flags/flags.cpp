@@ -50,6 +50,18 @@ ABSL_FLAG(  //
     120u,
     "warmup (number of samples before a signal is generated)");
 
+ABSL_FLAG(  //
+    uint32_t,
+    max_depth,
+    3u,
+    "depth used by the model (capped by the gateway, rounded down to 1, 3, 5, 10 or 20)");
+
+ABSL_FLAG(  //
+    bool,
+    market_by_order,
+    false,
+    "maintain depth from market by order (full order book)");
+
 ABSL_FLAG(  //
     bool,
     enable_trading,
@@ -102,6 +114,16 @@ uint32_t Flags::warmup() {
   return result;
 }
 
+uint32_t Flags::max_depth() {
+  static const uint32_t result = absl::GetFlag(FLAGS_max_depth);
+  return result;
+}
+
+bool Flags::market_by_order() {
+  static const bool result = absl::GetFlag(FLAGS_market_by_order);
+  return result;
+}
+
 bool Flags::enable_trading() {
   static const bool result = absl::GetFlag(FLAGS_enable_trading);
   return result;
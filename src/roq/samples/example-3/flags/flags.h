@@ -17,6 +17,8 @@ struct Flags final {
   static uint32_t sample_freq_secs();
   static double ema_alpha();
   static uint32_t warmup();
+  static uint32_t max_depth();
+  static bool market_by_order();
   static bool enable_trading();
   static bool simulation();
 };
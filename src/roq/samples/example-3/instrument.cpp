@@ -3,6 +3,7 @@
 #include "roq/samples/example-3/instrument.h"
 
 #include <algorithm>
+#include <cmath>
 
 #include "roq/client.h"
 #include "roq/logging.h"
@@ -11,6 +12,8 @@
 #include "roq/utils/mask.h"
 #include "roq/utils/update.h"
 
+#include "roq/samples/example-3/flags.h"
+
 using namespace roq::literals;
 
 namespace roq {
@@ -21,8 +24,8 @@ Instrument::Instrument(
     const std::string_view &exchange,
     const std::string_view &symbol,
     const std::string_view &account)
-    : exchange_(exchange), symbol_(symbol), account_(account),
-      depth_builder_(client::DepthBuilderFactory::create(symbol, depth_)) {
+    : exchange_(exchange), symbol_(symbol), account_(account) {
+  common::DepthFactory::create(depth_, common::DepthFactory::select(Flags::max_depth(), 0));
 }
 
 double Instrument::position() const {
@@ -84,7 +87,7 @@ void Instrument::operator()(const GatewayStatus &gateway_status) {
     static const utils::Mask<SupportType> required{
         SupportType::REFERENCE_DATA,
         SupportType::MARKET_STATUS,
-        SupportType::MARKET_BY_PRICE,
+        Flags::market_by_order() ? SupportType::MARKET_BY_ORDER : SupportType::MARKET_BY_PRICE,
     };
     // readiness defined by full availability of all required message types
     auto market_data = available.has_all(required) && unavailable.has_none(required);
@@ -117,11 +120,21 @@ void Instrument::operator()(const GatewayStatus &gateway_status) {
   check_ready();
 }
 
+void Instrument::operator()(const GatewaySettings &gateway_settings) {
+  // specialize for the depth supported by the gateway
+  // note! gateway settings are received before market data (download)
+  auto depth = common::DepthFactory::select(Flags::max_depth(), gateway_settings.mbp_max_depth);
+  if (depth == common::DepthFactory::size(depth_))
+    return;
+  common::DepthFactory::create(depth_, depth);
+  std::visit([&](auto &value) { value.set_tick_size(tick_size_); }, depth_);
+  log::info("[{}:{}] depth={}"_fmt, exchange_, symbol_, depth);
+}
+
 void Instrument::operator()(const ReferenceData &reference_data) {
-  assert(exchange_.compare(reference_data.exchange) == 0);
-  assert(symbol_.compare(reference_data.symbol) == 0);
-  // update the depth builder
-  depth_builder_->update(reference_data);
+  // update the price ladder and the order book (requires the tick size)
+  std::visit([&](auto &depth) { depth.set_tick_size(reference_data.tick_size); }, depth_);
+  order_book_(reference_data);
   // update our cache
   if (utils::update(tick_size_, reference_data.tick_size)) {
     log::info("[{}:{}] tick_size={}"_fmt, exchange_, symbol_, tick_size_);
@@ -137,8 +150,6 @@ void Instrument::operator()(const ReferenceData &reference_data) {
 }
 
 void Instrument::operator()(const MarketStatus &market_status) {
-  assert(exchange_.compare(market_status.exchange) == 0);
-  assert(symbol_.compare(market_status.symbol) == 0);
   // update our cache
   if (utils::update(trading_status_, market_status.trading_status)) {
     log::info("[{}:{}] trading_status={}"_fmt, exchange_, symbol_, trading_status_);
@@ -148,45 +159,58 @@ void Instrument::operator()(const MarketStatus &market_status) {
 }
 
 void Instrument::operator()(const MarketByPriceUpdate &market_by_price_update) {
-  assert(exchange_.compare(market_by_price_update.exchange) == 0);
-  assert(symbol_.compare(market_by_price_update.symbol) == 0);
   if (ROQ_UNLIKELY(download_))
     log::info("MarketByPriceUpdate={}"_fmt, market_by_price_update);
+  if (Flags::market_by_order())  // note! depth is maintained from market by order
+    return;
   // update depth
   // note!
   //   market by price only gives you *changes*.
   //   you will most likely want to use the the price to look up
   //   the relative position in an order book and then modify the
   //   liquidity.
-  //   the depth builder helps you maintain a correct view of
+  //   the price ladder helps you maintain a correct view of
   //   the order book.
-  depth_builder_->update(market_by_price_update);
-  log::trace_1("[{}:{}] depth=[{}]"_fmt, exchange_, symbol_, roq::join(depth_, ", "_sv));
-  validate(depth_);
+  //   depth is zero if the top of the book didn't change.
+  std::visit(
+      [&](auto &depth) {
+        if (depth.update(market_by_price_update) == 0)
+          return;
+        log::trace_1("[{}:{}] depth=[{}]"_fmt, exchange_, symbol_, roq::join(depth, ", "_sv));
+        validate(depth);
+        if (!std::isnan(tick_size_))  // note! prices are stored as ticks
+          history_.append(depth, tick_size_, market_by_price_update.exchange_time_utc);
+      },
+      depth_);
 }
 
 void Instrument::operator()(const MarketByOrderUpdate &market_by_order_update) {
-  assert(exchange_.compare(market_by_order_update.exchange) == 0);
-  assert(symbol_.compare(market_by_order_update.symbol) == 0);
   if (ROQ_UNLIKELY(download_))
     log::info("MarketByOrderUpdate={}"_fmt, market_by_order_update);
+  if (!Flags::market_by_order())  // note! depth is maintained from market by price
+    return;
   // update depth
   // note!
   //   market by order only gives you *changes*.
   //   you will most likely want to use the the price and order_id
   //   to look up the relative position in an order book and then
   //   modify the liquidity.
-  //   the depth builder helps you maintain a correct view of
-  //   the order book.
-  /*
-  depth_builder_->update(market_by_order_update);
-  log::trace_1(
-      "[{}:{}] depth=[{}]"_fmt,
-      exchange_,
-      symbol_,
-      roq::join(depth_, ", "_sv));
-  validate(depth_);
-  */
+  //   the order book keeps track of all orders and translates
+  //   each update to aggregated price levels (market by price).
+  std::visit(
+      [&](auto &depth) {
+        size_t levels = 0;
+        order_book_(market_by_order_update, [&](auto &market_by_price_update) {
+          levels = depth.update(market_by_price_update);
+        });
+        if (levels == 0)
+          return;
+        log::trace_1("[{}:{}] depth=[{}]"_fmt, exchange_, symbol_, roq::join(depth, ", "_sv));
+        validate(depth);
+        if (!std::isnan(tick_size_))  // note! prices are stored as ticks
+          history_.append(depth, tick_size_, market_by_order_update.exchange_time_utc);
+      },
+      depth_);
 }
 
 void Instrument::operator()(const OrderUpdate &order_update) {
@@ -258,7 +282,9 @@ void Instrument::reset() {
   trading_status_ = {};
   market_data_ = false;
   order_management_ = false;
-  depth_builder_->reset();
+  std::visit([](auto &depth) { depth.reset(); }, depth_);
+  order_book_.reset();
+  history_.clear();
   long_position_ = {};
   short_position_ = {};
   ready_ = false;
@@ -266,12 +292,9 @@ void Instrument::reset() {
   last_traded_quantity_ = {};
 }
 
-void Instrument::validate(const Depth &depth) {
-  if (utils::compare(depth[0].bid_quantity, 0.0) <= 0 ||
-      utils::compare(depth[0].ask_quantity, 0.0) <= 0)
-    return;
-  auto spread = depth[0].ask_price - depth[0].bid_price;
-  if (ROQ_UNLIKELY(utils::compare(spread, 0.0) <= 0))
+template <typename T>
+void Instrument::validate(const T &depth) {
+  if (ROQ_UNLIKELY(!depth.is_valid()))
     log::fatal(
         "[{}:{}] Probably something wrong: "
         "choice price or price inversion detected. "
@@ -2,13 +2,16 @@
 
 #pragma once
 
-#include <array>
 #include <limits>
-#include <memory>
+#include <utility>
+#include <variant>
 
 #include "roq/api.h"
 
-#include "roq/client/depth_builder.h"
+#include "roq/samples/common/depth.h"
+#include "roq/samples/common/depth_history.h"
+
+#include "roq/samples/example-3/order_book.h"
 
 namespace roq {
 namespace samples {
@@ -16,20 +19,14 @@ namespace example_3 {
 
 class Instrument final {
  public:
-  static const constexpr size_t MAX_DEPTH = 3u;
-
-  using Depth = std::array<Layer, MAX_DEPTH>;
-
   Instrument(
       const std::string_view &exchange,
       const std::string_view &symbol,
       const std::string_view &account);
 
-  Instrument(Instrument &&) = default;
+  Instrument(Instrument &&) = delete;
   Instrument(const Instrument &) = delete;
 
-  operator const Depth &() const { return depth_; }
-
   bool is_ready() const { return ready_; }
 
   auto tick_size() const { return tick_size_; }
@@ -40,9 +37,22 @@ class Instrument final {
 
   auto is_market_open() const { return trading_status_ == TradingStatus::OPEN; }
 
-  auto best_bid() const { return depth_[0].bid_price; }
+  auto best_bid() const {
+    return std::visit([](auto &depth) { return depth[0].bid_price; }, depth_);
+  }
+
+  auto best_ask() const {
+    return std::visit([](auto &depth) { return depth[0].ask_price; }, depth_);
+  }
+
+  // note! the callback receives the depth (specialized for the number of levels)
+  template <typename F>
+  decltype(auto) visit(F &&f) const {
+    return std::visit(std::forward<F>(f), depth_);
+  }
 
-  auto best_ask() const { return depth_[0].ask_price; }
+  // note! recent depth, age 0 is the latest
+  const auto &history() const { return history_; }
 
   double position() const;
 
@@ -53,6 +63,7 @@ class Instrument final {
   void operator()(const DownloadBegin &);
   void operator()(const DownloadEnd &);
   void operator()(const GatewayStatus &);
+  void operator()(const GatewaySettings &);
   void operator()(const ReferenceData &);
   void operator()(const MarketStatus &);
   void operator()(const MarketByPriceUpdate &);
@@ -65,7 +76,8 @@ class Instrument final {
 
   void reset();
 
-  void validate(const Depth &);
+  template <typename T>
+  void validate(const T &depth);
 
  private:
   const std::string_view exchange_;
@@ -79,8 +91,9 @@ class Instrument final {
   TradingStatus trading_status_ = {};
   bool market_data_ = {};
   bool order_management_ = {};
-  Depth depth_;
-  std::unique_ptr<client::DepthBuilder> depth_builder_;
+  common::DepthVariant depth_;
+  common::DepthHistory<> history_;
+  OrderBook order_book_;
   double long_position_ = {};
   double short_position_ = {};
   bool ready_ = false;
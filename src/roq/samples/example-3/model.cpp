@@ -2,12 +2,8 @@
 
 #include "roq/samples/example-3/model.h"
 
-#include <numeric>
-
 #include "roq/logging.h"
 
-#include "roq/utils/compare.h"
-
 #include "roq/samples/example-3/flags.h"
 
 using namespace roq::literals;
@@ -26,15 +22,17 @@ void Model::reset() {
   buying_ = false;
 }
 
-Side Model::update(const Depth &depth) {
+template <size_t N>
+Side Model::update(const common::Depth<N> &depth) {
   auto result = Side::UNDEFINED;
 
   if (!validate(depth))
     return result;
 
-  auto bid_fast = weighted_bid(depth);
+  // note! O(1), maintained incrementally by the price ladder
+  auto bid_fast = depth.weighted_bid();
   auto bid_slow = bid_ema_.update(bid_fast);
-  auto ask_fast = weighted_ask(depth);
+  auto ask_fast = depth.weighted_ask();
   auto ask_slow = ask_ema_.update(ask_fast);
 
   auto ready = bid_ema_.is_ready() && ask_ema_.is_ready();
@@ -93,30 +91,16 @@ Side Model::update(const Depth &depth) {
   return result;
 }
 
-bool Model::validate(const Depth &depth) {  // require full depth
-  return std::accumulate(depth.begin(), depth.end(), true, [](bool value, const Layer &layer) {
-    return value && utils::compare(layer.bid_quantity, 0.0) > 0 &&
-           utils::compare(layer.ask_quantity, 0.0) > 0;
-  });
+template <size_t N>
+bool Model::validate(const common::Depth<N> &depth) {  // require full depth
+  return depth.is_full();
 }
 
-double Model::weighted_bid(const Depth &depth) {
-  double sum_1 = 0.0, sum_2 = 0.0;
-  std::for_each(depth.begin(), depth.end(), [&](const Layer &layer) {
-    sum_1 += layer.bid_quantity * layer.bid_price;
-    sum_2 += layer.bid_quantity;
-  });
-  return sum_1 / sum_2;
-}
-
-double Model::weighted_ask(const Depth &depth) {
-  double sum_1 = 0.0, sum_2 = 0.0;
-  std::for_each(depth.begin(), depth.end(), [&](const Layer &layer) {
-    sum_1 += layer.ask_quantity * layer.ask_price;
-    sum_2 += layer.ask_quantity;
-  });
-  return sum_1 / sum_2;
-}
+template Side Model::update(const common::Depth<1> &);
+template Side Model::update(const common::Depth<3> &);
+template Side Model::update(const common::Depth<5> &);
+template Side Model::update(const common::Depth<10> &);
+template Side Model::update(const common::Depth<20> &);
 
 }  // namespace example_3
 }  // namespace samples
@@ -2,10 +2,10 @@
 
 #pragma once
 
-#include <array>
-
 #include "roq/api.h"
 
+#include "roq/samples/common/depth.h"
+
 #include "roq/samples/example-3/ema.h"
 
 namespace roq {
@@ -14,10 +14,6 @@ namespace example_3 {
 
 class Model final {
  public:
-  static const constexpr size_t MAX_DEPTH = 3u;
-
-  using Depth = std::array<Layer, MAX_DEPTH>;
-
   Model();
 
   Model(Model &&) = default;
@@ -25,13 +21,13 @@ class Model final {
 
   void reset();
 
-  Side update(const Depth &);
+  // note! specialized for the depth (instantiated for all common::DepthVariant)
+  template <size_t N>
+  Side update(const common::Depth<N> &);
 
  protected:
-  bool validate(const Depth &);
-
-  double weighted_bid(const Depth &);
-  double weighted_ask(const Depth &);
+  template <size_t N>
+  bool validate(const common::Depth<N> &);
 
  private:
   EMA bid_ema_;
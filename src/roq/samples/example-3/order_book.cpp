@@ -0,0 +1,259 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#include "roq/samples/example-3/order_book.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <utility>
+
+#include "roq/exceptions.h"
+
+using namespace roq::literals;
+
+namespace roq {
+namespace samples {
+namespace example_3 {
+
+namespace {
+static const size_t MIN_TABLE_SIZE = 16;
+
+// note! level keys are small integers, the low bits must be mixed
+static uint64_t mix(int64_t key) {
+  auto result = static_cast<uint64_t>(key);
+  result ^= result >> 33;
+  result *= 0xff51afd7ed558ccdull;
+  result ^= result >> 33;
+  return result;
+}
+
+static uint64_t hash_order_id(const std::string_view &order_id) {
+  return std::hash<std::string_view>()(order_id);
+}
+
+static size_t round_up(size_t value) {
+  size_t result = MIN_TABLE_SIZE;
+  while (result < value)
+    result <<= 1;
+  return result;
+}
+}  // namespace
+
+// === TABLE ===
+
+OrderBook::Table::Table(size_t capacity) {
+  rehash(round_up(2 * capacity));  // note! load factor <= 0.5
+}
+
+void OrderBook::Table::clear() {
+  if (size_ == 0)
+    return;
+  std::fill(slots_.begin(), slots_.end(), Slot{.hash = {}, .index = NONE});
+  size_ = {};
+}
+
+void OrderBook::Table::insert(uint64_t hash, Index index) {
+  if (ROQ_UNLIKELY(2 * (size_ + 1) > slots_.size()))
+    rehash(2 * slots_.size());
+  auto i = hash & mask_;
+  while (slots_[i].index != NONE)
+    i = (i + 1) & mask_;
+  slots_[i] = {.hash = hash, .index = index};
+  ++size_;
+}
+
+void OrderBook::Table::erase(uint64_t hash, Index index) {
+  auto i = hash & mask_;
+  while (slots_[i].index != index) {
+    assert(slots_[i].index != NONE);
+    i = (i + 1) & mask_;
+  }
+  // note! shift back entries which would otherwise become unreachable
+  for (auto j = (i + 1) & mask_; slots_[j].index != NONE; j = (j + 1) & mask_) {
+    auto home = slots_[j].hash & mask_;
+    if (((j - home) & mask_) >= ((j - i) & mask_)) {
+      slots_[i] = slots_[j];
+      i = j;
+    }
+  }
+  slots_[i] = {.hash = {}, .index = NONE};
+  --size_;
+}
+
+void OrderBook::Table::rehash(size_t capacity) {
+  auto slots = std::move(slots_);
+  slots_.assign(capacity, {.hash = {}, .index = NONE});
+  mask_ = capacity - 1;
+  size_ = {};
+  for (auto &slot : slots)
+    if (slot.index != NONE)
+      insert(slot.hash, slot.index);
+}
+
+// === ORDER BOOK ===
+
+OrderBook::OrderBook(size_t capacity)
+    : orders_(capacity), order_index_(capacity), levels_(capacity), level_index_(capacity) {
+}
+
+void OrderBook::reset() {
+  tick_size_ = NaN;
+  clear();
+}
+
+void OrderBook::operator()(const ReferenceData &reference_data) {
+  if (reference_data.tick_size == tick_size_ || !(reference_data.tick_size > 0.0))
+    return;
+  // note! existing keys are meaningless with a different tick size
+  tick_size_ = reference_data.tick_size;
+  clear();
+}
+
+void OrderBook::clear() {
+  orders_.clear();
+  order_index_.clear();
+  levels_.clear();
+  level_index_.clear();
+}
+
+void OrderBook::update(const MarketByOrderUpdate &market_by_order_update) {
+  bids_.clear();
+  asks_.clear();
+  if (ROQ_UNLIKELY(std::isnan(tick_size_)))  // note! requires reference data
+    return;
+  if (market_by_order_update.snapshot)
+    clear();
+  for (auto &mbo_update : market_by_order_update.bids)
+    update(mbo_update, true);
+  for (auto &mbo_update : market_by_order_update.asks)
+    update(mbo_update, false);
+}
+
+void OrderBook::update(const MBOUpdate &mbo_update, bool is_bid) {
+  auto hash = hash_order_id(mbo_update.order_id);
+  auto order = find_order(hash, mbo_update.order_id);
+  if (mbo_update.action == OrderUpdateAction::REMOVE || !(mbo_update.remaining_quantity > 0.0)) {
+    if (order != NONE)
+      remove_order(order);
+    return;
+  }
+  auto key = to_key(mbo_update.price, is_bid);
+  if (order == NONE) {
+    order = add_order(hash, mbo_update.order_id);
+  } else if (levels_[orders_[order].level].key != key) {
+    unlink(order);  // note! loses time priority
+  } else {
+    // note! quantity changes keep time priority
+    auto &level = levels_[orders_[order].level];
+    level.quantity += mbo_update.remaining_quantity - orders_[order].quantity;
+    orders_[order].quantity = mbo_update.remaining_quantity;
+    publish(level);
+    return;
+  }
+  orders_[order].quantity = mbo_update.remaining_quantity;
+  link(order, key, mbo_update.price);
+}
+
+OrderBook::Index OrderBook::find_order(uint64_t hash, const std::string_view &order_id) const {
+  return order_index_.find(hash, [&](auto index) {
+    auto &order = orders_[index];
+    return std::string_view(order.order_id, order.length) == order_id;
+  });
+}
+
+OrderBook::Index OrderBook::add_order(uint64_t hash, const std::string_view &order_id) {
+  if (ROQ_UNLIKELY(order_id.length() > MAX_ORDER_ID_LENGTH))
+    throw RuntimeErrorException(
+        R"(Unexpected: order_id="{}" exceeds {} characters)"_fmt, order_id, MAX_ORDER_ID_LENGTH);
+  auto index = orders_.allocate();
+  auto &order = orders_[index];
+  order.hash = hash;
+  order.quantity = {};
+  order.level = NONE;
+  order.prev = NONE;
+  order.next = NONE;
+  order.length = static_cast<uint8_t>(order_id.length());
+  std::memcpy(order.order_id, order_id.data(), order_id.length());
+  order_index_.insert(hash, index);
+  return index;
+}
+
+void OrderBook::remove_order(Index index) {
+  unlink(index);
+  order_index_.erase(orders_[index].hash, index);
+  orders_.release(index);
+}
+
+// append to the FIFO queue of the level (created if it doesn't exist)
+void OrderBook::link(Index index, int64_t key, double price) {
+  auto hash = mix(key);
+  auto level_index = level_index_.find(hash, [&](auto i) { return levels_[i].key == key; });
+  if (level_index == NONE) {
+    level_index = levels_.allocate();
+    levels_[level_index] = {
+        .key = key,
+        .price = price,
+        .quantity = {},
+        .count = {},
+        .head = NONE,
+        .tail = NONE,
+    };
+    level_index_.insert(hash, level_index);
+  }
+  auto &level = levels_[level_index];
+  auto &order = orders_[index];
+  order.level = level_index;
+  order.prev = level.tail;
+  order.next = NONE;
+  if (level.tail != NONE)
+    orders_[level.tail].next = index;
+  else
+    level.head = index;
+  level.tail = index;
+  ++level.count;
+  level.quantity += order.quantity;
+  publish(level);
+}
+
+// remove from the FIFO queue of the level (released if empty)
+void OrderBook::unlink(Index index) {
+  auto &order = orders_[index];
+  auto level_index = order.level;
+  auto &level = levels_[level_index];
+  if (order.prev != NONE)
+    orders_[order.prev].next = order.next;
+  else
+    level.head = order.next;
+  if (order.next != NONE)
+    orders_[order.next].prev = order.prev;
+  else
+    level.tail = order.prev;
+  order.level = NONE;
+  order.prev = NONE;
+  order.next = NONE;
+  if (--level.count > 0) {
+    level.quantity -= order.quantity;
+    publish(level);
+    return;
+  }
+  level.quantity = 0.0;  // note! avoids accumulated rounding errors
+  publish(level);
+  level_index_.erase(mix(level.key), level_index);
+  levels_.release(level_index);
+}
+
+void OrderBook::publish(const Level &level) {
+  auto &result = (level.key & 1) ? bids_ : asks_;
+  result.push_back({.price = level.price, .quantity = level.quantity});
+}
+
+// note! the lowest bit is the side
+int64_t OrderBook::to_key(double price, bool is_bid) const {
+  return std::llround(price / tick_size_) * 2 + (is_bid ? 1 : 0);
+}
+
+}  // namespace example_3
+}  // namespace samples
+}  // namespace roq
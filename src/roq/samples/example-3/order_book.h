@@ -0,0 +1,194 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <string_view>
+#include <vector>
+
+#include "roq/api.h"
+
+namespace roq {
+namespace samples {
+namespace example_3 {
+
+// full (L3) order book maintained from market by order
+//
+// * orders are found by order_id using an open-addressing hash table
+// * orders and price levels are pooled and linked by index (no allocations
+//   once the pools have grown to the number of live orders)
+// * each price level keeps an intrusive FIFO queue of its orders (time
+//   priority, an order loses its place when the price changes)
+//
+// every update is translated to the aggregated (market by price) changes of
+// the price levels it touched, e.g. to maintain depth using a PriceLadder
+//
+// note!
+//   order_id is copied into the order (fixed length, no allocation)
+
+class OrderBook final {
+ public:
+  static constexpr size_t MAX_ORDER_ID_LENGTH = 40;  // note! fits a UUID
+
+  // capacity is the expected number of live orders (pools will grow beyond)
+  explicit OrderBook(size_t capacity = 65536);
+
+  OrderBook(OrderBook &&) = delete;
+  OrderBook(const OrderBook &) = delete;
+
+  // number of live orders
+  size_t size() const { return orders_.size(); }
+
+  void reset();
+
+  void operator()(const ReferenceData &);
+
+  // note! the callback receives the aggregated levels as a MarketByPriceUpdate
+  template <typename Callback>
+  void operator()(const MarketByOrderUpdate &market_by_order_update, Callback &&callback) {
+    update(market_by_order_update);
+    const MarketByPriceUpdate market_by_price_update{
+        .stream_id = market_by_order_update.stream_id,
+        .exchange = market_by_order_update.exchange,
+        .symbol = market_by_order_update.symbol,
+        .bids = {bids_.data(), bids_.size()},
+        .asks = {asks_.data(), asks_.size()},
+        .snapshot = market_by_order_update.snapshot,
+        .exchange_time_utc = market_by_order_update.exchange_time_utc,
+    };
+    callback(market_by_price_update);
+  }
+
+  // note! public to allow testing
+  using Index = uint32_t;
+
+  static constexpr Index NONE = std::numeric_limits<Index>::max();
+
+  // open-addressing (linear probing, backward-shift deletion)
+  // note! the hash is kept with the index to avoid touching nodes when probing
+  class Table final {
+   public:
+    explicit Table(size_t capacity);
+
+    size_t size() const { return size_; }
+    size_t capacity() const { return slots_.size(); }
+
+    void clear();
+
+    template <typename Equal>
+    Index find(uint64_t hash, Equal &&equal) const {
+      for (auto i = hash & mask_;; i = (i + 1) & mask_) {
+        auto &slot = slots_[i];
+        if (slot.index == NONE)
+          return NONE;
+        if (slot.hash == hash && equal(slot.index))
+          return slot.index;
+      }
+    }
+
+    void insert(uint64_t hash, Index);  // note! must not exist
+    void erase(uint64_t hash, Index);   // note! must exist
+
+   protected:
+    void rehash(size_t capacity);
+
+   private:
+    struct Slot final {
+      uint64_t hash;
+      Index index;
+    };
+    std::vector<Slot> slots_;
+    size_t mask_ = {};
+    size_t size_ = {};
+  };
+
+ protected:
+  struct Order final {
+    uint64_t hash;
+    double quantity;
+    Index level;
+    Index prev;  // note! FIFO queue
+    Index next;  // note! FIFO queue
+    uint8_t length;
+    char order_id[MAX_ORDER_ID_LENGTH];
+  };
+
+  struct Level final {
+    int64_t key;  // note! tick and side
+    double price;
+    double quantity;
+    uint32_t count;
+    Index head;  // note! FIFO queue
+    Index tail;  // note! FIFO queue
+  };
+
+  // pool of nodes (addressed by index)
+  template <typename T>
+  class Pool final {
+   public:
+    explicit Pool(size_t capacity) {
+      nodes_.reserve(capacity);
+      free_.reserve(capacity);
+    }
+
+    size_t size() const { return nodes_.size() - free_.size(); }
+
+    T &operator[](Index index) { return nodes_[index]; }
+    const T &operator[](Index index) const { return nodes_[index]; }
+
+    Index allocate() {
+      if (!free_.empty()) {
+        auto index = free_.back();
+        free_.pop_back();
+        return index;
+      }
+      nodes_.emplace_back();
+      return static_cast<Index>(nodes_.size() - 1);
+    }
+
+    void release(Index index) { free_.push_back(index); }
+
+    // note! keeps the capacity
+    void clear() {
+      nodes_.clear();
+      free_.clear();
+    }
+
+   private:
+    std::vector<T> nodes_;
+    std::vector<Index> free_;
+  };
+
+  void clear();
+
+  void update(const MarketByOrderUpdate &);
+
+  void update(const MBOUpdate &, bool is_bid);
+
+  Index find_order(uint64_t hash, const std::string_view &order_id) const;
+
+  Index add_order(uint64_t hash, const std::string_view &order_id);
+  void remove_order(Index);
+
+  void link(Index order, int64_t key, double price);
+  void unlink(Index order);
+
+  void publish(const Level &);
+
+  int64_t to_key(double price, bool is_bid) const;
+
+ private:
+  double tick_size_ = NaN;
+  Pool<Order> orders_;
+  Table order_index_;
+  Pool<Level> levels_;
+  Table level_index_;
+  // note! re-used to avoid allocations
+  std::vector<MBPUpdate> bids_;
+  std::vector<MBPUpdate> asks_;
+};
+
+}  // namespace example_3
+}  // namespace samples
+}  // namespace roq
@@ -2,6 +2,7 @@
 
 #include "roq/samples/example-3/strategy.h"
 
+#include <algorithm>
 #include <limits>
 
 #include "roq/logging.h"
@@ -17,8 +18,20 @@ namespace roq {
 namespace samples {
 namespace example_3 {
 
+namespace {
+static const size_t MAX_INSTRUMENTS = 1;
+static const uint8_t SOURCE = 0;  // note! only one connection
+}  // namespace
+
 Strategy::Strategy(client::Dispatcher &dispatcher)
-    : dispatcher_(dispatcher), instrument_(Flags::exchange(), Flags::symbol(), Flags::account()) {
+    : dispatcher_(dispatcher), instruments_(MAX_INSTRUMENTS),
+      instrument_(instruments_[instruments_.emplace(
+          SOURCE,
+          Flags::exchange(),
+          Flags::symbol(),
+          Flags::exchange(),
+          Flags::symbol(),
+          Flags::account())]) {
 }
 
 void Strategy::operator()(const Event<Timer> &event) {
@@ -51,20 +64,28 @@ void Strategy::operator()(const Event<DownloadEnd> &event) {
   }
 }
 
+void Strategy::operator()(const Event<GatewaySettings> &event) {
+  dispatch(event);
+}
+
 void Strategy::operator()(const Event<GatewayStatus> &event) {
   dispatch(event);
 }
 
 void Strategy::operator()(const Event<ReferenceData> &event) {
-  dispatch(event);
+  dispatch_by_symbol(event);
 }
 
 void Strategy::operator()(const Event<MarketStatus> &event) {
-  dispatch(event);
+  dispatch_by_symbol(event);
 }
 
 void Strategy::operator()(const Event<MarketByPriceUpdate> &event) {
-  dispatch(event);
+  dispatch_by_symbol(event);
+}
+
+void Strategy::operator()(const Event<MarketByOrderUpdate> &event) {
+  dispatch_by_symbol(event);
 }
 
 void Strategy::operator()(const Event<OrderAck> &event) {
@@ -77,7 +98,7 @@ void Strategy::operator()(const Event<OrderAck> &event) {
 
 void Strategy::operator()(const Event<OrderUpdate> &event) {
   log::info("OrderUpdate={}"_fmt, event.value);
-  dispatch(event);  // update position
+  dispatch_by_symbol(event);  // update position
   auto &order_update = event.value;
   if (utils::is_order_complete(order_update.status)) {
     working_order_id_ = {};
@@ -90,7 +111,7 @@ void Strategy::operator()(const Event<TradeUpdate> &event) {
 }
 
 void Strategy::operator()(const Event<PositionUpdate> &event) {
-  dispatch(event);
+  dispatch_by_symbol(event);
 }
 
 void Strategy::operator()(const Event<FundsUpdate> &event) {
@@ -98,8 +119,14 @@ void Strategy::operator()(const Event<FundsUpdate> &event) {
 }
 
 void Strategy::update_model() {
+  // note! order flow imbalance since the previous sample (the history is cleared on reset)
+  auto &history = instrument_.history();
+  auto updates = history.count() - std::min(history_count_, history.count());
+  history_count_ = history.count();
+  log::trace_1(
+      "order_flow_imbalance={}, updates={}"_fmt, history.order_flow_imbalance(updates), updates);
   if (instrument_.is_ready()) {
-    auto side = model_.update(instrument_);
+    auto side = instrument_.visit([&](auto &depth) { return model_.update(depth); });
     switch (side) {
       case Side::UNDEFINED:
         // nothing to do
@@ -4,6 +4,8 @@
 
 #include "roq/client.h"
 
+#include "roq/samples/common/instrument_registry.h"
+
 #include "roq/samples/example-3/instrument.h"
 #include "roq/samples/example-3/model.h"
 
@@ -15,7 +17,7 @@ class Strategy final : public client::Handler {
  public:
   explicit Strategy(client::Dispatcher &);
 
-  Strategy(Strategy &&) = default;
+  Strategy(Strategy &&) = delete;
   Strategy(const Strategy &) = delete;
 
  protected:
@@ -24,21 +26,34 @@ class Strategy final : public client::Handler {
   void operator()(const Event<Disconnected> &) override;
   void operator()(const Event<DownloadBegin> &) override;
   void operator()(const Event<DownloadEnd> &) override;
+  void operator()(const Event<GatewaySettings> &) override;
   void operator()(const Event<GatewayStatus> &) override;
   void operator()(const Event<ReferenceData> &) override;
   void operator()(const Event<MarketStatus> &) override;
   void operator()(const Event<MarketByPriceUpdate> &) override;
+  void operator()(const Event<MarketByOrderUpdate> &) override;
   void operator()(const Event<OrderAck> &) override;
   void operator()(const Event<OrderUpdate> &) override;
   void operator()(const Event<TradeUpdate> &) override;
   void operator()(const Event<PositionUpdate> &) override;
   void operator()(const Event<FundsUpdate> &) override;
 
-  // helper - dispatch event to instrument
+  // helper - dispatch event to all instruments of the source
   template <typename T>
   void dispatch(const T &event) {
-    assert(event.message_info.source == 0u);
-    instrument_(event.value);
+    instruments_.for_each(
+        event.message_info.source, [&](auto &instrument) { instrument(event.value); });
+  }
+
+  // helper - dispatch event to the relevant instrument
+  // note! one hash probe, events for unknown instruments are dropped
+  template <typename T>
+  void dispatch_by_symbol(const T &event) {
+    auto &value = event.value;
+    instruments_.dispatch(
+        event.message_info.source, value.exchange, value.symbol, [&](auto &instrument) {
+          instrument(value);
+        });
   }
 
   void update_model();
@@ -47,10 +62,12 @@ class Strategy final : public client::Handler {
 
  private:
   client::Dispatcher &dispatcher_;
-  Instrument instrument_;
+  common::InstrumentRegistry<Instrument> instruments_;
+  Instrument &instrument_;
   uint32_t max_order_id_ = {};
   Model model_;
   std::chrono::nanoseconds next_sample_ = {};
+  uint64_t history_count_ = {};  // note! at the previous sample
   uint32_t working_order_id_ = {};
   Side working_side_ = {};
 };
@@ -2,13 +2,32 @@
 
 #include "roq/samples/import/application.h"
 
+#include <fmt/format.h>
+
+#include <chrono>
+#include <optional>
 #include <stdexcept>
+#include <string>
 #include <vector>
 
 #include "roq/exceptions.h"
 #include "roq/literals.h"
 
+#include "roq/utils/compare.h"
+
+#include "roq/samples/import/csv_reader.h"
+#include "roq/samples/import/decompressor.h"
+#include "roq/samples/import/flags.h"
+#include "roq/samples/import/generator.h"
+#include "roq/samples/import/json_reader.h"
+#include "roq/samples/import/mapped_file.h"
+#include "roq/samples/import/parallel.h"
 #include "roq/samples/import/processor.h"
+#include "roq/samples/import/snapshotter.h"
+#include "roq/samples/import/sorter.h"
+#include "roq/samples/import/validator.h"
+#include "roq/samples/import/verifier.h"
+#include "roq/samples/import/writer.h"
 
 using namespace roq::literals;
 
@@ -16,10 +35,91 @@ namespace roq {
 namespace samples {
 namespace import {
 
+namespace {
+static Parallel::ShardBy parse_shard_by() {
+  auto shard_by = Flags::shard_by();
+  if (utils::case_insensitive_compare(shard_by, "file"_sv) == 0)
+    return Parallel::ShardBy::FILE;
+  if (utils::case_insensitive_compare(shard_by, "symbol"_sv) == 0)
+    return Parallel::ShardBy::SYMBOL;
+  throw RuntimeErrorException(R"(Unknown shard_by="{}")"_fmt, shard_by);
+}
+
+// note! recovers the binary frames (one block at a time)
+static void decompress(const std::string_view &path, const roq::span<std::string_view> &inputs) {
+  Writer writer(path, Flags::block_size(), Flags::direct_io(), Flags::preallocate());
+  for (auto &input : inputs) {
+    MappedFile file(input);
+    Decompressor decompressor(file.data());
+    std::string_view frames;
+    while (decompressor.next(frames))
+      writer.write(frames.data(), frames.size());
+  }
+  writer.close();
+}
+}  // namespace
+
 int Application::main_helper(const roq::span<std::string_view> &args) {
-  if (args.size() != 2u)
-    throw RuntimeErrorException("Expected exactly 1 argument, got {}"_fmt, args.size() - 1u);
-  Processor(args[1u]).dispatch();
+  if (args.size() < 2u)
+    throw RuntimeErrorException("Expected at least 1 argument, got {}"_fmt, args.size() - 1u);
+  if (Flags::summary()) {
+    // note! all arguments are inputs
+    for (auto &path : args.subspan(1u))
+      Verifier(
+          path,
+          Flags::threads(),
+          Flags::verify(),
+          std::chrono::nanoseconds{Flags::start_time_utc()},
+          std::chrono::nanoseconds{Flags::end_time_utc()})
+          .dispatch();
+    return EXIT_SUCCESS;
+  }
+  auto inputs = args.subspan(2u);
+  if (Flags::decompress()) {
+    decompress(args[1u], inputs);
+    return EXIT_SUCCESS;
+  }
+  // note! with --sort, threads are used for sorting
+  if (!inputs.empty() && Flags::threads() > 1u && !Flags::sort()) {
+    Parallel(args[1u], inputs, Flags::threads(), parse_shard_by()).dispatch();
+    return EXIT_SUCCESS;
+  }
+  Processor processor(args[1u]);
+  std::optional<Snapshotter> snapshotter;
+  if (Snapshotter::enabled())
+    snapshotter.emplace(processor);
+  Handler &handler = snapshotter ? static_cast<Handler &>(*snapshotter) : processor;
+  if (Flags::generate() > 0u) {
+    if (!inputs.empty())
+      throw RuntimeErrorException("Input files can not be used with --generate"_sv);
+    Generator().dispatch(handler);
+  } else if (inputs.empty()) {
+    // no input files: just demonstrate the encoding
+    processor.dispatch();
+  } else if (auto format = JSONReader::format()) {
+    if (Flags::sort() || Flags::validate())
+      throw RuntimeErrorException("JSON input can not be used with --sort or --validate"_sv);
+    // note! each input must be ordered by time
+    for (auto &path : inputs)
+      JSONReader(path, *format).dispatch(handler);
+  } else if (Flags::sort()) {
+    if (Flags::validate())
+      throw RuntimeErrorException("Validation can not be used with --sort"_sv);
+    Sorter(args[1u], inputs, Flags::threads(), Flags::sort_run_size()).dispatch(handler);
+  } else if (Flags::validate()) {
+    // note! sequence numbers continue across input files
+    Validator validator(
+        Flags::validate_window(),
+        Flags::gap_markers() ? fmt::format("{}.gaps", args[1u]) : std::string());
+    for (auto &path : inputs)
+      CSVReader(path, validator).dispatch(handler);
+    validator.close();
+  } else {
+    // note! each input must be ordered by time
+    for (auto &path : inputs)
+      CSVReader(path).dispatch(handler);
+  }
+  processor.close();
   return EXIT_SUCCESS;
 }
 
@@ -3,7 +3,11 @@
 #include "roq/samples/import/base64.h"
 
 #include <cassert>
-#include <cstring>
+#include <cstdint>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
 
 namespace {
 
@@ -16,13 +20,11 @@ namespace {
 // - added assertions
 // - removed functions and tables not needed here
 // - clang-format
+// - writes to caller supplied buffer (instead of allocating a std::string)
 
 static char const *B64chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
-const std::string b64encode(const void *data, const size_t &len) {
-  std::string result((len + 2) / 3 * 4, '=');
-  unsigned char const *p = reinterpret_cast<unsigned char const *>(data);
-  char *str = &result[0];
+size_t b64encode(char *str, unsigned char const *p, const size_t len) {
   size_t j = 0, pad = len % 3;
   const size_t last = len - pad;
 
@@ -43,22 +45,168 @@ const std::string b64encode(const void *data, const size_t &len) {
     str[j++] = B64chars[pad ? n >> 10 & 0x3F : n >> 2];
     str[j++] = B64chars[pad ? n >> 4 & 0x03F : n << 4 & 0x3F];
     str[j++] = pad ? B64chars[n << 2 & 0x3F] : '=';
+    str[j++] = '=';
   }
-  return result;
+  return j;
 }
 
+#if defined(__x86_64__)
+
+// http://0x80.pl/notesen/2016-01-12-sse-base64-encoding.html
+// - shuffle 12 input bytes so each 32-bit lane holds 3 bytes
+// - isolate the four 6-bit indices using multiplications
+// - translate indices to ascii with a 16 entry (pshufb) lookup of offsets
+
+__attribute__((target("ssse3"))) inline __m128i encode_lane(__m128i input) {
+  input = _mm_shuffle_epi8(input, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+  auto t0 = _mm_and_si128(input, _mm_set1_epi32(0x0fc0fc00));
+  auto t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+  auto t2 = _mm_and_si128(input, _mm_set1_epi32(0x003f03f0));
+  auto t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+  auto indices = _mm_or_si128(t1, t3);
+  auto result = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+  auto less = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+  result = _mm_or_si128(result, _mm_and_si128(less, _mm_set1_epi8(13)));
+  auto offsets = _mm_setr_epi8(
+      'a' - 26,
+      '0' - 52,
+      '0' - 52,
+      '0' - 52,
+      '0' - 52,
+      '0' - 52,
+      '0' - 52,
+      '0' - 52,
+      '0' - 52,
+      '0' - 52,
+      '0' - 52,
+      '+' - 62,
+      '/' - 63,
+      'A',
+      0,
+      0);
+  result = _mm_shuffle_epi8(offsets, result);
+  return _mm_add_epi8(result, indices);
+}
+
+__attribute__((target("ssse3"))) size_t encode_ssse3(
+    char *output, unsigned char const *data, size_t length) {
+  size_t i = 0, j = 0;
+  // note! loads 16 bytes, consumes 12
+  for (; i + 16 <= length; i += 12, j += 16) {
+    auto input = _mm_loadu_si128(reinterpret_cast<__m128i const *>(data + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(output + j), encode_lane(input));
+  }
+  return j + b64encode(output + j, data + i, length - i);
+}
+
+__attribute__((target("avx2"))) size_t encode_avx2(
+    char *output, unsigned char const *data, size_t length) {
+  // note! same tables as encode_lane, repeated for each 128-bit lane
+  // clang-format off
+  auto shuffle = _mm256_set_epi8(
+      10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1,
+      10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+  auto offsets = _mm256_setr_epi8(
+      'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+      '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0,
+      'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+      '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+  // clang-format on
+  size_t i = 0, j = 0;
+  // note! loads 28 bytes (two overlapping 16 byte loads), consumes 24
+  for (; i + 28 <= length; i += 24, j += 32) {
+    auto lo = _mm_loadu_si128(reinterpret_cast<__m128i const *>(data + i));
+    auto hi = _mm_loadu_si128(reinterpret_cast<__m128i const *>(data + i + 12));
+    auto input = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+    input = _mm256_shuffle_epi8(input, shuffle);
+    auto t0 = _mm256_and_si256(input, _mm256_set1_epi32(0x0fc0fc00));
+    auto t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+    auto t2 = _mm256_and_si256(input, _mm256_set1_epi32(0x003f03f0));
+    auto t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+    auto indices = _mm256_or_si256(t1, t3);
+    auto result = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+    auto less = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+    result = _mm256_or_si256(result, _mm256_and_si256(less, _mm256_set1_epi8(13)));
+    result = _mm256_shuffle_epi8(offsets, result);
+    result = _mm256_add_epi8(result, indices);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(output + j), result);
+  }
+  return j + encode_ssse3(output + j, data + i, length - i);
+}
+
+#endif
+
+size_t encode_scalar(char *output, unsigned char const *data, size_t length) {
+  return b64encode(output, data, length);
+}
+
+using encode_type = size_t (*)(char *, unsigned char const *, size_t);
+
+encode_type select_implementation() {
+#if defined(__x86_64__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    return encode_avx2;
+  if (__builtin_cpu_supports("ssse3"))
+    return encode_ssse3;
+#endif
+  return encode_scalar;
+}
+
+// note! decoding is only used for verification (scalar is good enough)
+
+struct DecodeTable final {
+  constexpr DecodeTable() {
+    for (auto &value : values)
+      value = INVALID;
+    constexpr char const alphabet[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    for (int i = 0; i < 64; ++i)
+      values[static_cast<unsigned char>(alphabet[i])] = static_cast<unsigned char>(i);
+  }
+  static constexpr unsigned char INVALID = 0xFF;
+  unsigned char values[256] = {};
+};
+
+static constexpr DecodeTable DECODE_TABLE;
+
 }  // namespace
 
 namespace roq {
 namespace samples {
 namespace import {
 
-std::string Base64::encode(void const *data, size_t length) {
-  auto result = ::b64encode(data, length);
-  assert(result.length() == std::strlen(result.c_str()));
+size_t Base64::encode(char *output, void const *data, size_t length) {
+  static const auto implementation = ::select_implementation();
+  auto result = (*implementation)(output, static_cast<unsigned char const *>(data), length);
+  assert(result == encoded_length(length));
   return result;
 }
 
+size_t Base64::decode(void *output, char const *data, size_t length) {
+  if (length % 4 != 0)
+    return INVALID;
+  auto out = static_cast<unsigned char *>(output);
+  size_t j = 0;
+  for (size_t i = 0; i < length; i += 4) {
+    auto last = (i + 4) == length;
+    size_t padding = last ? (data[i + 3] == '=') + (data[i + 2] == '=') : 0;
+    uint32_t n = 0;
+    for (size_t k = 0; k < 4u - padding; ++k) {
+      auto value = DECODE_TABLE.values[static_cast<unsigned char>(data[i + k])];
+      if (value == DecodeTable::INVALID)
+        return INVALID;
+      n |= static_cast<uint32_t>(value) << (18 - 6 * k);
+    }
+    out[j++] = static_cast<unsigned char>(n >> 16);
+    if (padding < 2)
+      out[j++] = static_cast<unsigned char>(n >> 8);
+    if (padding < 1)
+      out[j++] = static_cast<unsigned char>(n);
+  }
+  return j;
+}
+
 }  // namespace import
 }  // namespace samples
 }  // namespace roq
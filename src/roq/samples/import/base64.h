@@ -2,19 +2,32 @@
 
 #pragma once
 
-#include <string>
+#include <cstddef>
 
 namespace roq {
 namespace samples {
 namespace import {
 
 // note!
-// this implementation is a bit wasteful since it allocates a std::string
-// on each invocation
+// the caller owns the output buffer (and should re-use it)
+// the implementation (avx2, ssse3 or scalar) is selected at runtime
+// depending on what the cpu supports
 
 class Base64 final {
  public:
-  static std::string encode(void const *data, size_t length);
+  static constexpr size_t encoded_length(size_t length) { return (length + 2) / 3 * 4; }
+
+  // output must have room for (at least) encoded_length(length) characters
+  // returns number of characters written (not null-terminated)
+  static size_t encode(char *output, void const *data, size_t length);
+
+  static constexpr size_t INVALID = static_cast<size_t>(-1);
+
+  static constexpr size_t decoded_length(size_t length) { return length / 4 * 3; }
+
+  // output must have room for (at least) decoded_length(length) bytes
+  // returns number of bytes written (INVALID if the input is not valid base64)
+  static size_t decode(void *output, char const *data, size_t length);
 };
 
 }  // namespace import
@@ -0,0 +1,38 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#pragma once
+
+#include <cstdint>
+
+namespace roq {
+namespace samples {
+namespace import {
+
+// block-compressed stream format
+//
+//   file   := header block*
+//   header := magic (4 bytes) codec (u32) dictionary_size (u32) dictionary
+//   block  := uncompressed_size (u32) compressed_size (u32) payload
+//
+// note!
+//   integers are little-endian
+//   blocks only contain complete (size-prefixed) frames so each block can be
+//   decompressed independently (using the dictionary)
+
+enum class Codec : uint32_t {
+  LZ4 = 1,
+  ZSTD = 2,
+};
+
+struct BlockHeader final {
+  uint32_t uncompressed_size;
+  uint32_t compressed_size;
+};
+
+static constexpr char const CODEC_MAGIC[4] = {'R', 'Q', 'Z', '1'};
+
+static constexpr uint32_t CODEC_HEADER_SIZE = sizeof(CODEC_MAGIC) + 2 * sizeof(uint32_t);
+
+}  // namespace import
+}  // namespace samples
+}  // namespace roq
@@ -0,0 +1,185 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#include "roq/samples/import/compressor.h"
+
+#include <zdict.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <new>
+
+#include "roq/exceptions.h"
+#include "roq/logging.h"
+
+using namespace roq::literals;
+
+namespace roq {
+namespace samples {
+namespace import {
+
+Compressor::Compressor(
+    Writer &writer,
+    Codec codec,
+    int level,
+    size_t block_size,
+    size_t dictionary_samples,
+    size_t dictionary_size)
+    : writer_(writer), codec_(codec), level_(level), block_size_(block_size),
+      dictionary_samples_(dictionary_samples), dictionary_size_(dictionary_size) {
+  switch (codec_) {
+    case Codec::LZ4:
+      lz4_dictionary_ = LZ4_createStream();
+      lz4_stream_ = LZ4_createStream();
+      if (lz4_dictionary_ == nullptr || lz4_stream_ == nullptr)
+        throw std::bad_alloc();
+      break;
+    case Codec::ZSTD:
+      zstd_context_ = ZSTD_createCCtx();
+      if (zstd_context_ == nullptr)
+        throw std::bad_alloc();
+      break;
+  }
+  block_.reserve(block_size_);
+  if (dictionary_samples_ == 0)  // no training
+    train();
+}
+
+Compressor::~Compressor() {
+  if (lz4_dictionary_)
+    LZ4_freeStream(lz4_dictionary_);
+  if (lz4_stream_)
+    LZ4_freeStream(lz4_stream_);
+  if (zstd_dictionary_)
+    ZSTD_freeCDict(zstd_dictionary_);
+  if (zstd_context_)
+    ZSTD_freeCCtx(zstd_context_);
+}
+
+bool Compressor::write(void const *data, size_t length) {
+  auto begin = static_cast<char const *>(data);
+  if (!header_) {  // still collecting samples
+    samples_.insert(samples_.end(), begin, begin + length);
+    sample_sizes_.emplace_back(length);
+    if (sample_sizes_.size() >= dictionary_samples_)
+      train();
+    return false;
+  }
+  // note! blocks only contain complete frames
+  if (!block_.empty() && (block_.size() + length) > block_size_)
+    compress();
+  auto result = block_.empty();
+  block_.insert(block_.end(), begin, begin + length);
+  return result;
+}
+
+void Compressor::flush() {
+  if (!header_)
+    train();
+  if (!block_.empty())
+    compress();
+}
+
+void Compressor::train() {
+  assert(!header_);
+  if (!sample_sizes_.empty()) {
+    dictionary_.resize(dictionary_size_);
+    auto result = ZDICT_trainFromBuffer(
+        dictionary_.data(),
+        dictionary_.size(),
+        samples_.data(),
+        sample_sizes_.data(),
+        static_cast<unsigned>(sample_sizes_.size()));
+    if (ZDICT_isError(result)) {
+      // note! typically not enough samples -- we can still compress
+      log::warn(R"(Unable to train dictionary: error="{}")"_fmt, ZDICT_getErrorName(result));
+      dictionary_.clear();
+    } else {
+      dictionary_.resize(result);
+      log::info(
+          "Dictionary trained: samples={}, size={}"_fmt, sample_sizes_.size(), dictionary_.size());
+    }
+  }
+  if (!dictionary_.empty()) {
+    switch (codec_) {
+      case Codec::LZ4:
+        // note! lz4 will only use the last 64 KiB
+        LZ4_loadDict(lz4_dictionary_, dictionary_.data(), static_cast<int>(dictionary_.size()));
+        break;
+      case Codec::ZSTD:
+        zstd_dictionary_ = ZSTD_createCDict(dictionary_.data(), dictionary_.size(), level_);
+        if (zstd_dictionary_ == nullptr)
+          throw std::bad_alloc();
+        break;
+    }
+  }
+  // header
+  auto codec = static_cast<uint32_t>(codec_);
+  auto dictionary_size = static_cast<uint32_t>(dictionary_.size());
+  writer_.write(CODEC_MAGIC, sizeof(CODEC_MAGIC));
+  writer_.write(&codec, sizeof(codec));
+  writer_.write(&dictionary_size, sizeof(dictionary_size));
+  writer_.write(dictionary_.data(), dictionary_.size());
+  header_ = true;
+  // replay the samples
+  size_t offset = 0;
+  for (auto size : sample_sizes_) {
+    write(samples_.data() + offset, size);
+    offset += size;
+  }
+  // release memory
+  std::vector<char>().swap(samples_);
+  std::vector<size_t>().swap(sample_sizes_);
+}
+
+void Compressor::compress() {
+  auto size = block_.size();
+  size_t result = 0;
+  switch (codec_) {
+    case Codec::LZ4: {
+      auto bound = static_cast<size_t>(LZ4_compressBound(static_cast<int>(size)));
+      buffer_.resize(sizeof(BlockHeader) + bound);
+      // note! cheaper to copy the prepared state than to load the dictionary
+      if (dictionary_.empty())
+        LZ4_resetStream_fast(lz4_stream_);
+      else
+        std::memcpy(lz4_stream_, lz4_dictionary_, sizeof(LZ4_stream_t));
+      auto length = LZ4_compress_fast_continue(
+          lz4_stream_,
+          block_.data(),
+          buffer_.data() + sizeof(BlockHeader),
+          static_cast<int>(size),
+          static_cast<int>(bound),
+          std::max(level_, 1));  // acceleration
+      if (length <= 0)
+        throw RuntimeErrorException("Unable to compress (lz4)"_sv);
+      result = static_cast<size_t>(length);
+      break;
+    }
+    case Codec::ZSTD: {
+      auto bound = ZSTD_compressBound(size);
+      buffer_.resize(sizeof(BlockHeader) + bound);
+      auto destination = buffer_.data() + sizeof(BlockHeader);
+      result = zstd_dictionary_ != nullptr
+                   ? ZSTD_compress_usingCDict(
+                         zstd_context_, destination, bound, block_.data(), size, zstd_dictionary_)
+                   : ZSTD_compressCCtx(
+                         zstd_context_, destination, bound, block_.data(), size, level_);
+      if (ZSTD_isError(result))
+        throw RuntimeErrorException(
+            R"(Unable to compress (zstd): error="{}")"_fmt, ZSTD_getErrorName(result));
+      break;
+    }
+  }
+  BlockHeader header{
+      .uncompressed_size = static_cast<uint32_t>(size),
+      .compressed_size = static_cast<uint32_t>(result),
+  };
+  std::memcpy(buffer_.data(), &header, sizeof(header));
+  writer_.write(buffer_.data(), sizeof(header) + result);
+  block_.clear();
+}
+
+}  // namespace import
+}  // namespace samples
+}  // namespace roq
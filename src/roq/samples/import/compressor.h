@@ -0,0 +1,72 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#pragma once
+
+#include <lz4.h>
+#include <zstd.h>
+
+#include <memory>
+#include <vector>
+
+#include "roq/samples/import/codec.h"
+#include "roq/samples/import/writer.h"
+
+namespace roq {
+namespace samples {
+namespace import {
+
+// compresses frames into independent blocks (see codec.h)
+//
+// the dictionary is trained on the first frames (typically very repetitive)
+// and stored in the header so the reader can use the same dictionary
+
+class Compressor final {
+ public:
+  Compressor(
+      Writer &,
+      Codec,
+      int level,
+      size_t block_size,
+      size_t dictionary_samples,
+      size_t dictionary_size);
+
+  Compressor(Compressor &&) = delete;
+  Compressor(const Compressor &) = delete;
+
+  ~Compressor();
+
+  // returns true if the frame is the first frame of a new block
+  // note! the block will start at the current position of the writer
+  bool write(void const *data, size_t length);
+
+  void flush();
+
+ protected:
+  void train();
+
+  void compress();
+
+ private:
+  Writer &writer_;
+  const Codec codec_;
+  const int level_;
+  const size_t block_size_;
+  const size_t dictionary_samples_;
+  const size_t dictionary_size_;
+  bool header_ = false;
+  // training
+  std::vector<char> samples_;
+  std::vector<size_t> sample_sizes_;
+  std::vector<char> dictionary_;
+  // compression
+  std::vector<char> block_;
+  std::vector<char> buffer_;
+  LZ4_stream_t *lz4_dictionary_ = nullptr;
+  LZ4_stream_t *lz4_stream_ = nullptr;
+  ZSTD_CCtx *zstd_context_ = nullptr;
+  ZSTD_CDict *zstd_dictionary_ = nullptr;
+};
+
+}  // namespace import
+}  // namespace samples
+}  // namespace roq
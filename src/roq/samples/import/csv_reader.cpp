@@ -0,0 +1,465 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#include "roq/samples/import/csv_reader.h"
+
+#include <cassert>
+#include <cstring>
+#include <functional>
+
+#include "roq/exceptions.h"
+
+#include "roq/samples/import/parse.h"
+
+using namespace roq::literals;
+
+namespace roq {
+namespace samples {
+namespace import {
+
+namespace {
+// splits a line into fields (without copying)
+class Fields final {
+ public:
+  explicit Fields(const std::string_view &line) : remaining_(line) {}
+
+  bool next(std::string_view &field) {
+    if (done_)
+      return false;
+    auto pos = remaining_.find(',');
+    if (pos == remaining_.npos) {
+      field = remaining_;
+      done_ = true;
+    } else {
+      field = remaining_.substr(0, pos);
+      remaining_.remove_prefix(pos + 1);
+    }
+    return true;
+  }
+
+  std::string_view remaining() const { return done_ ? std::string_view() : remaining_; }
+
+ private:
+  std::string_view remaining_;
+  bool done_ = false;
+};
+
+static bool parse_timestamp(const std::string_view &text, std::chrono::nanoseconds &result) {
+  uint64_t value;
+  if (!parse_integer(text, value))
+    return false;
+  result = std::chrono::nanoseconds{value};
+  return true;
+}
+
+static bool parse_side(const std::string_view &text, Side &result) {
+  if (text.empty())
+    return false;
+  switch (text[0]) {
+    case 'B':
+    case 'b':
+      result = Side::BUY;
+      return true;
+    case 'S':
+    case 's':
+      result = Side::SELL;
+      return true;
+  }
+  return false;
+}
+
+static bool parse_bool(const std::string_view &text, bool &result) {
+  if (text.size() != 1u)
+    return false;
+  switch (text[0]) {
+    case '0':
+      result = false;
+      return true;
+    case '1':
+      result = true;
+      return true;
+  }
+  return false;
+}
+
+static bool parse_action(const std::string_view &text, OrderUpdateAction &result) {
+  if (text.size() != 1u)
+    return false;
+  switch (text[0]) {
+    case 'N':
+      result = OrderUpdateAction::NEW;
+      return true;
+    case 'M':
+      result = OrderUpdateAction::MODIFY;
+      return true;
+    case 'R':
+      result = OrderUpdateAction::REMOVE;
+      return true;
+  }
+  return false;
+}
+
+static bool parse_trading_status(const std::string_view &text, TradingStatus &result) {
+  static const struct {
+    std::string_view name;
+    TradingStatus trading_status;
+  } LOOKUP[] = {
+      {"START_OF_DAY"_sv, TradingStatus::START_OF_DAY},
+      {"PRE_OPEN"_sv, TradingStatus::PRE_OPEN},
+      {"OPEN"_sv, TradingStatus::OPEN},
+      {"HALT"_sv, TradingStatus::HALT},
+      {"CLOSE"_sv, TradingStatus::CLOSE},
+      {"END_OF_DAY"_sv, TradingStatus::END_OF_DAY},
+  };
+  for (auto &item : LOOKUP) {
+    if (item.name.compare(text) == 0) {
+      result = item.trading_status;
+      return true;
+    }
+  }
+  return false;
+}
+
+// note! all message types have symbol as the 4th field
+static std::string_view get_symbol(const std::string_view &line) {
+  auto begin = line.data(), end = begin + line.size();
+  for (auto i = 0; i < 3; ++i) {
+    begin = static_cast<char const *>(std::memchr(begin, ',', end - begin));
+    if (begin == nullptr)
+      return {};
+    ++begin;
+  }
+  auto next = static_cast<char const *>(std::memchr(begin, ',', end - begin));
+  return std::string_view(begin, (next == nullptr ? end : next) - begin);
+}
+}  // namespace
+
+CSVReader::CSVReader(const std::string_view &path) : path_(path), file_(std::in_place, path) {
+}
+
+CSVReader::CSVReader(const std::string_view &path, Validator &validator)
+    : path_(path), validator_(&validator), file_(std::in_place, path) {
+}
+
+CSVReader::CSVReader(const std::string_view &name, Push) : path_(name) {
+}
+
+void CSVReader::dispatch(Handler &handler) {
+  assert(file_);
+  auto data = (*file_).data();
+  auto begin = data.data(), end = begin + data.size();
+  while (begin < end) {
+    // note! memchr is typically vectorized by the C library
+    auto next = static_cast<char const *>(std::memchr(begin, '\n', end - begin));
+    if (next == nullptr)
+      next = end;
+    auto length = static_cast<size_t>(next - begin);
+    if (length > 0 && begin[length - 1] == '\r')  // windows line endings
+      --length;
+    ++line_number_;
+    parse(std::string_view(begin, length), handler);
+    begin = next + 1;
+  }
+  flush(handler);
+}
+
+void CSVReader::operator()(const std::string_view &line, Handler &handler) {
+  ++line_number_;
+  parse(line, handler);
+}
+
+void CSVReader::operator()(const std::string_view &line, uint64_t line_number, Handler &handler) {
+  line_number_ = line_number;
+  parse(line, handler);
+}
+
+size_t CSVReader::shard(const std::string_view &line, size_t shard_count) {
+  if (line.size() < 2u || line[1] != ',')
+    return 0;
+  return std::hash<std::string_view>()(get_symbol(line)) % shard_count;
+}
+
+void CSVReader::parse(const std::string_view &line, Handler &handler) {
+  if (line.empty() || line[0] == '#')
+    return;
+  if (validator_ != nullptr) {
+    Fields fields(line);
+    std::string_view channel, seqno;
+    uint64_t value;
+    if (!fields.next(channel) || !fields.next(seqno) || !parse_integer(seqno, value) ||
+        fields.remaining().empty())
+      throw RuntimeErrorException(
+          R"(Expected channel and seqno: path="{}", line_number={}, line="{}")"_fmt,
+          path_,
+          line_number_,
+          line);
+    auto message = fields.remaining();
+    if ((*validator_)(channel, value, message))
+      parse_message(message, handler);
+    return;
+  }
+  parse_message(line, handler);
+}
+
+void CSVReader::parse_message(const std::string_view &line, Handler &handler) {
+  if (line.size() < 2u || line[1] != ',')
+    throw RuntimeErrorException(
+        R"(Unknown message type: path="{}", line_number={}, line="{}")"_fmt,
+        path_,
+        line_number_,
+        line);
+  switch (line[0]) {
+    case 'R':
+      parse_reference_data(line, handler);
+      break;
+    case 'S':
+      parse_market_status(line, handler);
+      break;
+    case 'P':
+      parse_market_by_price(line, handler);
+      break;
+    case 'O':
+      parse_market_by_order(line, handler);
+      break;
+    case 'T':
+      parse_trade(line, handler);
+      break;
+    default:
+      throw RuntimeErrorException(
+          R"(Unknown message type: path="{}", line_number={}, line="{}")"_fmt,
+          path_,
+          line_number_,
+          line);
+  }
+}
+
+void CSVReader::parse_reference_data(const std::string_view &line, Handler &handler) {
+  flush(handler);
+  Fields fields(line);
+  std::string_view type, timestamp, exchange, symbol, tick_size, multiplier, min_trade_vol;
+  std::chrono::nanoseconds timestamp_utc;
+  ReferenceData reference_data{
+      .stream_id = {},
+      .exchange = {},
+      .symbol = {},
+      .description = {},
+      .security_type = {},
+      .currency = {},
+      .settlement_currency = {},
+      .commission_currency = {},
+      .tick_size = NaN,
+      .multiplier = NaN,
+      .min_trade_vol = NaN,
+      .option_type = {},
+      .strike_currency = {},
+      .strike_price = NaN,
+      .underlying = {},
+      .time_zone = {},
+      .issue_date = {},
+      .settlement_date = {},
+      .expiry_datetime = {},
+      .expiry_datetime_utc = {},
+  };
+  if (!(fields.next(type) && fields.next(timestamp) && fields.next(exchange) &&
+        fields.next(symbol) && fields.next(tick_size) && fields.next(multiplier) &&
+        fields.next(min_trade_vol) && parse_timestamp(timestamp, timestamp_utc) &&
+        parse_decimal(tick_size, reference_data.tick_size) &&
+        parse_decimal(multiplier, reference_data.multiplier) &&
+        parse_decimal(min_trade_vol, reference_data.min_trade_vol)))
+    throw RuntimeErrorException(
+        R"(Invalid reference data: path="{}", line_number={}, line="{}")"_fmt,
+        path_,
+        line_number_,
+        line);
+  reference_data.exchange = exchange;
+  reference_data.symbol = symbol;
+  handler(reference_data, timestamp_utc);
+}
+
+void CSVReader::parse_market_status(const std::string_view &line, Handler &handler) {
+  flush(handler);
+  Fields fields(line);
+  std::string_view type, timestamp, exchange, symbol, trading_status;
+  std::chrono::nanoseconds timestamp_utc;
+  MarketStatus market_status{
+      .stream_id = {},
+      .exchange = {},
+      .symbol = {},
+      .trading_status = {},
+  };
+  if (!(fields.next(type) && fields.next(timestamp) && fields.next(exchange) &&
+        fields.next(symbol) && fields.next(trading_status) &&
+        parse_timestamp(timestamp, timestamp_utc) &&
+        parse_trading_status(trading_status, market_status.trading_status)))
+    throw RuntimeErrorException(
+        R"(Invalid market status: path="{}", line_number={}, line="{}")"_fmt,
+        path_,
+        line_number_,
+        line);
+  market_status.exchange = exchange;
+  market_status.symbol = symbol;
+  handler(market_status, timestamp_utc);
+}
+
+void CSVReader::parse_market_by_price(const std::string_view &line, Handler &handler) {
+  Fields fields(line);
+  std::string_view type, timestamp, exchange, symbol, snapshot, side, price, quantity;
+  std::chrono::nanoseconds timestamp_utc;
+  bool is_snapshot;
+  Side mbp_side;
+  MBPUpdate mbp_update;
+  if (!(fields.next(type) && fields.next(timestamp) && fields.next(exchange) &&
+        fields.next(symbol) && fields.next(snapshot) && fields.next(side) && fields.next(price) &&
+        fields.next(quantity) && parse_timestamp(timestamp, timestamp_utc) &&
+        parse_bool(snapshot, is_snapshot) && parse_side(side, mbp_side) &&
+        parse_decimal(price, mbp_update.price) && parse_decimal(quantity, mbp_update.quantity)))
+    throw RuntimeErrorException(
+        R"(Invalid market by price: path="{}", line_number={}, line="{}")"_fmt,
+        path_,
+        line_number_,
+        line);
+  if (pending_ != Pending::MARKET_BY_PRICE || timestamp_utc != timestamp_ ||
+      snapshot_ != is_snapshot || exchange_.compare(exchange) != 0 ||
+      symbol_.compare(symbol) != 0) {
+    flush(handler);
+    pending_ = Pending::MARKET_BY_PRICE;
+    timestamp_ = timestamp_utc;
+    exchange_ = exchange;
+    symbol_ = symbol;
+    snapshot_ = is_snapshot;
+  }
+  if (mbp_side == Side::BUY)
+    bids_.emplace_back(mbp_update);
+  else
+    asks_.emplace_back(mbp_update);
+}
+
+// note! order_id is a view into the line (zero-copy)
+void CSVReader::parse_market_by_order(const std::string_view &line, Handler &handler) {
+  Fields fields(line);
+  std::string_view type, timestamp, exchange, symbol, snapshot, side, price, quantity, action,
+      order_id;
+  std::chrono::nanoseconds timestamp_utc;
+  bool is_snapshot;
+  Side mbo_side;
+  MBOUpdate mbo_update{
+      .price = NaN,
+      .remaining_quantity = NaN,
+      .action = {},
+      .priority = {},
+      .order_id = {},
+  };
+  if (!(fields.next(type) && fields.next(timestamp) && fields.next(exchange) &&
+        fields.next(symbol) && fields.next(snapshot) && fields.next(side) && fields.next(price) &&
+        fields.next(quantity) && fields.next(action) && fields.next(order_id) &&
+        !order_id.empty() && parse_timestamp(timestamp, timestamp_utc) &&
+        parse_bool(snapshot, is_snapshot) && parse_side(side, mbo_side) &&
+        parse_decimal(price, mbo_update.price) &&
+        parse_decimal(quantity, mbo_update.remaining_quantity) &&
+        parse_action(action, mbo_update.action)))
+    throw RuntimeErrorException(
+        R"(Invalid market by order: path="{}", line_number={}, line="{}")"_fmt,
+        path_,
+        line_number_,
+        line);
+  mbo_update.order_id = order_id;
+  if (pending_ != Pending::MARKET_BY_ORDER || timestamp_utc != timestamp_ ||
+      snapshot_ != is_snapshot || exchange_.compare(exchange) != 0 ||
+      symbol_.compare(symbol) != 0) {
+    flush(handler);
+    pending_ = Pending::MARKET_BY_ORDER;
+    timestamp_ = timestamp_utc;
+    exchange_ = exchange;
+    symbol_ = symbol;
+    snapshot_ = is_snapshot;
+  }
+  if (mbo_side == Side::BUY)
+    mbo_bids_.emplace_back(mbo_update);
+  else
+    mbo_asks_.emplace_back(mbo_update);
+}
+
+void CSVReader::parse_trade(const std::string_view &line, Handler &handler) {
+  Fields fields(line);
+  std::string_view type, timestamp, exchange, symbol, side, price, quantity, trade_id;
+  std::chrono::nanoseconds timestamp_utc;
+  Trade trade{
+      .side = {},
+      .price = NaN,
+      .quantity = NaN,
+      .trade_id = {},
+  };
+  if (!(fields.next(type) && fields.next(timestamp) && fields.next(exchange) &&
+        fields.next(symbol) && fields.next(side) && fields.next(price) && fields.next(quantity) &&
+        fields.next(trade_id) && parse_timestamp(timestamp, timestamp_utc) &&
+        parse_side(side, trade.side) && parse_decimal(price, trade.price) &&
+        parse_decimal(quantity, trade.quantity)))
+    throw RuntimeErrorException(
+        R"(Invalid trade: path="{}", line_number={}, line="{}")"_fmt,
+        path_,
+        line_number_,
+        line);
+  trade.trade_id = trade_id;
+  if (pending_ != Pending::TRADE_SUMMARY || timestamp_utc != timestamp_ ||
+      exchange_.compare(exchange) != 0 || symbol_.compare(symbol) != 0) {
+    flush(handler);
+    pending_ = Pending::TRADE_SUMMARY;
+    timestamp_ = timestamp_utc;
+    exchange_ = exchange;
+    symbol_ = symbol;
+  }
+  trades_.emplace_back(trade);
+}
+
+void CSVReader::flush(Handler &handler) {
+  switch (pending_) {
+    case Pending::NONE:
+      return;
+    case Pending::MARKET_BY_PRICE:
+      handler(
+          MarketByPriceUpdate{
+              .stream_id = {},
+              .exchange = exchange_,
+              .symbol = symbol_,
+              .bids = {bids_.data(), bids_.size()},
+              .asks = {asks_.data(), asks_.size()},
+              .snapshot = snapshot_,
+              .exchange_time_utc = timestamp_,
+          },
+          timestamp_);
+      bids_.clear();
+      asks_.clear();
+      break;
+    case Pending::MARKET_BY_ORDER:
+      handler(
+          MarketByOrderUpdate{
+              .stream_id = {},
+              .exchange = exchange_,
+              .symbol = symbol_,
+              .bids = {mbo_bids_.data(), mbo_bids_.size()},
+              .asks = {mbo_asks_.data(), mbo_asks_.size()},
+              .snapshot = snapshot_,
+              .exchange_time_utc = timestamp_,
+          },
+          timestamp_);
+      mbo_bids_.clear();
+      mbo_asks_.clear();
+      break;
+    case Pending::TRADE_SUMMARY:
+      handler(
+          TradeSummary{
+              .stream_id = {},
+              .exchange = exchange_,
+              .symbol = symbol_,
+              .trades = {trades_.data(), trades_.size()},
+              .exchange_time_utc = timestamp_,
+          },
+          timestamp_);
+      trades_.clear();
+      break;
+  }
+  pending_ = Pending::NONE;
+}
+
+}  // namespace import
+}  // namespace samples
+}  // namespace roq
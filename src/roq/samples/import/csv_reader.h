@@ -0,0 +1,112 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#pragma once
+
+#include <chrono>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "roq/api.h"
+
+#include "roq/samples/import/handler.h"
+#include "roq/samples/import/mapped_file.h"
+#include "roq/samples/import/validator.h"
+
+namespace roq {
+namespace samples {
+namespace import {
+
+// streaming reader for delimited tick files
+//
+// one message per line, fields separated by comma
+//
+//   R,timestamp,exchange,symbol,tick_size,multiplier,min_trade_vol
+//   S,timestamp,exchange,symbol,trading_status
+//   P,timestamp,exchange,symbol,snapshot,side,price,quantity
+//   O,timestamp,exchange,symbol,snapshot,side,price,quantity,action,order_id
+//   T,timestamp,exchange,symbol,side,price,quantity,trade_id
+//
+// timestamp is nanoseconds since epoch (UTC)
+// consecutive P (O or T) lines sharing timestamp, exchange and symbol
+// (and snapshot) are grouped into a single MarketByPriceUpdate
+// (MarketByOrderUpdate or TradeSummary)
+// empty lines and lines starting with '#' are ignored
+//
+// note!
+//   the file is memory-mapped and all string fields are passed downstream
+//   as views into the mapping (zero-copy)
+//
+// sharding
+//   shard() assigns a line to a shard by hash(symbol) % shard_count
+//
+// validation
+//   all lines are prefixed by channel and vendor sequence number
+//
+//     channel,seqno,<message>
+//
+//   and only lines accepted by the validator are dispatched
+//
+// push
+//   lines are not read from a file but pushed by the caller (e.g. the
+//   external sort or the splitter), the caller must flush after the last line
+
+class CSVReader final {
+ public:
+  explicit CSVReader(const std::string_view &path);
+  CSVReader(const std::string_view &path, Validator &);
+
+  struct Push final {};
+  CSVReader(const std::string_view &name, Push);  // note! name is only used for errors
+
+  CSVReader(CSVReader &&) = delete;
+  CSVReader(const CSVReader &) = delete;
+
+  void dispatch(Handler &);
+
+  // push
+  void operator()(const std::string_view &line, Handler &);
+  // note! line_number is from the source (the line may have been routed elsewhere)
+  void operator()(const std::string_view &line, uint64_t line_number, Handler &);
+  void flush(Handler &);
+
+  // note! lines without a valid message type are assigned to the first shard
+  static size_t shard(const std::string_view &line, size_t shard_count);
+
+ protected:
+  void parse(const std::string_view &line, Handler &);
+  void parse_message(const std::string_view &line, Handler &);
+
+  void parse_reference_data(const std::string_view &line, Handler &);
+  void parse_market_status(const std::string_view &line, Handler &);
+  void parse_market_by_price(const std::string_view &line, Handler &);
+  void parse_market_by_order(const std::string_view &line, Handler &);
+  void parse_trade(const std::string_view &line, Handler &);
+
+ private:
+  const std::string_view path_;
+  Validator *const validator_ = nullptr;
+  std::optional<MappedFile> file_;  // note! not used when lines are pushed
+  uint64_t line_number_ = {};
+  // pending (grouped) message
+  enum class Pending {
+    NONE,
+    MARKET_BY_PRICE,
+    MARKET_BY_ORDER,
+    TRADE_SUMMARY,
+  } pending_ = Pending::NONE;
+  std::chrono::nanoseconds timestamp_ = {};
+  std::string_view exchange_;
+  std::string_view symbol_;
+  bool snapshot_ = false;
+  // note! re-used to avoid allocations
+  std::vector<MBPUpdate> bids_;
+  std::vector<MBPUpdate> asks_;
+  std::vector<MBOUpdate> mbo_bids_;
+  std::vector<MBOUpdate> mbo_asks_;
+  std::vector<Trade> trades_;
+};
+
+}  // namespace import
+}  // namespace samples
+}  // namespace roq
@@ -0,0 +1,126 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#include "roq/samples/import/decompressor.h"
+
+#include <lz4.h>
+
+#include <cstring>
+#include <new>
+
+#include "roq/exceptions.h"
+
+using namespace roq::literals;
+
+namespace roq {
+namespace samples {
+namespace import {
+
+namespace {
+template <typename T>
+T read(const std::string_view &data, size_t offset) {
+  T result;
+  std::memcpy(&result, data.data() + offset, sizeof(T));
+  return result;
+}
+}  // namespace
+
+Decompressor::Decompressor(const std::string_view &data) : data_(data) {
+  if (!is_compressed(data_))
+    throw RuntimeErrorException("Unexpected: not a compressed stream"_sv);
+  auto offset = sizeof(CODEC_MAGIC);
+  codec_ = static_cast<Codec>(read<uint32_t>(data_, offset));
+  offset += sizeof(uint32_t);
+  auto dictionary_size = read<uint32_t>(data_, offset);
+  offset += sizeof(uint32_t);
+  if (offset + dictionary_size > data_.size())
+    throw RuntimeErrorException("Truncated dictionary"_sv);
+  dictionary_ = data_.substr(offset, dictionary_size);
+  offset_ = offset + dictionary_size;
+  switch (codec_) {
+    case Codec::LZ4:
+      break;
+    case Codec::ZSTD:
+      zstd_context_ = ZSTD_createDCtx();
+      if (zstd_context_ == nullptr)
+        throw std::bad_alloc();
+      if (!dictionary_.empty()) {
+        zstd_dictionary_ = ZSTD_createDDict(dictionary_.data(), dictionary_.size());
+        if (zstd_dictionary_ == nullptr)
+          throw std::bad_alloc();
+      }
+      break;
+    default:
+      throw RuntimeErrorException(R"(Unknown codec={})"_fmt, static_cast<uint32_t>(codec_));
+  }
+}
+
+Decompressor::~Decompressor() {
+  if (zstd_dictionary_)
+    ZSTD_freeDDict(zstd_dictionary_);
+  if (zstd_context_)
+    ZSTD_freeDCtx(zstd_context_);
+}
+
+bool Decompressor::is_compressed(const std::string_view &data) {
+  return data.size() >= CODEC_HEADER_SIZE &&
+         std::memcmp(data.data(), CODEC_MAGIC, sizeof(CODEC_MAGIC)) == 0;
+}
+
+bool Decompressor::next(std::string_view &frames) {
+  if (offset_ >= data_.size())
+    return false;
+  if (offset_ + sizeof(BlockHeader) > data_.size())
+    throw RuntimeErrorException("Truncated block header: offset={}"_fmt, offset_);
+  auto header = read<BlockHeader>(data_, offset_);
+  auto source = data_.data() + offset_ + sizeof(BlockHeader);
+  if (offset_ + sizeof(BlockHeader) + header.compressed_size > data_.size())
+    throw RuntimeErrorException("Truncated block: offset={}"_fmt, offset_);
+  buffer_.resize(header.uncompressed_size);
+  size_t result = 0;
+  switch (codec_) {
+    case Codec::LZ4: {
+      auto length = LZ4_decompress_safe_usingDict(
+          source,
+          buffer_.data(),
+          static_cast<int>(header.compressed_size),
+          static_cast<int>(header.uncompressed_size),
+          dictionary_.data(),
+          static_cast<int>(dictionary_.size()));
+      if (length < 0)
+        throw RuntimeErrorException("Unable to decompress (lz4): offset={}"_fmt, offset_);
+      result = static_cast<size_t>(length);
+      break;
+    }
+    case Codec::ZSTD: {
+      result = zstd_dictionary_ != nullptr
+                   ? ZSTD_decompress_usingDDict(
+                         zstd_context_,
+                         buffer_.data(),
+                         buffer_.size(),
+                         source,
+                         header.compressed_size,
+                         zstd_dictionary_)
+                   : ZSTD_decompressDCtx(
+                         zstd_context_,
+                         buffer_.data(),
+                         buffer_.size(),
+                         source,
+                         header.compressed_size);
+      if (ZSTD_isError(result))
+        throw RuntimeErrorException(
+            R"(Unable to decompress (zstd): offset={}, error="{}")"_fmt,
+            offset_,
+            ZSTD_getErrorName(result));
+      break;
+    }
+  }
+  if (result != header.uncompressed_size)
+    throw RuntimeErrorException("Unexpected block size: offset={}"_fmt, offset_);
+  offset_ += sizeof(BlockHeader) + header.compressed_size;
+  frames = std::string_view(buffer_.data(), buffer_.size());
+  return true;
+}
+
+}  // namespace import
+}  // namespace samples
+}  // namespace roq
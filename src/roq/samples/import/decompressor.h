@@ -0,0 +1,54 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#pragma once
+
+#include <zstd.h>
+
+#include <string_view>
+#include <vector>
+
+#include "roq/samples/import/codec.h"
+
+namespace roq {
+namespace samples {
+namespace import {
+
+// streaming decompression of a block-compressed stream (see codec.h)
+//
+// only one block is inflated at a time, so memory usage is bounded by
+// the block size (never by the size of the stream)
+
+class Decompressor final {
+ public:
+  explicit Decompressor(const std::string_view &data);
+
+  Decompressor(Decompressor &&) = delete;
+  Decompressor(const Decompressor &) = delete;
+
+  ~Decompressor();
+
+  static bool is_compressed(const std::string_view &data);
+
+  // returns false when there are no more blocks
+  // note! frames are only valid until the next call
+  bool next(std::string_view &frames);
+
+  // offset (into data) of the next block
+  size_t offset() const { return offset_; }
+
+  // continue from a block boundary
+  void seek(size_t offset) { offset_ = offset; }
+
+ private:
+  const std::string_view data_;
+  Codec codec_ = {};
+  std::string_view dictionary_;
+  size_t offset_ = {};
+  std::vector<char> buffer_;
+  ZSTD_DCtx *zstd_context_ = nullptr;
+  ZSTD_DDict *zstd_dictionary_ = nullptr;
+};
+
+}  // namespace import
+}  // namespace samples
+}  // namespace roq
@@ -0,0 +1,71 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#include "roq/samples/import/encoder.h"
+
+namespace roq {
+namespace samples {
+namespace import {
+
+Encoder::Encoder(size_t initial_size) : builder_(initial_size) {
+}
+
+template <typename R, typename T>
+flatbuffers::Offset<flatbuffers::Vector<R>> Encoder::encode(
+    std::vector<R> &offsets, const T &values) {
+  offsets.clear();
+  for (auto &item : values)
+    offsets.emplace_back(fbs::encode(builder_, item));
+  return builder_.CreateVector(offsets.data(), offsets.size());
+}
+
+flatbuffers::Offset<flatbuffers::String> Encoder::encode(const std::string_view &value) {
+  return builder_.CreateString(value.data(), value.size());
+}
+
+flatbuffers::Offset<fbs::Event> Encoder::encode(const Event<MarketByOrderUpdate> &event) {
+  auto &value = event.value;
+  // note! children must be complete before a table is started
+  auto message_info = fbs::encode(builder_, event.message_info);
+  auto exchange = encode(value.exchange);
+  auto symbol = encode(value.symbol);
+  auto bids = encode(bids_, value.bids);
+  auto asks = encode(asks_, value.asks);
+  fbs::MarketByOrderUpdateBuilder message(builder_);
+  message.add_stream_id(value.stream_id);
+  message.add_exchange(exchange);
+  message.add_symbol(symbol);
+  message.add_bids(bids);
+  message.add_asks(asks);
+  message.add_snapshot(value.snapshot);
+  message.add_exchange_time_utc(value.exchange_time_utc.count());
+  auto result = message.Finish();
+  fbs::EventBuilder root(builder_);
+  root.add_message_info(message_info);
+  root.add_message_type(fbs::Message::MarketByOrderUpdate);
+  root.add_message(result.Union());
+  return root.Finish();
+}
+
+flatbuffers::Offset<fbs::Event> Encoder::encode(const Event<TradeSummary> &event) {
+  auto &value = event.value;
+  auto message_info = fbs::encode(builder_, event.message_info);
+  auto exchange = encode(value.exchange);
+  auto symbol = encode(value.symbol);
+  auto trades = encode(trades_, value.trades);
+  fbs::TradeSummaryBuilder message(builder_);
+  message.add_stream_id(value.stream_id);
+  message.add_exchange(exchange);
+  message.add_symbol(symbol);
+  message.add_trades(trades);
+  message.add_exchange_time_utc(value.exchange_time_utc.count());
+  auto result = message.Finish();
+  fbs::EventBuilder root(builder_);
+  root.add_message_info(message_info);
+  root.add_message_type(fbs::Message::TradeSummary);
+  root.add_message(result.Union());
+  return root.Finish();
+}
+
+}  // namespace import
+}  // namespace samples
+}  // namespace roq
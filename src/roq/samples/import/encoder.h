@@ -0,0 +1,73 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#pragma once
+
+#include <flatbuffers/flatbuffers.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "roq/api.h"
+
+#include "roq/fbs/api.h"
+#include "roq/fbs/encode.h"
+
+namespace roq {
+namespace samples {
+namespace import {
+
+// encodes an event as a (size-prefixed) frame
+//
+// note!
+//   the builder is re-used and its buffer only grows
+//   MarketByOrderUpdate and TradeSummary are the high-volume messages, their
+//   element offsets are collected in re-used storage (fbs::encode would
+//   otherwise allocate a temporary vector for every event)
+
+class Encoder final {
+ public:
+  static constexpr size_t INITIAL_SIZE = 65536;
+
+  explicit Encoder(size_t initial_size = INITIAL_SIZE);
+
+  Encoder(Encoder &&) = delete;
+  Encoder(const Encoder &) = delete;
+
+  template <typename T>
+  void operator()(const Event<T> &event) {
+    builder_.Clear();
+    auto root = encode(event);
+    builder_.FinishSizePrefixed(root);  // note! *must* include size
+  }
+
+  // the frame is valid until the next event is encoded
+  uint8_t const *data() const { return builder_.GetBufferPointer(); }
+  size_t size() const { return builder_.GetSize(); }
+
+ protected:
+  template <typename T>
+  flatbuffers::Offset<fbs::Event> encode(const Event<T> &event) {
+    return fbs::encode(builder_, event);
+  }
+
+  flatbuffers::Offset<fbs::Event> encode(const Event<MarketByOrderUpdate> &);
+  flatbuffers::Offset<fbs::Event> encode(const Event<TradeSummary> &);
+
+  template <typename R, typename T>
+  flatbuffers::Offset<flatbuffers::Vector<R>> encode(std::vector<R> &offsets, const T &values);
+
+  flatbuffers::Offset<flatbuffers::String> encode(const std::string_view &);
+
+ private:
+  flatbuffers::FlatBufferBuilder builder_;
+  // note! re-used to avoid allocations
+  std::vector<flatbuffers::Offset<fbs::MBOUpdate>> bids_;
+  std::vector<flatbuffers::Offset<fbs::MBOUpdate>> asks_;
+  std::vector<flatbuffers::Offset<fbs::Trade>> trades_;
+};
+
+}  // namespace import
+}  // namespace samples
+}  // namespace roq
@@ -10,7 +10,217 @@ ABSL_FLAG(  //
     std::string,
     encoding,
     "binary",
-    "encoding type -- one of binary or base64");
+    "encoding type -- one of binary, base64, lz4 or zstd");
+
+ABSL_FLAG(  //
+    std::string,
+    format,
+    "csv",
+    "input format -- one of csv, deribit or coinbase (json lines)");
+
+ABSL_FLAG(  //
+    uint32_t,
+    mbp_max_depth,
+    0u,
+    "max depth published with GatewaySettings (0 means unlimited)");
+
+ABSL_FLAG(  //
+    uint32_t,
+    block_size,
+    1048576u,
+    "output block size (bytes, multiple of 4096)");
+
+ABSL_FLAG(  //
+    bool,
+    direct_io,
+    false,
+    "bypass the page cache when writing (O_DIRECT)");
+
+ABSL_FLAG(  //
+    uint64_t,
+    preallocate,
+    0u,
+    "pre-allocate disk space for the output file (bytes)");
+
+ABSL_FLAG(  //
+    uint32_t,
+    threads,
+    1u,
+    "number of worker threads (parallel import when more than 1)");
+
+ABSL_FLAG(  //
+    std::string,
+    shard_by,
+    "file",
+    "parallel import sharding -- one of file or symbol");
+
+ABSL_FLAG(  //
+    bool,
+    batching,
+    true,
+    "group messages sharing the same timestamp into one batch (is_last)");
+
+ABSL_FLAG(  //
+    int32_t,
+    compression_level,
+    0,
+    "compression level (lz4: acceleration, zstd: level, 0 means default)");
+
+ABSL_FLAG(  //
+    uint32_t,
+    compression_block_size,
+    131072,
+    "uncompressed size of each compressed block (lz4/zstd)");
+
+ABSL_FLAG(  //
+    uint32_t,
+    dictionary_samples,
+    10000,
+    "number of frames used to train the dictionary (lz4/zstd, 0 to disable)");
+
+ABSL_FLAG(  //
+    uint32_t,
+    dictionary_size,
+    65536,
+    "maximum dictionary size (lz4/zstd)");
+
+ABSL_FLAG(  //
+    bool,
+    decompress,
+    false,
+    "decompress (lz4/zstd) input files to binary output");
+
+ABSL_FLAG(  //
+    uint64_t,
+    generate,
+    0,
+    "generate synthetic market data (number of events, 0 to disable)");
+
+ABSL_FLAG(  //
+    uint32_t,
+    generate_symbols,
+    100,
+    "number of symbols (synthetic)");
+
+ABSL_FLAG(  //
+    double,
+    generate_rate,
+    100000.0,
+    "mean number of events per second (synthetic, poisson)");
+
+ABSL_FLAG(  //
+    double,
+    generate_skew,
+    1.0,
+    "zipf exponent of symbol activity (synthetic, 0 means uniform)");
+
+ABSL_FLAG(  //
+    uint32_t,
+    generate_depth,
+    5,
+    "book depth (synthetic)");
+
+ABSL_FLAG(  //
+    double,
+    generate_trade_ratio,
+    0.1,
+    "ratio of events being trades (synthetic)");
+
+ABSL_FLAG(  //
+    double,
+    generate_mbo_ratio,
+    0.2,
+    "ratio of events being market by order updates (synthetic)");
+
+ABSL_FLAG(  //
+    uint64_t,
+    generate_seed,
+    1,
+    "random seed (synthetic)");
+
+ABSL_FLAG(  //
+    bool,
+    summary,
+    false,
+    "print a summary of existing file(s) instead of importing");
+
+ABSL_FLAG(  //
+    bool,
+    verify,
+    false,
+    "run the flatbuffers verifier on each frame (with --summary)");
+
+ABSL_FLAG(  //
+    uint32_t,
+    index_interval,
+    60,
+    "seconds between checkpoints of the time index (sidecar file, 0 to disable)");
+
+ABSL_FLAG(  //
+    int64_t,
+    start_time_utc,
+    0,
+    "only include messages received at or after this time (nanoseconds since epoch)");
+
+ABSL_FLAG(  //
+    int64_t,
+    end_time_utc,
+    0,
+    "only include messages received before this time (nanoseconds since epoch, 0 means no limit)");
+
+ABSL_FLAG(  //
+    uint32_t,
+    snapshot_interval,
+    0,
+    "seconds between injected book snapshots (0 to disable)");
+
+ABSL_FLAG(  //
+    uint64_t,
+    snapshot_events,
+    0,
+    "number of events between injected book snapshots (0 to disable)");
+
+ABSL_FLAG(  //
+    bool,
+    validate,
+    false,
+    "input lines are prefixed by channel and seqno (drop duplicates, detect gaps)");
+
+ABSL_FLAG(  //
+    uint32_t,
+    validate_window,
+    65536,
+    "number of recent sequence numbers remembered per channel (duplicate detection)");
+
+ABSL_FLAG(  //
+    bool,
+    gap_markers,
+    false,
+    "write a snapshot request marker for each gap (to a .gaps file next to the output)");
+
+ABSL_FLAG(  //
+    bool,
+    sort,
+    false,
+    "sort input lines by timestamp (external merge sort, for unordered inputs)");
+
+ABSL_FLAG(  //
+    uint64_t,
+    sort_run_size,
+    1073741824,
+    "maximum number of input bytes sorted in memory (per thread)");
+
+ABSL_FLAG(  //
+    bool,
+    pipeline,
+    false,
+    "parse, encode and write on separate threads (pipeline)");
+
+ABSL_FLAG(  //
+    uint32_t,
+    pipeline_frames,
+    4096u,
+    "number of frames queued between the parse and encode stages (power of two)");
 
 namespace roq {
 namespace samples {
@@ -22,6 +232,181 @@ std::string_view Flags::encoding() {
   return result;
 }
 
+std::string_view Flags::format() {
+  static const std::string result = absl::GetFlag(FLAGS_format);
+  return result;
+}
+
+uint32_t Flags::mbp_max_depth() {
+  static const uint32_t result = absl::GetFlag(FLAGS_mbp_max_depth);
+  return result;
+}
+
+uint32_t Flags::block_size() {
+  static const uint32_t result = absl::GetFlag(FLAGS_block_size);
+  return result;
+}
+
+bool Flags::direct_io() {
+  static const bool result = absl::GetFlag(FLAGS_direct_io);
+  return result;
+}
+
+uint64_t Flags::preallocate() {
+  static const uint64_t result = absl::GetFlag(FLAGS_preallocate);
+  return result;
+}
+
+uint32_t Flags::threads() {
+  static const uint32_t result = absl::GetFlag(FLAGS_threads);
+  return result;
+}
+
+std::string_view Flags::shard_by() {
+  static const std::string result = absl::GetFlag(FLAGS_shard_by);
+  return result;
+}
+
+bool Flags::batching() {
+  static const bool result = absl::GetFlag(FLAGS_batching);
+  return result;
+}
+
+int32_t Flags::compression_level() {
+  static const int32_t result = absl::GetFlag(FLAGS_compression_level);
+  return result;
+}
+
+uint32_t Flags::compression_block_size() {
+  static const uint32_t result = absl::GetFlag(FLAGS_compression_block_size);
+  return result;
+}
+
+uint32_t Flags::dictionary_samples() {
+  static const uint32_t result = absl::GetFlag(FLAGS_dictionary_samples);
+  return result;
+}
+
+uint32_t Flags::dictionary_size() {
+  static const uint32_t result = absl::GetFlag(FLAGS_dictionary_size);
+  return result;
+}
+
+bool Flags::decompress() {
+  static const bool result = absl::GetFlag(FLAGS_decompress);
+  return result;
+}
+
+uint64_t Flags::generate() {
+  static const uint64_t result = absl::GetFlag(FLAGS_generate);
+  return result;
+}
+
+uint32_t Flags::generate_symbols() {
+  static const uint32_t result = absl::GetFlag(FLAGS_generate_symbols);
+  return result;
+}
+
+double Flags::generate_rate() {
+  static const double result = absl::GetFlag(FLAGS_generate_rate);
+  return result;
+}
+
+double Flags::generate_skew() {
+  static const double result = absl::GetFlag(FLAGS_generate_skew);
+  return result;
+}
+
+uint32_t Flags::generate_depth() {
+  static const uint32_t result = absl::GetFlag(FLAGS_generate_depth);
+  return result;
+}
+
+double Flags::generate_trade_ratio() {
+  static const double result = absl::GetFlag(FLAGS_generate_trade_ratio);
+  return result;
+}
+
+double Flags::generate_mbo_ratio() {
+  static const double result = absl::GetFlag(FLAGS_generate_mbo_ratio);
+  return result;
+}
+
+uint64_t Flags::generate_seed() {
+  static const uint64_t result = absl::GetFlag(FLAGS_generate_seed);
+  return result;
+}
+
+bool Flags::summary() {
+  static const bool result = absl::GetFlag(FLAGS_summary);
+  return result;
+}
+
+bool Flags::verify() {
+  static const bool result = absl::GetFlag(FLAGS_verify);
+  return result;
+}
+
+uint32_t Flags::index_interval() {
+  static const uint32_t result = absl::GetFlag(FLAGS_index_interval);
+  return result;
+}
+
+int64_t Flags::start_time_utc() {
+  static const int64_t result = absl::GetFlag(FLAGS_start_time_utc);
+  return result;
+}
+
+int64_t Flags::end_time_utc() {
+  static const int64_t result = absl::GetFlag(FLAGS_end_time_utc);
+  return result;
+}
+
+uint32_t Flags::snapshot_interval() {
+  static const uint32_t result = absl::GetFlag(FLAGS_snapshot_interval);
+  return result;
+}
+
+uint64_t Flags::snapshot_events() {
+  static const uint64_t result = absl::GetFlag(FLAGS_snapshot_events);
+  return result;
+}
+
+bool Flags::validate() {
+  static const bool result = absl::GetFlag(FLAGS_validate);
+  return result;
+}
+
+uint32_t Flags::validate_window() {
+  static const uint32_t result = absl::GetFlag(FLAGS_validate_window);
+  return result;
+}
+
+bool Flags::gap_markers() {
+  static const bool result = absl::GetFlag(FLAGS_gap_markers);
+  return result;
+}
+
+bool Flags::sort() {
+  static const bool result = absl::GetFlag(FLAGS_sort);
+  return result;
+}
+
+uint64_t Flags::sort_run_size() {
+  static const uint64_t result = absl::GetFlag(FLAGS_sort_run_size);
+  return result;
+}
+
+bool Flags::pipeline() {
+  static const bool result = absl::GetFlag(FLAGS_pipeline);
+  return result;
+}
+
+uint32_t Flags::pipeline_frames() {
+  static const uint32_t result = absl::GetFlag(FLAGS_pipeline_frames);
+  return result;
+}
+
 }  // namespace flags
 }  // namespace import
 }  // namespace samples
@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string_view>
 
 namespace roq {
@@ -11,6 +12,41 @@ namespace flags {
 
 struct Flags final {
   static std::string_view encoding();
+  static std::string_view format();
+  static uint32_t mbp_max_depth();
+  static uint32_t block_size();
+  static bool direct_io();
+  static uint64_t preallocate();
+  static uint32_t threads();
+  static std::string_view shard_by();
+  static bool batching();
+  static int32_t compression_level();
+  static uint32_t compression_block_size();
+  static uint32_t dictionary_samples();
+  static uint32_t dictionary_size();
+  static bool decompress();
+  static uint64_t generate();
+  static uint32_t generate_symbols();
+  static double generate_rate();
+  static double generate_skew();
+  static uint32_t generate_depth();
+  static double generate_trade_ratio();
+  static double generate_mbo_ratio();
+  static uint64_t generate_seed();
+  static bool summary();
+  static bool verify();
+  static uint32_t index_interval();
+  static int64_t start_time_utc();
+  static int64_t end_time_utc();
+  static uint32_t snapshot_interval();
+  static uint64_t snapshot_events();
+  static bool validate();
+  static uint32_t validate_window();
+  static bool gap_markers();
+  static bool sort();
+  static uint64_t sort_run_size();
+  static bool pipeline();
+  static uint32_t pipeline_frames();
 };
 
 }  // namespace flags
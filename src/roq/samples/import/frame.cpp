@@ -0,0 +1,28 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#include "roq/samples/import/frame.h"
+
+#include "roq/exceptions.h"
+
+using namespace roq::literals;
+
+namespace roq {
+namespace samples {
+namespace import {
+
+void Frame::set_source_seqno(void *data, uint64_t source_seqno) {
+  if (!message_info(data).SetField<uint64_t>(
+          fbs::MessageInfo::VT_SOURCE_SEQNO, source_seqno, uint64_t{}))
+    throw RuntimeErrorException("Unable to patch source_seqno"_sv);
+}
+
+void Frame::set_is_last(void *data, bool is_last) {
+  // note! flatbuffers stores bool as uint8_t
+  if (!message_info(data).SetField<uint8_t>(
+          fbs::MessageInfo::VT_IS_LAST, is_last ? 1 : 0, uint8_t{}))
+    throw RuntimeErrorException("Unable to patch is_last"_sv);
+}
+
+}  // namespace import
+}  // namespace samples
+}  // namespace roq
@@ -0,0 +1,56 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#pragma once
+
+#include <flatbuffers/flatbuffers.h>
+
+#include <chrono>
+#include <cstdint>
+
+#include "roq/fbs/api.h"
+
+namespace roq {
+namespace samples {
+namespace import {
+
+// helpers to inspect (and patch) an encoded size-prefixed frame
+// note!
+//   patching is only possible for fields already present in the buffer
+//   (flatbuffers does not store fields having the default value)
+
+class Frame final {
+ public:
+  static constexpr size_t PREFIX_SIZE = sizeof(flatbuffers::uoffset_t);
+
+  // total length (including the size prefix)
+  static size_t length(void const *data) {
+    return PREFIX_SIZE + flatbuffers::ReadScalar<flatbuffers::uoffset_t>(data);
+  }
+
+  static const fbs::Event &event(void const *data) {
+    return *flatbuffers::GetSizePrefixedRoot<fbs::Event>(data);
+  }
+
+  static fbs::Message type(void const *data) { return event(data).message_type(); }
+
+  static uint64_t source_seqno(void const *data) {
+    return event(data).message_info()->source_seqno();
+  }
+
+  static std::chrono::nanoseconds receive_time_utc(void const *data) {
+    return std::chrono::nanoseconds{event(data).message_info()->receive_time_utc()};
+  }
+
+  static void set_source_seqno(void *data, uint64_t source_seqno);
+
+  static void set_is_last(void *data, bool is_last);
+
+ protected:
+  static fbs::MessageInfo &message_info(void *data) {
+    return *const_cast<fbs::MessageInfo *>(event(data).message_info());
+  }
+};
+
+}  // namespace import
+}  // namespace samples
+}  // namespace roq
@@ -0,0 +1,360 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#include "roq/samples/import/generator.h"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "roq/exceptions.h"
+#include "roq/logging.h"
+
+#include "roq/samples/import/flags.h"
+
+using namespace std::chrono_literals;
+using namespace roq::literals;
+
+namespace roq {
+namespace samples {
+namespace import {
+
+namespace {
+static const auto EXCHANGE = "SIM"_sv;
+static const auto TICK_SIZE = 0.01;
+static const auto MULTIPLIER = 1.0;
+static const auto MIN_TRADE_VOL = 1.0;
+static const auto MAX_QUANTITY = 100u;
+static const int64_t INITIAL_MID = 10000;  // ticks
+static const auto MOVE_PROBABILITY = 0.05;  // per market by price update
+static const auto MAX_ORDERS = 64u;        // per symbol (mbo)
+static const auto START = std::chrono::nanoseconds{1609459200s};  // 2021-01-01T00:00:00Z
+}  // namespace
+
+namespace {
+static double price(int64_t ticks) {
+  return static_cast<double>(ticks) * TICK_SIZE;
+}
+}  // namespace
+
+Generator::Generator()
+    : Generator(Config{
+          .seed = Flags::generate_seed(),
+          .events = Flags::generate(),
+          .symbols = Flags::generate_symbols(),
+          .rate = Flags::generate_rate(),
+          .skew = Flags::generate_skew(),
+          .depth = Flags::generate_depth(),
+          .trade_ratio = Flags::generate_trade_ratio(),
+          .mbo_ratio = Flags::generate_mbo_ratio(),
+      }) {
+}
+
+Generator::Generator(const Config &config)
+    : random_(config.seed), events_(config.events), interval_(1.0e9 / config.rate),
+      depth_(config.depth), trade_ratio_(config.trade_ratio), mbo_ratio_(config.mbo_ratio) {
+  auto count = config.symbols;
+  if (count == 0)
+    throw RuntimeErrorException("Expected --generate_symbols > 0"_sv);
+  if (!(config.rate > 0.0))
+    throw RuntimeErrorException("Expected --generate_rate > 0"_sv);
+  if (depth_ == 0)
+    throw RuntimeErrorException("Expected --generate_depth > 0"_sv);
+  if ((trade_ratio_ + mbo_ratio_) > 1.0)
+    throw RuntimeErrorException("Expected --generate_trade_ratio + --generate_mbo_ratio <= 1"_sv);
+  symbols_.resize(count);
+  cdf_.reserve(count);
+  double sum = 0.0;
+  for (size_t i = 0; i < count; ++i) {
+    auto &symbol = symbols_[i];
+    symbol.name = fmt::format("SYM{:05}", i);
+    symbol.mid = INITIAL_MID;
+    symbol.orders.reserve(MAX_ORDERS);
+    sum += 1.0 / std::pow(static_cast<double>(i + 1), config.skew);
+    cdf_.emplace_back(sum);
+  }
+  for (auto &value : cdf_)
+    value /= sum;
+  bids_.reserve(depth_);
+  asks_.reserve(depth_);
+  mbo_bids_.reserve(MAX_ORDERS);
+  mbo_asks_.reserve(MAX_ORDERS);
+  order_ids_.resize(MAX_ORDERS);
+}
+
+void Generator::dispatch(Handler &handler) {
+  auto timestamp_utc = START;
+  initialize(handler, timestamp_utc);
+  auto start = std::chrono::steady_clock::now();
+  for (uint64_t i = 0; i < events_; ++i) {
+    // note! truncation means some events share the same timestamp (batching)
+    timestamp_utc += std::chrono::nanoseconds{static_cast<int64_t>(random_.exponential(interval_))};
+    auto &symbol = next_symbol();
+    auto choice = random_.uniform();
+    if (choice < trade_ratio_)
+      trade_summary(handler, symbol, timestamp_utc);
+    else if (choice < (trade_ratio_ + mbo_ratio_))
+      market_by_order(handler, symbol, timestamp_utc);
+    else
+      market_by_price(handler, symbol, timestamp_utc);
+  }
+  auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+  log::info(
+      "Generated {} event(s) in {:.3f}s ({:.1f}M events/s)"_fmt,
+      events_,
+      elapsed.count(),
+      elapsed.count() > 0.0 ? 1.0e-6 * events_ / elapsed.count() : 0.0);
+}
+
+void Generator::initialize(Handler &handler, std::chrono::nanoseconds timestamp_utc) {
+  for (auto &symbol : symbols_) {
+    handler(
+        ReferenceData{
+            .stream_id = {},
+            .exchange = EXCHANGE,
+            .symbol = symbol.name,
+            .description = {},
+            .security_type = {},
+            .currency = {},
+            .settlement_currency = {},
+            .commission_currency = {},
+            .tick_size = TICK_SIZE,
+            .multiplier = MULTIPLIER,
+            .min_trade_vol = MIN_TRADE_VOL,
+            .option_type = {},
+            .strike_currency = {},
+            .strike_price = {},
+            .underlying = {},
+            .time_zone = {},
+            .issue_date = {},
+            .settlement_date = {},
+            .expiry_datetime = {},
+            .expiry_datetime_utc = {},
+        },
+        timestamp_utc);
+    handler(
+        MarketStatus{
+            .stream_id = {},
+            .exchange = EXCHANGE,
+            .symbol = symbol.name,
+            .trading_status = TradingStatus::OPEN,
+        },
+        timestamp_utc);
+    // initial image
+    bids_.clear();
+    asks_.clear();
+    for (int64_t i = 0; i < depth_; ++i) {
+      bids_.push_back({.price = price(symbol.mid - 1 - i), .quantity = next_quantity()});
+      asks_.push_back({.price = price(symbol.mid + 1 + i), .quantity = next_quantity()});
+    }
+    handler(
+        MarketByPriceUpdate{
+            .stream_id = {},
+            .exchange = EXCHANGE,
+            .symbol = symbol.name,
+            .bids = bids_,
+            .asks = asks_,
+            .snapshot = true,
+            .exchange_time_utc = timestamp_utc,
+        },
+        timestamp_utc);
+  }
+}
+
+Generator::Symbol &Generator::next_symbol() {
+  auto iter = std::upper_bound(std::begin(cdf_), std::end(cdf_), random_.uniform());
+  auto index = std::min<size_t>(iter - std::begin(cdf_), symbols_.size() - 1);
+  return symbols_[index];
+}
+
+double Generator::next_quantity() {
+  return static_cast<double>(1 + random_.below(MAX_QUANTITY));
+}
+
+// note! one level changes (or the mid price moves one tick)
+void Generator::market_by_price(
+    Handler &handler, Symbol &symbol, std::chrono::nanoseconds timestamp_utc) {
+  if (random_.chance(MOVE_PROBABILITY)) {
+    move(handler, symbol, timestamp_utc);
+    return;
+  }
+  bids_.clear();
+  asks_.clear();
+  auto level = static_cast<int64_t>(random_.below(depth_));
+  if (random_.chance(0.5))
+    bids_.push_back({.price = price(symbol.mid - 1 - level), .quantity = next_quantity()});
+  else
+    asks_.push_back({.price = price(symbol.mid + 1 + level), .quantity = next_quantity()});
+  handler(
+      MarketByPriceUpdate{
+          .stream_id = {},
+          .exchange = EXCHANGE,
+          .symbol = symbol.name,
+          .bids = bids_,
+          .asks = asks_,
+          .snapshot = false,
+          .exchange_time_utc = timestamp_utc,
+      },
+      timestamp_utc);
+}
+
+// churn: new, modify or remove a single order
+void Generator::market_by_order(
+    Handler &handler, Symbol &symbol, std::chrono::nanoseconds timestamp_utc) {
+  auto &orders = symbol.orders;
+  auto action = static_cast<OrderUpdateAction>(
+      static_cast<int>(OrderUpdateAction::NEW) + static_cast<int>(random_.below(3)));
+  if (orders.empty())
+    action = OrderUpdateAction::NEW;
+  else if (orders.size() >= MAX_ORDERS && action == OrderUpdateAction::NEW)
+    action = OrderUpdateAction::REMOVE;
+  size_t index = 0;
+  switch (action) {
+    case OrderUpdateAction::NEW: {
+      auto side = random_.chance(0.5) ? Side::BUY : Side::SELL;
+      auto level = static_cast<int64_t>(random_.below(depth_));
+      orders.push_back({
+          .order_id = ++symbol.next_order_id,
+          .side = side,
+          .price = side == Side::BUY ? symbol.mid - 1 - level : symbol.mid + 1 + level,
+          .quantity = next_quantity(),
+      });
+      index = orders.size() - 1;
+      break;
+    }
+    case OrderUpdateAction::MODIFY:
+      index = random_.below(orders.size());
+      orders[index].quantity = next_quantity();
+      break;
+    default:
+      index = random_.below(orders.size());
+      break;
+  }
+  auto &order = orders[index];
+  auto side = order.side;
+  auto &order_id = order_ids_[0];
+  order_id.assign(fmt::format_int(order.order_id).c_str());
+  MBOUpdate update{
+      .price = price(order.price),
+      .remaining_quantity = action == OrderUpdateAction::REMOVE ? 0.0 : order.quantity,
+      .action = action,
+      .priority = {},
+      .order_id = order_id,
+  };
+  if (action == OrderUpdateAction::REMOVE) {
+    std::swap(order, orders.back());
+    orders.pop_back();
+  }
+  mbo_bids_.clear();
+  mbo_asks_.clear();
+  (side == Side::BUY ? mbo_bids_ : mbo_asks_).push_back(update);
+  handler(
+      MarketByOrderUpdate{
+          .stream_id = {},
+          .exchange = EXCHANGE,
+          .symbol = symbol.name,
+          .bids = mbo_bids_,
+          .asks = mbo_asks_,
+          .snapshot = false,
+          .exchange_time_utc = timestamp_utc,
+      },
+      timestamp_utc);
+}
+
+// note! aggressor trades at the best opposite price
+void Generator::trade_summary(
+    Handler &handler, Symbol &symbol, std::chrono::nanoseconds timestamp_utc) {
+  auto side = random_.chance(0.5) ? Side::BUY : Side::SELL;
+  trade_id_.assign(fmt::format_int(++symbol.next_trade_id).c_str());
+  Trade trade{
+      .side = side,
+      .price = price(side == Side::BUY ? symbol.mid + 1 : symbol.mid - 1),
+      .quantity = next_quantity(),
+      .trade_id = trade_id_,
+  };
+  handler(
+      TradeSummary{
+          .stream_id = {},
+          .exchange = EXCHANGE,
+          .symbol = symbol.name,
+          .trades = {&trade, 1},
+          .exchange_time_utc = timestamp_utc,
+      },
+      timestamp_utc);
+}
+
+// move the mid price one tick
+// note!
+//   the book keeps its depth: one level is added and one level is removed on
+//   each side, and orders which would now cross are removed (mbo)
+void Generator::move(Handler &handler, Symbol &symbol, std::chrono::nanoseconds timestamp_utc) {
+  auto mid = symbol.mid;
+  bids_.clear();
+  asks_.clear();
+  if (random_.chance(0.5)) {
+    bids_.push_back({.price = price(mid), .quantity = next_quantity()});
+    bids_.push_back({.price = price(mid - depth_), .quantity = 0.0});
+    asks_.push_back({.price = price(mid + 1), .quantity = 0.0});
+    asks_.push_back({.price = price(mid + 1 + depth_), .quantity = next_quantity()});
+    ++symbol.mid;
+  } else {
+    bids_.push_back({.price = price(mid - 1), .quantity = 0.0});
+    bids_.push_back({.price = price(mid - 1 - depth_), .quantity = next_quantity()});
+    asks_.push_back({.price = price(mid), .quantity = next_quantity()});
+    asks_.push_back({.price = price(mid + depth_), .quantity = 0.0});
+    --symbol.mid;
+  }
+  handler(
+      MarketByPriceUpdate{
+          .stream_id = {},
+          .exchange = EXCHANGE,
+          .symbol = symbol.name,
+          .bids = bids_,
+          .asks = asks_,
+          .snapshot = false,
+          .exchange_time_utc = timestamp_utc,
+      },
+      timestamp_utc);
+  // mbo
+  mbo_bids_.clear();
+  mbo_asks_.clear();
+  auto &orders = symbol.orders;
+  for (size_t i = 0; i < orders.size();) {
+    auto &order = orders[i];
+    auto crossed = order.side == Side::BUY ? order.price >= symbol.mid : order.price <= symbol.mid;
+    if (!crossed) {
+      ++i;
+      continue;
+    }
+    auto &order_id = order_ids_[mbo_bids_.size() + mbo_asks_.size()];
+    order_id.assign(fmt::format_int(order.order_id).c_str());
+    (order.side == Side::BUY ? mbo_bids_ : mbo_asks_)
+        .push_back({
+            .price = price(order.price),
+            .remaining_quantity = 0.0,
+            .action = OrderUpdateAction::REMOVE,
+            .priority = {},
+            .order_id = order_id,
+        });
+    std::swap(order, orders.back());
+    orders.pop_back();
+  }
+  if (mbo_bids_.empty() && mbo_asks_.empty())
+    return;
+  handler(
+      MarketByOrderUpdate{
+          .stream_id = {},
+          .exchange = EXCHANGE,
+          .symbol = symbol.name,
+          .bids = mbo_bids_,
+          .asks = mbo_asks_,
+          .snapshot = false,
+          .exchange_time_utc = timestamp_utc,
+      },
+      timestamp_utc);
+}
+
+}  // namespace import
+}  // namespace samples
+}  // namespace roq
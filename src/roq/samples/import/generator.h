@@ -0,0 +1,103 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "roq/api.h"
+
+#include "roq/samples/import/handler.h"
+#include "roq/samples/import/random.h"
+
+namespace roq {
+namespace samples {
+namespace import {
+
+// synthetic market data (load and soak testing)
+//
+// events arrive as a poisson process (--generate_rate) and are assigned to
+// symbols following a zipf distribution (--generate_skew), i.e. a few
+// symbols are much more active than the rest
+//
+// each event is one of
+//   TradeSummary (--generate_trade_ratio)
+//   MarketByOrderUpdate (--generate_mbo_ratio), i.e. order churn
+//   MarketByPriceUpdate (otherwise), occasionally moving the mid price
+//
+// note!
+//   the output is deterministic for a given --generate_seed
+//   all messages are built from re-used storage (no allocations)
+
+class Generator final {
+ public:
+  struct Config final {
+    uint64_t seed = {};
+    uint64_t events = {};
+    uint32_t symbols = {};
+    double rate = {};  // events per second
+    double skew = {};
+    uint32_t depth = {};
+    double trade_ratio = {};
+    double mbo_ratio = {};
+  };
+
+  Generator();  // note! configured from flags
+  explicit Generator(const Config &);
+
+  Generator(Generator &&) = delete;
+  Generator(const Generator &) = delete;
+
+  void dispatch(Handler &);
+
+ protected:
+  struct Order final {
+    uint64_t order_id;
+    Side side;
+    int64_t price;  // ticks
+    double quantity;
+  };
+
+  struct Symbol final {
+    std::string name;
+    int64_t mid = {};  // ticks
+    uint64_t next_order_id = {};
+    uint64_t next_trade_id = {};
+    std::vector<Order> orders;  // note! live orders (mbo)
+  };
+
+  void initialize(Handler &, std::chrono::nanoseconds timestamp_utc);
+
+  Symbol &next_symbol();
+
+  double next_quantity();
+
+  void market_by_price(Handler &, Symbol &, std::chrono::nanoseconds timestamp_utc);
+  void market_by_order(Handler &, Symbol &, std::chrono::nanoseconds timestamp_utc);
+  void trade_summary(Handler &, Symbol &, std::chrono::nanoseconds timestamp_utc);
+
+  void move(Handler &, Symbol &, std::chrono::nanoseconds timestamp_utc);
+
+ private:
+  Random random_;
+  const uint64_t events_;
+  const double interval_;  // nanoseconds (mean)
+  const int64_t depth_;
+  const double trade_ratio_;
+  const double mbo_ratio_;
+  std::vector<Symbol> symbols_;
+  std::vector<double> cdf_;  // zipf
+  // note! re-used to avoid allocations
+  std::vector<MBPUpdate> bids_;
+  std::vector<MBPUpdate> asks_;
+  std::vector<MBOUpdate> mbo_bids_;
+  std::vector<MBOUpdate> mbo_asks_;
+  std::vector<std::string> order_ids_;
+  std::string trade_id_;
+};
+
+}  // namespace import
+}  // namespace samples
+}  // namespace roq
@@ -0,0 +1,32 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#pragma once
+
+#include <chrono>
+
+#include "roq/api.h"
+
+namespace roq {
+namespace samples {
+namespace import {
+
+// interface used by readers to push decoded messages downstream
+// note!
+//   all views (strings, spans) are only valid for the duration of
+//   the callback
+
+class Handler {
+ public:
+  virtual ~Handler() {}
+
+  virtual void operator()(const GatewaySettings &, std::chrono::nanoseconds timestamp_utc) = 0;
+  virtual void operator()(const ReferenceData &, std::chrono::nanoseconds timestamp_utc) = 0;
+  virtual void operator()(const MarketStatus &, std::chrono::nanoseconds timestamp_utc) = 0;
+  virtual void operator()(const MarketByPriceUpdate &, std::chrono::nanoseconds timestamp_utc) = 0;
+  virtual void operator()(const MarketByOrderUpdate &, std::chrono::nanoseconds timestamp_utc) = 0;
+  virtual void operator()(const TradeSummary &, std::chrono::nanoseconds timestamp_utc) = 0;
+};
+
+}  // namespace import
+}  // namespace samples
+}  // namespace roq
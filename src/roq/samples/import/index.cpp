@@ -0,0 +1,111 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#include "roq/samples/import/index.h"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include "roq/exceptions.h"
+#include "roq/logging.h"
+
+#include "roq/samples/import/frame.h"
+
+using namespace roq::literals;
+
+namespace roq {
+namespace samples {
+namespace import {
+
+namespace {
+static constexpr size_t INDEX_HEADER_SIZE = sizeof(INDEX_MAGIC) + sizeof(uint32_t);
+}  // namespace
+
+IndexWriter::IndexWriter(const std::string_view &path, std::chrono::nanoseconds interval)
+    : path_(path), interval_(interval) {
+}
+
+IndexWriter::~IndexWriter() {
+  try {
+    // best effort
+    close();
+  } catch (...) {
+  }
+}
+
+void IndexWriter::operator()(void const *frame, uint64_t offset) {
+  auto receive_time_utc = Frame::receive_time_utc(frame);
+  if (!entries_.empty() && receive_time_utc < next_)
+    return;
+  entries_.push_back({
+      .receive_time_utc = receive_time_utc.count(),
+      .source_seqno = Frame::source_seqno(frame),
+      .offset = offset,
+  });
+  next_ = receive_time_utc + interval_;
+}
+
+// note! the index is small (one entry per interval), so we write it in one go
+void IndexWriter::close() {
+  if (closed_)
+    return;
+  closed_ = true;
+  auto file = std::fopen(path_.c_str(), "wb");
+  if (file == nullptr)
+    throw RuntimeErrorException(
+        R"(Unable to open file for writing: path="{}", error="{}")"_fmt,
+        path_,
+        std::strerror(errno));
+  uint32_t entry_size = sizeof(IndexEntry);
+  auto success = std::fwrite(INDEX_MAGIC, sizeof(INDEX_MAGIC), 1, file) == 1 &&
+                 std::fwrite(&entry_size, sizeof(entry_size), 1, file) == 1 &&
+                 std::fwrite(entries_.data(), sizeof(IndexEntry), entries_.size(), file) ==
+                     entries_.size();
+  success = (std::fclose(file) == 0) && success;
+  if (!success)
+    throw RuntimeErrorException(R"(Unable to write: path="{}")"_fmt, path_);
+  log::info(R"(path="{}", entries={})"_fmt, path_, entries_.size());
+}
+
+Index::Index(const std::string_view &path) : path_(path), file_(path) {
+  auto data = file_.data();
+  if (data.size() < INDEX_HEADER_SIZE ||
+      std::memcmp(data.data(), INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0)
+    throw RuntimeErrorException(R"(Not an index: path="{}")"_fmt, path_);
+  uint32_t entry_size;
+  std::memcpy(&entry_size, data.data() + sizeof(INDEX_MAGIC), sizeof(entry_size));
+  if (entry_size != sizeof(IndexEntry) || (data.size() - INDEX_HEADER_SIZE) % entry_size != 0)
+    throw RuntimeErrorException(R"(Unexpected index layout: path="{}")"_fmt, path_);
+  // note! the mapping is page aligned and the header is 8 bytes
+  entries_ = reinterpret_cast<IndexEntry const *>(data.data() + INDEX_HEADER_SIZE);
+  size_ = (data.size() - INDEX_HEADER_SIZE) / entry_size;
+}
+
+std::string Index::path(const std::string_view &path) {
+  return fmt::format("{}.index", path);
+}
+
+IndexEntry const *Index::before(std::chrono::nanoseconds timestamp_utc) const {
+  auto end = entries_ + size_;
+  auto iter = std::lower_bound(
+      entries_, end, timestamp_utc.count(), [](auto &entry, auto value) {
+        return entry.receive_time_utc < value;
+      });
+  return iter == entries_ ? nullptr : iter - 1;
+}
+
+IndexEntry const *Index::after(std::chrono::nanoseconds timestamp_utc) const {
+  auto end = entries_ + size_;
+  auto iter = std::lower_bound(
+      entries_, end, timestamp_utc.count(), [](auto &entry, auto value) {
+        return entry.receive_time_utc < value;
+      });
+  return iter == end ? nullptr : iter;
+}
+
+}  // namespace import
+}  // namespace samples
+}  // namespace roq
@@ -0,0 +1,88 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "roq/samples/import/mapped_file.h"
+
+namespace roq {
+namespace samples {
+namespace import {
+
+// time index (sidecar file)
+//
+//   file  := magic (4 bytes) entry_size (u32) entry*
+//   entry := receive_time_utc (i64) source_seqno (u64) offset (u64)
+//
+// each entry is a checkpoint: the offset of a frame in the stream (or the
+// offset of the compressed block starting with that frame)
+//
+// note!
+//   entries are ordered by time (the stream is ordered by time)
+//   frames before a checkpoint never have a later receive_time_utc
+
+struct IndexEntry final {
+  int64_t receive_time_utc;
+  uint64_t source_seqno;
+  uint64_t offset;
+};
+
+static constexpr char const INDEX_MAGIC[4] = {'R', 'Q', 'I', '1'};
+
+class IndexWriter final {
+ public:
+  IndexWriter(const std::string_view &path, std::chrono::nanoseconds interval);
+
+  IndexWriter(IndexWriter &&) = delete;
+  IndexWriter(const IndexWriter &) = delete;
+
+  ~IndexWriter();
+
+  // offset is where a reader can start decoding the frame
+  void operator()(void const *frame, uint64_t offset);
+
+  void close();
+
+ private:
+  const std::string path_;
+  const std::chrono::nanoseconds interval_;
+  std::chrono::nanoseconds next_ = {};
+  std::vector<IndexEntry> entries_;
+  bool closed_ = false;
+};
+
+class Index final {
+ public:
+  explicit Index(const std::string_view &path);  // note! path of the index
+
+  Index(Index &&) = delete;
+  Index(const Index &) = delete;
+
+  // sidecar path of a stream
+  static std::string path(const std::string_view &path);
+
+  size_t size() const { return size_; }
+
+  // last checkpoint having receive_time_utc < timestamp_utc
+  // (nullptr means: from the start of the stream)
+  IndexEntry const *before(std::chrono::nanoseconds timestamp_utc) const;
+
+  // first checkpoint having receive_time_utc >= timestamp_utc
+  // (nullptr means: until the end of the stream)
+  IndexEntry const *after(std::chrono::nanoseconds timestamp_utc) const;
+
+ private:
+  const std::string path_;
+  MappedFile file_;
+  IndexEntry const *entries_ = nullptr;
+  size_t size_ = {};
+};
+
+}  // namespace import
+}  // namespace samples
+}  // namespace roq
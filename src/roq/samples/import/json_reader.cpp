@@ -0,0 +1,417 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#include "roq/samples/import/json_reader.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include "roq/exceptions.h"
+
+#include "roq/utils/compare.h"
+
+#include "roq/samples/import/flags.h"
+#include "roq/samples/import/parse.h"
+
+using namespace roq::literals;
+
+namespace roq {
+namespace samples {
+namespace import {
+
+namespace {
+static const auto DERIBIT = "deribit"_sv;
+static const auto COINBASE = "coinbase"_sv;
+
+static bool starts_with(const std::string_view &text, const std::string_view &prefix) {
+  return text.size() >= prefix.size() && text.compare(0, prefix.size(), prefix) == 0;
+}
+
+// note! aggressor side
+static bool parse_direction(const std::string_view &text, Side &result) {
+  if (text == "buy"_sv) {
+    result = Side::BUY;
+    return true;
+  }
+  if (text == "sell"_sv) {
+    result = Side::SELL;
+    return true;
+  }
+  return false;
+}
+}  // namespace
+
+JSONReader::JSONReader(const std::string_view &path, Format format)
+    : path_(path), format_(format), file_(path) {
+}
+
+std::optional<JSONReader::Format> JSONReader::format() {
+  auto format = Flags::format();
+  if (utils::case_insensitive_compare(format, "csv"_sv) == 0)
+    return {};
+  if (utils::case_insensitive_compare(format, DERIBIT) == 0)
+    return Format::DERIBIT;
+  if (utils::case_insensitive_compare(format, COINBASE) == 0)
+    return Format::COINBASE;
+  throw RuntimeErrorException(R"(Unknown format="{}")"_fmt, format);
+}
+
+void JSONReader::dispatch(Handler &handler) {
+  auto data = file_.data();
+  auto begin = data.data(), end = begin + data.size();
+  while (begin < end) {
+    auto next = static_cast<char const *>(std::memchr(begin, '\n', end - begin));
+    if (next == nullptr)
+      next = end;
+    auto length = static_cast<size_t>(next - begin);
+    ++line_number_;
+    // note! the remainder of the file is the padding
+    parse(begin, length, static_cast<size_t>(end - begin), handler);
+    begin = next + 1;
+  }
+}
+
+void JSONReader::parse(char const *data, size_t length, size_t capacity, Handler &handler) {
+  // note! trailing whitespace (e.g. windows line endings) is ignored by the parser
+  if (std::all_of(data, data + length, [](auto c) { return c == ' ' || c == '\r' || c == '\t'; }))
+    return;
+  if (ROQ_UNLIKELY(capacity < (length + simdjson::SIMDJSON_PADDING))) {
+    padded_.resize(length + simdjson::SIMDJSON_PADDING);
+    std::memcpy(padded_.data(), data, length);
+    std::memset(padded_.data() + length, 0, simdjson::SIMDJSON_PADDING);
+    data = padded_.data();
+    capacity = padded_.size();
+  }
+  simdjson::ondemand::document document;
+  check(parser_.iterate(data, length, capacity).get(document));
+  simdjson::ondemand::object object;
+  check(document.get_object().get(object));
+  switch (format_) {
+    case Format::DERIBIT:
+      parse_deribit(object, handler);
+      break;
+    case Format::COINBASE:
+      parse_coinbase(object, handler);
+      break;
+  }
+}
+
+// {"jsonrpc":"2.0","method":"subscription","params":{"channel":"book.BTC-PERPETUAL.raw","data":{...}}}
+// note! channel always precedes data
+void JSONReader::parse_deribit(simdjson::ondemand::object &object, Handler &handler) {
+  for (auto field : object) {
+    std::string_view key;
+    check(field.unescaped_key().get(key));
+    if (key != "params"_sv)
+      continue;
+    simdjson::ondemand::object params;
+    check(field.value().get_object().get(params));
+    std::string_view channel;
+    for (auto item : params) {
+      check(item.unescaped_key().get(key));
+      if (key == "channel"_sv) {
+        check(item.value().get_string().get(channel));
+      } else if (key == "data"_sv) {
+        if (starts_with(channel, "book."_sv)) {
+          simdjson::ondemand::object data;
+          check(item.value().get_object().get(data));
+          parse_deribit_book(data, handler);
+        } else if (starts_with(channel, "trades."_sv)) {
+          simdjson::ondemand::array data;
+          check(item.value().get_array().get(data));
+          parse_deribit_trades(data, handler);
+        }
+      }
+    }
+    return;
+  }
+}
+
+// {"type":"change","timestamp":1554373962454,"instrument_name":"BTC-PERPETUAL",
+//  "bids":[["new",5042.34,30]],"asks":[["delete",5043.0,0]]}
+void JSONReader::parse_deribit_book(simdjson::ondemand::object &object, Handler &handler) {
+  std::string_view type, instrument_name;
+  uint64_t timestamp = {};
+  bids_.clear();
+  asks_.clear();
+  for (auto field : object) {
+    std::string_view key;
+    check(field.unescaped_key().get(key));
+    if (key == "type"_sv) {
+      check(field.value().get_string().get(type));
+    } else if (key == "timestamp"_sv) {
+      check(field.value().get_uint64().get(timestamp));
+    } else if (key == "instrument_name"_sv) {
+      check(field.value().get_string().get(instrument_name));
+    } else if (key == "bids"_sv || key == "asks"_sv) {
+      simdjson::ondemand::array levels;
+      check(field.value().get_array().get(levels));
+      parse_deribit_levels(levels, key == "bids"_sv ? bids_ : asks_);
+    }
+  }
+  if (instrument_name.empty() || timestamp == 0)
+    invalid("book"_sv);
+  timestamp_ = std::chrono::milliseconds{timestamp};
+  handler(
+      MarketByPriceUpdate{
+          .stream_id = {},
+          .exchange = DERIBIT,
+          .symbol = instrument_name,
+          .bids = {bids_.data(), bids_.size()},
+          .asks = {asks_.data(), asks_.size()},
+          .snapshot = type.empty() || type == "snapshot"_sv,  // note! grouped books are images
+          .exchange_time_utc = timestamp_,
+      },
+      timestamp_);
+}
+
+// raw:     [action, price, amount] (action is new, change or delete)
+// grouped: [price, amount]
+void JSONReader::parse_deribit_levels(
+    simdjson::ondemand::array &levels, std::vector<MBPUpdate> &result) {
+  for (auto element : levels) {
+    simdjson::ondemand::array level;
+    check(element.get_array().get(level));
+    MBPUpdate update{
+        .price = NaN,
+        .quantity = NaN,
+    };
+    auto remove = false;
+    size_t index = 0;
+    for (auto item : level) {
+      simdjson::ondemand::json_type type;
+      check(item.type().get(type));
+      if (type == simdjson::ondemand::json_type::string) {
+        std::string_view action;
+        check(item.get_string().get(action));
+        remove = action == "delete"_sv;
+        continue;
+      }
+      double value;
+      check(item.get_double().get(value));
+      (index++ == 0 ? update.price : update.quantity) = value;
+    }
+    if (index != 2u)
+      invalid("level"_sv);
+    if (remove)
+      update.quantity = 0.0;
+    result.emplace_back(update);
+  }
+}
+
+// [{"trade_id":"48079254","timestamp":1590484156350,"price":8950.0,
+//   "instrument_name":"BTC-PERPETUAL","direction":"sell","amount":10.0}]
+// note! all trades of one message are for the same instrument
+void JSONReader::parse_deribit_trades(simdjson::ondemand::array &array, Handler &handler) {
+  std::string_view instrument_name;
+  uint64_t timestamp = {};
+  trades_.clear();
+  for (auto element : array) {
+    simdjson::ondemand::object object;
+    check(element.get_object().get(object));
+    Trade trade{
+        .side = {},
+        .price = NaN,
+        .quantity = NaN,
+        .trade_id = {},
+    };
+    for (auto field : object) {
+      std::string_view key, value;
+      check(field.unescaped_key().get(key));
+      if (key == "trade_id"_sv) {
+        check(field.value().get_string().get(value));
+        trade.trade_id = value;
+      } else if (key == "timestamp"_sv) {
+        check(field.value().get_uint64().get(timestamp));
+      } else if (key == "price"_sv) {
+        check(field.value().get_double().get(trade.price));
+      } else if (key == "amount"_sv) {
+        check(field.value().get_double().get(trade.quantity));
+      } else if (key == "direction"_sv) {
+        check(field.value().get_string().get(value));
+        if (!parse_direction(value, trade.side))
+          invalid("direction"_sv);
+      } else if (key == "instrument_name"_sv) {
+        check(field.value().get_string().get(instrument_name));
+      }
+    }
+    trades_.emplace_back(trade);
+  }
+  if (trades_.empty())
+    return;
+  if (instrument_name.empty() || timestamp == 0)
+    invalid("trades"_sv);
+  timestamp_ = std::chrono::milliseconds{timestamp};
+  handler(
+      TradeSummary{
+          .stream_id = {},
+          .exchange = DERIBIT,
+          .symbol = instrument_name,
+          .trades = {trades_.data(), trades_.size()},
+          .exchange_time_utc = timestamp_,
+      },
+      timestamp_);
+}
+
+// {"type":"snapshot","product_id":"BTC-USD","bids":[["10101.10","0.45"]],"asks":[...]}
+// {"type":"l2update","product_id":"BTC-USD","time":"2019-08-14T20:42:27.265Z",
+//  "changes":[["buy","10101.80","0.162567"]]}
+// {"type":"match","trade_id":10,"time":"2014-11-07T08:19:27.028459Z",
+//  "product_id":"BTC-USD","size":"5.23512","price":"400.23","side":"sell"}
+// note!
+//   prices and sizes are strings
+//   the side of a match is the maker's side
+void JSONReader::parse_coinbase(simdjson::ondemand::object &object, Handler &handler) {
+  std::string_view type, product_id, side;
+  Trade trade{
+      .side = {},
+      .price = NaN,
+      .quantity = NaN,
+      .trade_id = {},
+  };
+  bids_.clear();
+  asks_.clear();
+  for (auto field : object) {
+    std::string_view key, value;
+    check(field.unescaped_key().get(key));
+    if (key == "type"_sv) {
+      check(field.value().get_string().get(type));
+    } else if (key == "product_id"_sv) {
+      check(field.value().get_string().get(product_id));
+    } else if (key == "time"_sv) {
+      check(field.value().get_string().get(value));
+      if (!parse_iso8601(value, timestamp_))
+        invalid("time"_sv);
+    } else if (key == "bids"_sv || key == "asks"_sv) {
+      simdjson::ondemand::array levels;
+      check(field.value().get_array().get(levels));
+      parse_coinbase_levels(levels, key == "bids"_sv ? bids_ : asks_);
+    } else if (key == "changes"_sv) {
+      simdjson::ondemand::array changes;
+      check(field.value().get_array().get(changes));
+      parse_coinbase_changes(changes);
+    } else if (key == "price"_sv) {
+      check(field.value().get_string().get(value));
+      if (!parse_decimal(value, trade.price))
+        invalid("price"_sv);
+    } else if (key == "size"_sv) {
+      check(field.value().get_string().get(value));
+      if (!parse_decimal(value, trade.quantity))
+        invalid("size"_sv);
+    } else if (key == "side"_sv) {
+      check(field.value().get_string().get(side));
+    } else if (key == "trade_id"_sv) {
+      // note! a number, we use the raw token (no conversion, no copy)
+      check(field.value().raw_json_token().get(value));
+      while (!value.empty() && value.back() == ' ')
+        value.remove_suffix(1);
+      trade.trade_id = value;
+    }
+  }
+  if (type == "snapshot"_sv || type == "l2update"_sv) {
+    if (product_id.empty())
+      invalid("book"_sv);
+    handler(
+        MarketByPriceUpdate{
+            .stream_id = {},
+            .exchange = COINBASE,
+            .symbol = product_id,
+            .bids = {bids_.data(), bids_.size()},
+            .asks = {asks_.data(), asks_.size()},
+            .snapshot = type == "snapshot"_sv,
+            .exchange_time_utc = timestamp_,
+        },
+        timestamp_);
+  } else if (type == "match"_sv || type == "last_match"_sv) {
+    Side maker;
+    if (product_id.empty() || !parse_direction(side, maker))
+      invalid("match"_sv);
+    trade.side = maker == Side::BUY ? Side::SELL : Side::BUY;
+    handler(
+        TradeSummary{
+            .stream_id = {},
+            .exchange = COINBASE,
+            .symbol = product_id,
+            .trades = {&trade, 1},
+            .exchange_time_utc = timestamp_,
+        },
+        timestamp_);
+  }
+}
+
+// [price, size]
+void JSONReader::parse_coinbase_levels(
+    simdjson::ondemand::array &levels, std::vector<MBPUpdate> &result) {
+  for (auto element : levels) {
+    simdjson::ondemand::array level;
+    check(element.get_array().get(level));
+    MBPUpdate update{
+        .price = NaN,
+        .quantity = NaN,
+    };
+    size_t index = 0;
+    for (auto item : level) {
+      std::string_view value;
+      check(item.get_string().get(value));
+      if (index >= 2u || !parse_decimal(value, index == 0 ? update.price : update.quantity))
+        invalid("level"_sv);
+      ++index;
+    }
+    if (index != 2u)
+      invalid("level"_sv);
+    result.emplace_back(update);
+  }
+}
+
+// [side, price, size]
+void JSONReader::parse_coinbase_changes(simdjson::ondemand::array &changes) {
+  for (auto element : changes) {
+    simdjson::ondemand::array change;
+    check(element.get_array().get(change));
+    Side side = {};
+    MBPUpdate update{
+        .price = NaN,
+        .quantity = NaN,
+    };
+    size_t index = 0;
+    for (auto item : change) {
+      std::string_view value;
+      check(item.get_string().get(value));
+      auto valid = false;
+      switch (index++) {
+        case 0:
+          valid = parse_direction(value, side);
+          break;
+        case 1:
+          valid = parse_decimal(value, update.price);
+          break;
+        case 2:
+          valid = parse_decimal(value, update.quantity);
+          break;
+      }
+      if (!valid)
+        invalid("change"_sv);
+    }
+    if (index != 3u)
+      invalid("change"_sv);
+    (side == Side::BUY ? bids_ : asks_).emplace_back(update);
+  }
+}
+
+void JSONReader::check(simdjson::error_code error) const {
+  if (ROQ_UNLIKELY(error != simdjson::SUCCESS))
+    throw RuntimeErrorException(
+        R"(Invalid json: path="{}", line_number={}, error="{}")"_fmt,
+        path_,
+        line_number_,
+        simdjson::error_message(error));
+}
+
+void JSONReader::invalid(const std::string_view &what) const {
+  throw RuntimeErrorException(
+      R"(Invalid {}: path="{}", line_number={})"_fmt, what, path_, line_number_);
+}
+
+}  // namespace import
+}  // namespace samples
+}  // namespace roq
@@ -0,0 +1,90 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#pragma once
+
+#include <simdjson.h>
+
+#include <chrono>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "roq/api.h"
+
+#include "roq/samples/import/handler.h"
+#include "roq/samples/import/mapped_file.h"
+
+namespace roq {
+namespace samples {
+namespace import {
+
+// streaming reader for captured exchange websocket messages (json lines)
+//
+// one message per line, the format is selected by --format
+//
+//   deribit   book.* (snapshot and change, grouped books are images) and
+//             trades.* subscriptions
+//   coinbase  snapshot, l2update, match and last_match
+//
+// other messages (heartbeats, subscription responses, tickers, ...) are
+// ignored
+//
+// timestamps are taken from the messages (the exchange's time)
+// coinbase snapshots have no time and use the time of the previous message
+//
+// note!
+//   messages are parsed on demand (simdjson), i.e. no dom is built and
+//   fields are decoded in a single pass directly into re-used arrays
+//   strings (symbols, trade ids) are views into the parser's buffer (or the
+//   file) and are only valid until the next line is parsed
+//   simdjson requires padding after the input, lines too close to the end
+//   of the file are copied to a padded buffer
+
+class JSONReader final {
+ public:
+  enum class Format {
+    DERIBIT,
+    COINBASE,
+  };
+
+  JSONReader(const std::string_view &path, Format);
+
+  static std::optional<Format> format();  // note! from flags, empty means csv
+
+  JSONReader(JSONReader &&) = delete;
+  JSONReader(const JSONReader &) = delete;
+
+  void dispatch(Handler &);
+
+ protected:
+  void parse(char const *data, size_t length, size_t capacity, Handler &);
+
+  void parse_deribit(simdjson::ondemand::object &, Handler &);
+  void parse_deribit_book(simdjson::ondemand::object &, Handler &);
+  void parse_deribit_trades(simdjson::ondemand::array &, Handler &);
+  void parse_deribit_levels(simdjson::ondemand::array &, std::vector<MBPUpdate> &);
+
+  void parse_coinbase(simdjson::ondemand::object &, Handler &);
+  void parse_coinbase_levels(simdjson::ondemand::array &, std::vector<MBPUpdate> &);
+  void parse_coinbase_changes(simdjson::ondemand::array &);
+
+  void check(simdjson::error_code) const;
+  [[noreturn]] void invalid(const std::string_view &what) const;
+
+ private:
+  const std::string_view path_;
+  const Format format_;
+  MappedFile file_;
+  uint64_t line_number_ = {};
+  simdjson::ondemand::parser parser_;
+  std::vector<char> padded_;  // note! only used for lines close to the end of the file
+  std::chrono::nanoseconds timestamp_ = {};  // note! previous message
+  // note! re-used to avoid allocations
+  std::vector<MBPUpdate> bids_;
+  std::vector<MBPUpdate> asks_;
+  std::vector<Trade> trades_;
+};
+
+}  // namespace import
+}  // namespace samples
+}  // namespace roq
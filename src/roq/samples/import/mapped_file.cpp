@@ -0,0 +1,58 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#include "roq/samples/import/mapped_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+#include "roq/exceptions.h"
+
+using namespace roq::literals;
+
+namespace roq {
+namespace samples {
+namespace import {
+
+MappedFile::MappedFile(const std::string_view &path) {
+  std::string filename{path};  // null-terminated
+  auto fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw RuntimeErrorException(
+        R"(Unable to open file for reading: path="{}", error="{}")"_fmt, path, std::strerror(errno));
+  struct stat st;
+  if (::fstat(fd, &st) < 0) {
+    auto error = errno;
+    ::close(fd);
+    throw RuntimeErrorException(
+        R"(Unable to stat file: path="{}", error="{}")"_fmt, path, std::strerror(error));
+  }
+  size_ = static_cast<size_t>(st.st_size);
+  if (size_ > 0) {  // note! mmap does not accept zero length
+    data_ = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data_ == MAP_FAILED) {
+      auto error = errno;
+      ::close(fd);
+      throw RuntimeErrorException(
+          R"(Unable to map file: path="{}", error="{}")"_fmt, path, std::strerror(error));
+    }
+    // hint: we will scan the file from start to end
+    ::madvise(data_, size_, MADV_SEQUENTIAL);
+  }
+  // note! the mapping remains valid after the descriptor has been closed
+  ::close(fd);
+}
+
+MappedFile::~MappedFile() {
+  if (size_ > 0)
+    ::munmap(data_, size_);
+}
+
+}  // namespace import
+}  // namespace samples
+}  // namespace roq
@@ -0,0 +1,36 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#pragma once
+
+#include <string_view>
+
+namespace roq {
+namespace samples {
+namespace import {
+
+// read-only memory-mapped file
+// note!
+//   the kernel pages in the content on demand, so we never copy
+//   the file into user-space buffers
+
+class MappedFile final {
+ public:
+  explicit MappedFile(const std::string_view &path);
+
+  MappedFile(MappedFile &&) = delete;
+  MappedFile(const MappedFile &) = delete;
+
+  ~MappedFile();
+
+  std::string_view data() const { return {static_cast<char const *>(data_), size_}; }
+
+  size_t size() const { return size_; }
+
+ private:
+  void *data_ = nullptr;
+  size_t size_ = {};
+};
+
+}  // namespace import
+}  // namespace samples
+}  // namespace roq
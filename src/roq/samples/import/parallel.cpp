@@ -0,0 +1,301 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#include "roq/samples/import/parallel.h"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <queue>
+#include <thread>
+#include <utility>
+
+#include "roq/exceptions.h"
+#include "roq/logging.h"
+
+#include "roq/samples/import/csv_reader.h"
+#include "roq/samples/import/flags.h"
+#include "roq/samples/import/frame.h"
+#include "roq/samples/import/json_reader.h"
+#include "roq/samples/import/mapped_file.h"
+#include "roq/samples/import/processor.h"
+#include "roq/samples/import/snapshotter.h"
+#include "roq/samples/import/stage.h"
+
+using namespace roq::literals;
+
+namespace roq {
+namespace samples {
+namespace import {
+
+namespace {
+static const size_t BATCH_SIZE = 1024;  // lines
+static const size_t QUEUE_SIZE = 16;    // batches (per shard), must be a power of two
+
+// note! thrown when another thread has failed (not an error)
+struct Aborted final {};
+}  // namespace
+
+Parallel::Parallel(
+    const std::string_view &path,
+    const roq::span<std::string_view> &inputs,
+    size_t threads,
+    ShardBy shard_by)
+    : path_(path), inputs_(inputs), threads_(threads), shard_by_(shard_by) {
+  // note! sequence numbers must be validated in order
+  if (Flags::validate())
+    throw RuntimeErrorException("Validation requires --threads 1"_sv);
+  // note! snapshots must include all symbols
+  if (shard_by_ == ShardBy::FILE && Snapshotter::enabled())
+    throw RuntimeErrorException("Snapshots require --shard_by symbol"_sv);
+  // note! events are counted per shard
+  if (Flags::snapshot_events() > 0u)
+    throw RuntimeErrorException("Snapshots by --snapshot_events require --threads 1"_sv);
+  // note! json lines are not split by symbol
+  if (shard_by_ == ShardBy::SYMBOL && JSONReader::format())
+    throw RuntimeErrorException("JSON input requires --shard_by file"_sv);
+  auto count = shard_by_ == ShardBy::FILE ? inputs_.size() : threads_;
+  for (size_t i = 0; i < count; ++i)
+    shards_.emplace_back(fmt::format("{}.shard-{}", path_, i));
+  processors_.resize(count);
+  snapshotters_.resize(count);
+  if (shard_by_ == ShardBy::SYMBOL) {
+    for (size_t i = 0; i < count; ++i) {
+      auto &queue = *queues_.emplace_back(std::make_unique<SPSCQueue<Batch>>(QUEUE_SIZE));
+      for (auto &batch : queue.slots())
+        batch.lines.reserve(BATCH_SIZE);
+    }
+  }
+}
+
+Parallel::~Parallel() {
+  // best effort
+  snapshotters_.clear();
+  processors_.clear();
+  files_.clear();
+  for (auto &shard : shards_)
+    std::remove(shard.c_str());
+}
+
+void Parallel::dispatch() {
+  // note! the last is the splitter
+  std::vector<std::exception_ptr> errors(threads_ + 1);
+  auto run = [this, &errors](size_t index, auto &&function) {
+    try {
+      function();
+    } catch (Aborted &) {
+    } catch (...) {
+      errors[index] = std::current_exception();
+      failed_.store(true, std::memory_order_release);
+    }
+  };
+  // note! workers pull shards until there are no more
+  std::atomic<size_t> next = {0};
+  std::vector<std::thread> workers;
+  workers.reserve(threads_);
+  for (size_t i = 0; i < threads_; ++i) {
+    workers.emplace_back([this, i, &next, &run]() {
+      run(i, [this, &next]() {
+        for (size_t shard; (shard = next++) < shards_.size();)
+          encode(shard);
+      });
+    });
+  }
+  if (shard_by_ == ShardBy::SYMBOL)
+    run(threads_, [this]() { split(); });
+  for (auto &worker : workers)
+    worker.join();
+  files_.clear();
+  for (auto &error : errors)
+    if (error)
+      std::rethrow_exception(error);
+  // note! a shard may not have any events after a boundary crossed by another shard
+  std::chrono::nanoseconds end = {};
+  for (auto &snapshotter : snapshotters_)
+    if (snapshotter)
+      end = std::max(end, (*snapshotter).timestamp_utc());
+  for (size_t i = 0; i < shards_.size(); ++i) {
+    if (!snapshotters_[i])
+      continue;
+    (*snapshotters_[i]).flush(end);
+    (*processors_[i]).close();
+  }
+  snapshotters_.clear();
+  processors_.clear();
+  merge();
+}
+
+void Parallel::encode(size_t shard) {
+  // note! shards are always binary (we must be able to patch the frames)
+  auto &processor = *(processors_[shard] =
+                          std::make_unique<Processor>(shards_[shard], Processor::Encoding::BINARY));
+  auto &snapshotter = snapshotters_[shard];
+  if (Snapshotter::enabled())
+    snapshotter = std::make_unique<Snapshotter>(processor, Snapshotter::Aligned{});
+  Handler &handler = snapshotter ? static_cast<Handler &>(*snapshotter) : processor;
+  switch (shard_by_) {
+    case ShardBy::FILE:
+      if (auto format = JSONReader::format())
+        JSONReader(inputs_[shard], *format).dispatch(handler);
+      else
+        CSVReader(inputs_[shard]).dispatch(handler);
+      break;
+    case ShardBy::SYMBOL:
+      consume(shard, handler);
+      break;
+  }
+  // note! closed by dispatch (all boundaries before the end of all shards must be injected)
+  if (snapshotter)
+    return;
+  processor.close();
+  processors_[shard].reset();
+}
+
+// note! lines are routed as CSVReader::shard, comments and empty lines are dropped here
+void Parallel::split() {
+  Stage stage("split"_sv);
+  std::vector<Batch *> batches(shards_.size());  // note! claimed, not yet pushed
+  auto claim = [&](size_t shard, size_t input) -> Batch & {
+    auto &batch = batches[shard];
+    if (batch == nullptr) {
+      auto &queue = *queues_[shard];
+      batch = stage.wait_for_output([&]() {
+        check();
+        return queue.claim();
+      });
+      (*batch).input = input;
+      (*batch).lines.clear();  // note! capacity is re-used
+    }
+    return *batch;
+  };
+  auto push = [&](size_t shard) {
+    auto &batch = batches[shard];
+    if (batch == nullptr)
+      return;
+    (*queues_[shard]).push();
+    batch = nullptr;
+    ++stage;
+  };
+  for (size_t input = 0; input < inputs_.size(); ++input) {
+    auto &file = *files_.emplace_back(std::make_unique<MappedFile>(inputs_[input]));
+    auto data = file.data();
+    auto begin = data.data(), end = begin + data.size();
+    uint64_t line_number = 0;
+    while (begin < end) {
+      auto next = static_cast<char const *>(std::memchr(begin, '\n', end - begin));
+      if (next == nullptr)
+        next = end;
+      auto length = static_cast<size_t>(next - begin);
+      if (length > 0 && begin[length - 1] == '\r')  // windows line endings
+        --length;
+      ++line_number;
+      std::string_view line(begin, length);
+      begin = next + 1;
+      if (line.empty() || line[0] == '#')
+        continue;
+      auto shard = CSVReader::shard(line, shards_.size());
+      auto &batch = claim(shard, input);
+      batch.lines.push_back({
+          .text = line,
+          .line_number = line_number,
+      });
+      if (batch.lines.size() >= BATCH_SIZE)
+        push(shard);
+    }
+    // note! a batch never spans files (the reader is flushed between files)
+    for (size_t shard = 0; shard < shards_.size(); ++shard)
+      push(shard);
+  }
+  for (size_t shard = 0; shard < shards_.size(); ++shard) {
+    claim(shard, inputs_.size());
+    push(shard);
+  }
+  stage.log();
+}
+
+// note! one reader per input file, same as the single-threaded case
+void Parallel::consume(size_t shard, Handler &handler) {
+  Stage stage("shard"_sv);
+  auto &queue = *queues_[shard];
+  std::optional<CSVReader> reader;
+  auto input = inputs_.size();
+  for (;;) {
+    auto batch = stage.wait_for_input([&]() {
+      check();
+      return queue.front();
+    });
+    auto &lines = (*batch).lines;
+    if (lines.empty())
+      break;
+    if ((*batch).input != input) {
+      if (reader)
+        (*reader).flush(handler);
+      input = (*batch).input;
+      reader.emplace(inputs_[input], CSVReader::Push{});
+    }
+    for (auto &line : lines)
+      (*reader)(line.text, line.line_number, handler);
+    queue.pop();
+    ++stage;
+  }
+  queue.pop();
+  if (reader)
+    (*reader).flush(handler);
+  stage.log();
+}
+
+void Parallel::check() const {
+  if (ROQ_UNLIKELY(failed_.load(std::memory_order_acquire)))
+    throw Aborted{};
+}
+
+void Parallel::merge() {
+  struct Cursor final {
+    char const *begin;
+    char const *end;
+  };
+  std::vector<std::unique_ptr<MappedFile>> files;
+  std::vector<Cursor> cursors;
+  // note! ties are broken by shard index (stable)
+  using Item = std::pair<std::chrono::nanoseconds, size_t>;
+  std::priority_queue<Item, std::vector<Item>, std::greater<Item>> queue;
+  for (auto &shard : shards_) {
+    auto &file = files.emplace_back(std::make_unique<MappedFile>(shard));
+    auto data = file->data();
+    auto &cursor = cursors.emplace_back(Cursor{
+        .begin = data.data(),
+        .end = data.data() + data.size(),
+    });
+    if (cursor.begin < cursor.end)
+      queue.emplace(Frame::receive_time_utc(cursor.begin), cursors.size() - 1);
+  }
+  Processor processor(path_);
+  std::vector<uint8_t> buffer;  // note! re-used
+  while (!queue.empty()) {
+    auto index = queue.top().second;
+    queue.pop();
+    auto &cursor = cursors[index];
+    auto length = Frame::length(cursor.begin);
+    if (ROQ_UNLIKELY(cursor.begin + length > cursor.end))
+      throw RuntimeErrorException(R"(Truncated frame: path="{}")"_fmt, shards_[index]);
+    // note! copy so we can patch the frame
+    buffer.assign(cursor.begin, cursor.begin + length);
+    processor.forward(buffer.data());
+    cursor.begin += length;
+    if (cursor.begin < cursor.end)
+      queue.emplace(Frame::receive_time_utc(cursor.begin), index);
+  }
+  processor.close();
+  log::info("Merged {} shard(s)"_fmt, shards_.size());
+}
+
+}  // namespace import
+}  // namespace samples
+}  // namespace roq
@@ -0,0 +1,104 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "roq/span.h"
+
+#include "roq/samples/import/handler.h"
+#include "roq/samples/import/mapped_file.h"
+#include "roq/samples/import/processor.h"
+#include "roq/samples/import/snapshotter.h"
+#include "roq/samples/import/spsc_queue.h"
+
+namespace roq {
+namespace samples {
+namespace import {
+
+// multi-threaded import
+//
+// 1. each shard is parsed and encoded by a worker thread (with its own
+//    FlatBufferBuilder) to a temporary binary file
+// 2. shards are then k-way merged by receive_time_utc into the output
+//    (source_seqno is re-assigned so it remains monotonic)
+//
+// sharding
+//   file    one shard per input file (each file must be ordered by time)
+//   symbol  one shard per thread, the input files are scanned once by the
+//           calling thread (the splitter) and lines are assigned by
+//           hash(symbol), batches of lines are handed to the workers by
+//           lock-free spsc queues (one per shard)
+//
+// note!
+//   lines are views into the input files, the files are kept mapped until
+//   all shards have been parsed
+//   a failed thread aborts the others (no thread is left waiting)
+//
+// snapshots (requires sharding by symbol)
+//   interval snapshots are stamped with the boundary and every shard injects
+//   all boundaries before the end of all shards, i.e. the shards are closed
+//   only when all shards have been parsed
+//   event snapshots are not supported (the count is per shard)
+
+class Parallel final {
+ public:
+  enum class ShardBy {
+    FILE,
+    SYMBOL,
+  };
+
+  Parallel(
+      const std::string_view &path,
+      const roq::span<std::string_view> &inputs,
+      size_t threads,
+      ShardBy);
+
+  Parallel(Parallel &&) = delete;
+  Parallel(const Parallel &) = delete;
+
+  ~Parallel();
+
+  void dispatch();
+
+ protected:
+  void encode(size_t shard);
+
+  void split();
+  void consume(size_t shard, Handler &);
+
+  void check() const;
+
+  void merge();
+
+ private:
+  const std::string_view path_;
+  const roq::span<std::string_view> inputs_;
+  const size_t threads_;
+  const ShardBy shard_by_;
+  std::vector<std::string> shards_;
+  // note! only kept open until all shards have been parsed when snapshotting
+  std::vector<std::unique_ptr<Processor>> processors_;
+  std::vector<std::unique_ptr<Snapshotter>> snapshotters_;
+  // sharding by symbol
+  struct Line final {
+    std::string_view text;
+    uint64_t line_number = {};
+  };
+  struct Batch final {
+    size_t input = {};
+    std::vector<Line> lines;  // note! empty means end of stream
+  };
+  std::vector<std::unique_ptr<MappedFile>> files_;
+  std::vector<std::unique_ptr<SPSCQueue<Batch>>> queues_;
+  std::atomic<bool> failed_ = {false};
+};
+
+}  // namespace import
+}  // namespace samples
+}  // namespace roq
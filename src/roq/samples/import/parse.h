@@ -0,0 +1,151 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+
+namespace roq {
+namespace samples {
+namespace import {
+
+// note!
+//   these helpers are used on the hot path of the readers
+//   they never allocate
+
+inline bool parse_integer(const std::string_view &text, uint64_t &result) {
+  if (text.empty() || text.size() > 19u)  // never overflow
+    return false;
+  uint64_t value = 0;
+  for (auto c : text) {
+    auto digit = static_cast<unsigned char>(c - '0');
+    if (digit > 9u)
+      return false;
+    value = value * 10u + digit;
+  }
+  result = value;
+  return true;
+}
+
+// fast path (Clinger): exact when mantissa < 2^53 and |exponent| <= 22
+// otherwise falls back to strtod
+inline bool parse_decimal(const std::string_view &text, double &result) {
+  static const double POW10[] = {
+      1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+  };
+  auto iter = text.begin(), end = text.end();
+  if (iter == end)
+    return false;
+  auto negative = *iter == '-';
+  if (negative || *iter == '+')
+    ++iter;
+  uint64_t mantissa = 0;
+  int32_t digits = 0, exponent = 0;
+  auto any = false;
+  for (; iter != end && static_cast<unsigned char>(*iter - '0') <= 9u; ++iter, any = true) {
+    if (digits < 19) {
+      mantissa = mantissa * 10u + static_cast<unsigned char>(*iter - '0');
+      digits += mantissa != 0 ? 1 : 0;
+    } else {
+      ++exponent;
+    }
+  }
+  if (iter != end && *iter == '.') {
+    ++iter;
+    for (; iter != end && static_cast<unsigned char>(*iter - '0') <= 9u; ++iter, any = true) {
+      if (digits < 19) {
+        mantissa = mantissa * 10u + static_cast<unsigned char>(*iter - '0');
+        digits += mantissa != 0 ? 1 : 0;
+        --exponent;
+      }
+    }
+  }
+  if (!any)
+    return false;
+  if (iter != end && (*iter == 'e' || *iter == 'E')) {
+    ++iter;
+    auto negative_exponent = iter != end && *iter == '-';
+    if (iter != end && (*iter == '-' || *iter == '+'))
+      ++iter;
+    int32_t value = 0;
+    if (iter == end)
+      return false;
+    for (; iter != end && static_cast<unsigned char>(*iter - '0') <= 9u; ++iter)
+      value = value < 10000 ? value * 10 + (*iter - '0') : value;
+    exponent += negative_exponent ? -value : value;
+  }
+  if (iter != end)
+    return false;
+  if (mantissa < (uint64_t{1} << 53) && exponent >= -22 && exponent <= 22) {
+    auto value = static_cast<double>(mantissa);
+    value = exponent < 0 ? value / POW10[-exponent] : value * POW10[exponent];
+    result = negative ? -value : value;
+    return true;
+  }
+  // slow path (rare)
+  char buffer[64];
+  if (text.size() >= sizeof(buffer))
+    return false;
+  std::memcpy(buffer, text.data(), text.size());
+  buffer[text.size()] = '\0';
+  result = std::strtod(buffer, nullptr);
+  return true;
+}
+
+// utc only, e.g. 2019-08-14T20:42:27.265Z (up to 9 fractional digits)
+inline bool parse_iso8601(const std::string_view &text, std::chrono::nanoseconds &result) {
+  if (text.size() < 20u || text[4] != '-' || text[7] != '-' || text[10] != 'T' ||
+      text[13] != ':' || text[16] != ':' || text.back() != 'Z')
+    return false;
+  auto number = [&](size_t offset, size_t length, int64_t &value) {
+    value = 0;
+    for (size_t i = offset; i < (offset + length); ++i) {
+      auto digit = static_cast<unsigned char>(text[i] - '0');
+      if (digit > 9u)
+        return false;
+      value = value * 10 + digit;
+    }
+    return true;
+  };
+  int64_t year, month, day, hour, minute, second;
+  if (!(number(0, 4, year) && number(5, 2, month) && number(8, 2, day) && number(11, 2, hour) &&
+        number(14, 2, minute) && number(17, 2, second)))
+    return false;
+  if (month < 1 || month > 12 || day < 1 || day > 31)
+    return false;
+  int64_t fraction = 0;
+  size_t position = 19, end = text.size() - 1, digits = 0;
+  if (position < end) {
+    if (text[position] != '.' || (position + 1) == end)
+      return false;
+    for (++position; position < end; ++position) {
+      auto digit = static_cast<unsigned char>(text[position] - '0');
+      if (digit > 9u)
+        return false;
+      if (digits < 9u) {
+        fraction = fraction * 10 + digit;
+        ++digits;
+      }
+    }
+  }
+  for (; digits < 9u; ++digits)
+    fraction *= 10;
+  // days from civil (proleptic gregorian)
+  year -= month <= 2 ? 1 : 0;
+  auto era = year / 400;
+  auto year_of_era = year - era * 400;
+  auto day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+  auto day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+  auto days = era * 146097 + day_of_era - 719468;
+  auto seconds = ((days * 24 + hour) * 60 + minute) * 60 + second;
+  result = std::chrono::nanoseconds{seconds * 1000000000 + fraction};
+  return true;
+}
+
+}  // namespace import
+}  // namespace samples
+}  // namespace roq
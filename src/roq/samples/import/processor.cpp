@@ -3,17 +3,17 @@
 #include "roq/samples/import/processor.h"
 
 #include <cassert>
-#include <iostream>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
 
 #include "roq/fbs/api.h"
-#include "roq/fbs/encode.h"
 
 #include "roq/utils/compare.h"
 
 #include "roq/samples/import/base64.h"
 #include "roq/samples/import/flags.h"
+#include "roq/samples/import/frame.h"
 
 using namespace std::chrono_literals;
 using namespace roq::literals;
@@ -28,34 +28,147 @@ static const auto SYMBOL = "GEZ1"_sv;
 static const auto TICK_SIZE = 0.0025;
 static const auto MULTIPLIER = 2500.0;
 static const auto MIN_TRADE_VOL = 1.0;  // 1 lot
+static const size_t PIPELINE_BLOCKS = 4;
+static const size_t FRAME_SIZE = 1024;  // pre-allocated (per slot), grows if needed
 }  // namespace
 
 namespace {
-static bool use_base64() {
+static Processor::Encoding parse_encoding() {
   auto encoding = Flags::encoding();
   if (utils::case_insensitive_compare(encoding, "binary"_sv) == 0)
-    return false;
+    return Processor::Encoding::BINARY;
   if (utils::case_insensitive_compare(encoding, "base64"_sv) == 0)
-    return true;
+    return Processor::Encoding::BASE64;
+  if (utils::case_insensitive_compare(encoding, "lz4"_sv) == 0)
+    return Processor::Encoding::LZ4;
+  if (utils::case_insensitive_compare(encoding, "zstd"_sv) == 0)
+    return Processor::Encoding::ZSTD;
   throw RuntimeErrorException(R"(Unknown encoding="{}")"_fmt, encoding);
 }
 }  // namespace
 
 Processor::Processor(const std::string_view &path)
-    : file_(std::string{path}, std::ios::out | std::ios::binary),
-      encoding_(use_base64() ? Encoding::BASE64 : Encoding::BINARY) {
-  if (!file_)
-    throw RuntimeErrorException(R"(Unable to open file for writing: path="{}")"_fmt, path);
+    : Processor(path, parse_encoding(), Flags::index_interval(), Flags::pipeline()) {
+}
+
+Processor::Processor(const std::string_view &path, Encoding encoding)
+    : Processor(path, encoding, 0u, false) {
+}
+
+Processor::Processor(
+    const std::string_view &path, Encoding encoding, uint32_t index_interval, bool pipeline)
+    : parse_("parse"_sv), encode_("encode"_sv),
+      writer_(
+          path,
+          Flags::block_size(),
+          Flags::direct_io(),
+          Flags::preallocate(),
+          pipeline ? PIPELINE_BLOCKS : 1u,
+          &encode_),
+      encoding_(encoding), batching_(Flags::batching()) {
+  switch (encoding_) {
+    case Encoding::BINARY:
+    case Encoding::BASE64:
+      break;
+    case Encoding::LZ4:
+    case Encoding::ZSTD:
+      compressor_ = std::make_unique<Compressor>(
+          writer_,
+          encoding_ == Encoding::LZ4 ? Codec::LZ4 : Codec::ZSTD,
+          Flags::compression_level(),
+          Flags::compression_block_size(),
+          Flags::dictionary_samples(),
+          Flags::dictionary_size());
+      break;
+  }
+  if (index_interval > 0)
+    index_ = std::make_unique<IndexWriter>(Index::path(path), std::chrono::seconds{index_interval});
+  if (pipeline) {
+    queue_ = std::make_unique<SPSCQueue<Slot>>(Flags::pipeline_frames());
+    for (auto &slot : queue_->slots())
+      slot.frame.reserve(FRAME_SIZE);
+    thread_ = std::thread([this]() { run(); });
+  }
 }
 
 Processor::~Processor() {
   try {
     // best effort
-    if (file_.is_open())
-      file_.close();
+    close();
   } catch (...) {
   }
+  if (thread_.joinable())
+    thread_.join();
+}
+
+void Processor::close() {
+  if (closed_)
+    return;
+  closed_ = true;
+  if (queue_) {
+    // note! the encode stage flushes when it sees the end of stream
+    auto slot = parse_.wait_for_output([this]() { return queue_->claim(); });
+    slot->frame.clear();
+    queue_->push();
+    thread_.join();
+    parse_.log();
+    encode_.log();
+    if (error_)
+      std::rethrow_exception(error_);
+  } else {
+    flush();
+    if (compressor_)
+      compressor_->flush();
+  }
+  writer_.close();
+  if (index_)
+    index_->close();
 }
+
+void Processor::operator()(
+    const GatewaySettings &gateway_settings, std::chrono::nanoseconds timestamp_utc) {
+  process(gateway_settings, timestamp_utc);
+}
+
+void Processor::operator()(
+    const ReferenceData &reference_data, std::chrono::nanoseconds timestamp_utc) {
+  check_gateway_settings(timestamp_utc);
+  process(reference_data, timestamp_utc);
+}
+
+void Processor::operator()(
+    const MarketStatus &market_status, std::chrono::nanoseconds timestamp_utc) {
+  check_gateway_settings(timestamp_utc);
+  process(market_status, timestamp_utc);
+}
+
+void Processor::operator()(
+    const MarketByPriceUpdate &market_by_price_update, std::chrono::nanoseconds timestamp_utc) {
+  check_gateway_settings(timestamp_utc);
+  process(market_by_price_update, timestamp_utc);
+}
+
+void Processor::operator()(
+    const MarketByOrderUpdate &market_by_order_update, std::chrono::nanoseconds timestamp_utc) {
+  check_gateway_settings(timestamp_utc);
+  process(market_by_order_update, timestamp_utc);
+}
+
+void Processor::operator()(
+    const TradeSummary &trade_summary, std::chrono::nanoseconds timestamp_utc) {
+  check_gateway_settings(timestamp_utc);
+  process(trade_summary, timestamp_utc);
+}
+
+void Processor::forward(void *frame) {
+  // note! we always inject our own GatewaySettings
+  if (Frame::type(frame) == fbs::Message::GatewaySettings)
+    return;
+  check_gateway_settings(Frame::receive_time_utc(frame));
+  Frame::set_source_seqno(frame, ++seqno_);
+  publish(frame, Frame::length(frame), Frame::receive_time_utc(frame));
+}
+
 void Processor::dispatch() {
   // first message *must* be GatewaySettings
   process(
@@ -140,6 +253,19 @@ void Processor::dispatch() {
       5ns);
 }
 
+// first message *must* be GatewaySettings
+// note! readers don't know about the gateway, so we inject it here
+void Processor::check_gateway_settings(std::chrono::nanoseconds timestamp_utc) {
+  if (ROQ_LIKELY(gateway_settings_))
+    return;
+  process(
+      GatewaySettings{
+          .mbp_max_depth = Flags::mbp_max_depth(),
+          .mbp_allow_price_inversion = false,
+      },
+      timestamp_utc);
+}
+
 MessageInfo Processor::create_message_info(std::chrono::nanoseconds timestamp_utc) {
   // note! just re-use the same timestamp for all trace points
   return MessageInfo{
@@ -153,29 +279,117 @@ MessageInfo Processor::create_message_info(std::chrono::nanoseconds timestamp_ut
       .source_receive_time = timestamp_utc,
       .origin_create_time = timestamp_utc,
       .origin_create_time_utc = timestamp_utc,
-      .is_last = true,  // messages can be batched
+      .is_last = true,  // note! batching may patch this later
       .opaque = {},     // unused
   };
 }
 
 template <typename T>
 void Processor::process(const T &value, std::chrono::nanoseconds timestamp_utc) {
-  builder_.Clear();
+  if constexpr (std::is_same<T, GatewaySettings>::value)
+    gateway_settings_ = true;
   auto message_info = create_message_info(timestamp_utc);
   Event<T> event(message_info, value);
-  auto root = fbs::encode(builder_, event);
-  builder_.FinishSizePrefixed(root);  // note! *must* include size
-  auto data = builder_.GetBufferPointer();
-  auto length = builder_.GetSize();
+  encoder_(event);
+  publish(encoder_.data(), encoder_.size(), timestamp_utc);
+}
+
+// parse stage
+void Processor::publish(void const *data, size_t length, std::chrono::nanoseconds timestamp_utc) {
+  if (!queue_) {
+    enqueue(data, length, timestamp_utc);
+    return;
+  }
+  if (ROQ_UNLIKELY(failed_.load(std::memory_order_acquire)))
+    std::rethrow_exception(error_);
+  auto slot = parse_.wait_for_output([this]() { return queue_->claim(); });
+  auto begin = static_cast<uint8_t const *>(data);
+  slot->frame.assign(begin, begin + length);  // note! capacity is re-used
+  slot->timestamp_utc = timestamp_utc;
+  queue_->push();
+  ++parse_;
+}
+
+// batching
+// note!
+//   we hold back one frame until we know if the next frame shares the
+//   same timestamp, in which case the held back frame is patched to
+//   have is_last=false (consumers can then update once per batch)
+void Processor::enqueue(void const *data, size_t length, std::chrono::nanoseconds timestamp_utc) {
+  if (!batching_) {
+    write(data, length);
+    return;
+  }
+  if (!pending_.empty()) {
+    // note! always patch, forwarded frames may already have been batched
+    Frame::set_is_last(pending_.data(), timestamp_utc != pending_timestamp_);
+    write(pending_.data(), pending_.size());
+  }
+  auto begin = static_cast<uint8_t const *>(data);
+  pending_.assign(begin, begin + length);
+  pending_timestamp_ = timestamp_utc;
+}
+
+void Processor::flush() {
+  if (pending_.empty())
+    return;
+  Frame::set_is_last(pending_.data(), true);
+  write(pending_.data(), pending_.size());
+  pending_.clear();
+}
+
+// note! data is always a (binary) frame
+void Processor::write(void const *data, size_t length) {
+  auto position = writer_.position();
   switch (encoding_) {
     case Encoding::BINARY:
-      file_.write(reinterpret_cast<char const *>(data), length);
+      if (index_)
+        (*index_)(data, position);
+      writer_.write(data, length);
       break;
     case Encoding::BASE64: {
-      auto message = Base64::encode(data, length);
-      file_.write(message.c_str(), message.length());
+      auto size = Base64::encoded_length(length);
+      if (buffer_.size() < size)
+        buffer_.resize(size);
+      auto result = Base64::encode(buffer_.data(), data, length);
+      if (index_)
+        (*index_)(data, position);
+      writer_.write(buffer_.data(), result);
       break;
     }
+    case Encoding::LZ4:
+    case Encoding::ZSTD:
+      // note! only frames starting a block can be checkpoints
+      if (compressor_->write(data, length) && index_)
+        (*index_)(data, writer_.position());
+      break;
+  }
+}
+
+// encode stage
+void Processor::run() {
+  for (;;) {
+    auto slot = encode_.wait_for_input([this]() { return queue_->front(); });
+    auto last = slot->frame.empty();
+    // note! after a failure we keep draining so the parse stage never blocks
+    if (!error_) {
+      try {
+        if (last) {
+          flush();
+          if (compressor_)
+            compressor_->flush();
+        } else {
+          enqueue(slot->frame.data(), slot->frame.size(), slot->timestamp_utc);
+          ++encode_;
+        }
+      } catch (...) {
+        error_ = std::current_exception();
+        failed_.store(true, std::memory_order_release);
+      }
+    }
+    queue_->pop();
+    if (last)
+      break;
   }
 }
 
@@ -2,43 +2,124 @@
 
 #pragma once
 
-#include <flatbuffers/flatbuffers.h>
-
+#include <atomic>
 #include <chrono>
-#include <fstream>
+#include <exception>
+#include <memory>
 #include <string_view>
+#include <thread>
+#include <vector>
 
 #include "roq/api.h"
 
+#include "roq/samples/import/compressor.h"
+#include "roq/samples/import/encoder.h"
+#include "roq/samples/import/handler.h"
+#include "roq/samples/import/index.h"
+#include "roq/samples/import/spsc_queue.h"
+#include "roq/samples/import/stage.h"
+#include "roq/samples/import/writer.h"
+
 namespace roq {
 namespace samples {
 namespace import {
 
-class Processor final {
+// encodes messages and writes them to the output
+//
+// pipeline (optional)
+//
+//   parse   the calling thread (readers) encodes each message as a frame
+//           into a pre-allocated slot of a bounded queue
+//   encode  batching, output encoding (base64, lz4, zstd) and indexing
+//   write   full blocks are written by the writer's background thread
+//
+// stages are connected by lock-free spsc queues and a stage only waits when
+// its output queue is full (backpressure) or its input queue is empty, i.e.
+// the throughput is that of the slowest stage
+// utilization of each stage is logged when the processor is closed
+//
+// note!
+//   frames are the hand-off format since all views passed by the readers are
+//   only valid for the duration of the callback
+
+class Processor final : public Handler {
  public:
+  enum class Encoding {
+    BINARY,
+    BASE64,
+    LZ4,
+    ZSTD,
+  };
+
+  // note! encoding, index and pipeline from flags
   explicit Processor(const std::string_view &path);
+  Processor(const std::string_view &path, Encoding);
+  // note! index_interval is in seconds (0 means no index)
+  Processor(const std::string_view &path, Encoding, uint32_t index_interval, bool pipeline);
 
-  Processor(Processor &&) = default;
+  Processor(Processor &&) = delete;
   Processor(const Processor &) = delete;
 
   ~Processor();
 
   void dispatch();
 
+  // flush all pending data and close the output (and the index)
+  // note! must be called to detect errors, the destructor is best effort
+  void close();
+
+  void operator()(const GatewaySettings &, std::chrono::nanoseconds timestamp_utc) override;
+  void operator()(const ReferenceData &, std::chrono::nanoseconds timestamp_utc) override;
+  void operator()(const MarketStatus &, std::chrono::nanoseconds timestamp_utc) override;
+  void operator()(const MarketByPriceUpdate &, std::chrono::nanoseconds timestamp_utc) override;
+  void operator()(const MarketByOrderUpdate &, std::chrono::nanoseconds timestamp_utc) override;
+  void operator()(const TradeSummary &, std::chrono::nanoseconds timestamp_utc) override;
+
+  // re-sequence and write a frame which has already been encoded
+  void forward(void *frame);
+
  protected:
+  void check_gateway_settings(std::chrono::nanoseconds timestamp_utc);
+
   MessageInfo create_message_info(std::chrono::nanoseconds timestamp_utc);
 
   template <typename T>
   void process(const T &value, std::chrono::nanoseconds timestamp_utc);
 
+  void publish(void const *data, size_t length, std::chrono::nanoseconds timestamp_utc);
+
+  void enqueue(void const *data, size_t length, std::chrono::nanoseconds timestamp_utc);
+  void flush();
+
+  void run();
+
+  void write(void const *data, size_t length);
+
  private:
+  struct Slot final {
+    std::vector<uint8_t> frame;  // note! empty means end of stream
+    std::chrono::nanoseconds timestamp_utc = {};
+  };
+
   uint64_t seqno_ = {};
-  flatbuffers::FlatBufferBuilder builder_;
-  std::ofstream file_;
-  enum class Encoding {
-    BINARY,
-    BASE64,
-  } encoding_ = Encoding::BINARY;
+  bool gateway_settings_ = false;
+  bool closed_ = false;
+  Encoder encoder_;
+  Stage parse_;
+  Stage encode_;  // note! must be declared before the writer
+  Writer writer_;
+  const Encoding encoding_;
+  const bool batching_;
+  std::vector<uint8_t> pending_;  // note! re-used (batching)
+  std::chrono::nanoseconds pending_timestamp_ = {};
+  std::vector<char> buffer_;  // note! re-used (base64)
+  std::unique_ptr<Compressor> compressor_;  // note! only used with lz4/zstd
+  std::unique_ptr<IndexWriter> index_;
+  // pipeline
+  std::unique_ptr<SPSCQueue<Slot>> queue_;  // note! only used when pipelined
+  std::thread thread_;
+  std::exception_ptr error_;
+  std::atomic<bool> failed_ = {false};
 };
 
 }  // namespace import
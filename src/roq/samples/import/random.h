@@ -0,0 +1,64 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+namespace roq {
+namespace samples {
+namespace import {
+
+// xoshiro256** (seeded by splitmix64)
+// note!
+//   much faster than the std::mt19937_64 + std::*_distribution combination
+//   and more than good enough for generating test data
+
+class Random final {
+ public:
+  explicit Random(uint64_t seed) {
+    for (auto &state : state_) {
+      seed += 0x9e3779b97f4a7c15u;
+      auto z = seed;
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9u;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebu;
+      state = z ^ (z >> 31);
+    }
+  }
+
+  uint64_t operator()() {
+    auto result = rotl(state_[1] * 5, 7) * 9;
+    auto t = state_[1] << 17;
+    state_[2] ^= state_[0];
+    state_[3] ^= state_[1];
+    state_[1] ^= state_[2];
+    state_[0] ^= state_[3];
+    state_[2] ^= t;
+    state_[3] = rotl(state_[3], 45);
+    return result;
+  }
+
+  // [0, 1)
+  double uniform() { return static_cast<double>((*this)() >> 11) * 0x1.0p-53; }
+
+  // [0, n)
+  // note! multiply-shift (avoids the division of operator%)
+  uint64_t below(uint64_t n) {
+    return static_cast<uint64_t>((static_cast<unsigned __int128>((*this)()) * n) >> 64);
+  }
+
+  bool chance(double probability) { return uniform() < probability; }
+
+  // exponentially distributed (inter-arrival times of a poisson process)
+  double exponential(double mean) { return -std::log1p(-uniform()) * mean; }
+
+ protected:
+  static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+ private:
+  uint64_t state_[4];
+};
+
+}  // namespace import
+}  // namespace samples
+}  // namespace roq
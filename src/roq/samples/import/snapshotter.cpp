@@ -0,0 +1,258 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#include "roq/samples/import/snapshotter.h"
+
+#include <initializer_list>
+#include <utility>
+
+#include "roq/logging.h"
+
+#include "roq/samples/import/flags.h"
+
+using namespace roq::literals;
+
+namespace roq {
+namespace samples {
+namespace import {
+
+Snapshotter::Snapshotter(Handler &handler)
+    : Snapshotter(
+          handler, std::chrono::seconds{Flags::snapshot_interval()}, Flags::snapshot_events()) {
+}
+
+Snapshotter::Snapshotter(
+    Handler &handler, std::chrono::nanoseconds interval, uint64_t events, bool aligned)
+    : handler_(handler), interval_(interval), events_(events), aligned_(aligned) {
+}
+
+Snapshotter::Snapshotter(Handler &handler, Aligned)
+    : Snapshotter(handler, std::chrono::seconds{Flags::snapshot_interval()}, 0u, true) {
+}
+
+bool Snapshotter::enabled() {
+  return Flags::snapshot_interval() > 0u || Flags::snapshot_events() > 0u;
+}
+
+void Snapshotter::flush(std::chrono::nanoseconds timestamp_utc) {
+  check_interval(timestamp_utc);
+}
+
+void Snapshotter::operator()(
+    const GatewaySettings &gateway_settings, std::chrono::nanoseconds timestamp_utc) {
+  handler_(gateway_settings, timestamp_utc);
+}
+
+void Snapshotter::operator()(
+    const ReferenceData &reference_data, std::chrono::nanoseconds timestamp_utc) {
+  check(timestamp_utc);
+  get_book(reference_data.exchange, reference_data.symbol).update(reference_data);
+  handler_(reference_data, timestamp_utc);
+}
+
+void Snapshotter::operator()(
+    const MarketStatus &market_status, std::chrono::nanoseconds timestamp_utc) {
+  check(timestamp_utc);
+  auto &book = get_book(market_status.exchange, market_status.symbol);
+  book.has_market_status = true;
+  book.trading_status = market_status.trading_status;
+  handler_(market_status, timestamp_utc);
+}
+
+void Snapshotter::operator()(
+    const MarketByPriceUpdate &market_by_price_update, std::chrono::nanoseconds timestamp_utc) {
+  check(timestamp_utc);
+  get_book(market_by_price_update.exchange, market_by_price_update.symbol)
+      .update(market_by_price_update);
+  handler_(market_by_price_update, timestamp_utc);
+}
+
+void Snapshotter::operator()(
+    const MarketByOrderUpdate &market_by_order_update, std::chrono::nanoseconds timestamp_utc) {
+  check(timestamp_utc);
+  get_book(market_by_order_update.exchange, market_by_order_update.symbol)
+      .update(market_by_order_update);
+  handler_(market_by_order_update, timestamp_utc);
+}
+
+void Snapshotter::operator()(
+    const TradeSummary &trade_summary, std::chrono::nanoseconds timestamp_utc) {
+  check(timestamp_utc);
+  handler_(trade_summary, timestamp_utc);
+}
+
+// note! we must own the strings
+void Snapshotter::Book::update(const ReferenceData &value) {
+  has_reference_data = true;
+  reference_data = value;
+  auto views = {
+      &reference_data.exchange,
+      &reference_data.symbol,
+      &reference_data.description,
+      &reference_data.currency,
+      &reference_data.settlement_currency,
+      &reference_data.commission_currency,
+      &reference_data.strike_currency,
+      &reference_data.underlying,
+      &reference_data.time_zone,
+  };
+  static_assert(std::tuple_size<decltype(strings)>::value == 9);
+  auto iter = std::begin(strings);
+  for (auto view : views) {
+    (*iter).assign(*view);
+    *view = *iter;
+    ++iter;
+  }
+}
+
+void Snapshotter::Book::update(const MarketByPriceUpdate &value) {
+  has_market_by_price = true;
+  if (value.snapshot) {
+    bids.clear();
+    asks.clear();
+  }
+  auto apply = [](auto &levels, auto &updates) {
+    for (auto &update : updates) {
+      if (update.quantity > 0.0)
+        levels[update.price] = update.quantity;
+      else
+        levels.erase(update.price);
+    }
+  };
+  apply(bids, value.bids);
+  apply(asks, value.asks);
+}
+
+void Snapshotter::Book::update(const MarketByOrderUpdate &value) {
+  has_market_by_order = true;
+  if (value.snapshot)
+    orders.clear();
+  auto apply = [this](auto side, auto &updates) {
+    for (auto &update : updates) {
+      key.assign(update.order_id);  // note! avoids allocating when the order exists
+      if (update.action == OrderUpdateAction::REMOVE || !(update.remaining_quantity > 0.0)) {
+        orders.erase(key);
+        continue;
+      }
+      orders[key] = {
+          .side = side,
+          .price = update.price,
+          .remaining_quantity = update.remaining_quantity,
+          .priority = update.priority,
+      };
+    }
+  };
+  apply(Side::BUY, value.bids);
+  apply(Side::SELL, value.asks);
+}
+
+Snapshotter::Book &Snapshotter::get_book(
+    const std::string_view &exchange, const std::string_view &symbol) {
+  key_.assign(exchange);
+  key_.push_back(':');
+  key_.append(symbol);
+  auto iter = books_.find(key_);
+  if (ROQ_LIKELY(iter != books_.end()))
+    return (*iter).second;
+  auto &book = books_[key_];
+  book.exchange = exchange;
+  book.symbol = symbol;
+  insertion_order_.emplace_back(&book);
+  return book;
+}
+
+void Snapshotter::check(std::chrono::nanoseconds timestamp_utc) {
+  timestamp_utc_ = timestamp_utc;
+  if (check_interval(timestamp_utc)) {
+    counter_ = 0;
+  } else if (events_ != 0 && counter_ >= events_) {
+    snapshot(timestamp_utc);
+    counter_ = 0;
+  }
+  ++counter_;  // note! includes the current event
+}
+
+bool Snapshotter::check_interval(std::chrono::nanoseconds timestamp_utc) {
+  if (interval_.count() == 0)
+    return false;
+  // note! the first boundary is the one at (or after) the first event
+  if (next_.count() == 0) {
+    next_ = ((timestamp_utc + interval_ - std::chrono::nanoseconds{1}) / interval_) * interval_;
+    return false;
+  }
+  // note! events at the boundary are included
+  if (ROQ_LIKELY(timestamp_utc <= next_))
+    return false;
+  auto last = ((timestamp_utc - std::chrono::nanoseconds{1}) / interval_) * interval_;
+  if (!aligned_)
+    next_ = last;  // note! only the last boundary
+  for (; next_ <= last; next_ += interval_)
+    snapshot(next_);
+  return true;
+}
+
+void Snapshotter::snapshot(std::chrono::nanoseconds timestamp_utc) {
+  log::debug("Snapshot: timestamp_utc={}, books={}"_fmt, timestamp_utc, insertion_order_.size());
+  for (auto book : insertion_order_)
+    snapshot(*book, timestamp_utc);
+}
+
+void Snapshotter::snapshot(Book &book, std::chrono::nanoseconds timestamp_utc) {
+  if (book.has_reference_data)
+    handler_(book.reference_data, timestamp_utc);
+  if (book.has_market_status)
+    handler_(
+        MarketStatus{
+            .stream_id = {},
+            .exchange = book.exchange,
+            .symbol = book.symbol,
+            .trading_status = book.trading_status,
+        },
+        timestamp_utc);
+  if (book.has_market_by_price) {
+    bids_.clear();
+    for (auto &[price, quantity] : book.bids)
+      bids_.push_back({.price = price, .quantity = quantity});
+    asks_.clear();
+    for (auto &[price, quantity] : book.asks)
+      asks_.push_back({.price = price, .quantity = quantity});
+    handler_(
+        MarketByPriceUpdate{
+            .stream_id = {},
+            .exchange = book.exchange,
+            .symbol = book.symbol,
+            .bids = bids_,
+            .asks = asks_,
+            .snapshot = true,
+            .exchange_time_utc = {},
+        },
+        timestamp_utc);
+  }
+  if (book.has_market_by_order) {
+    mbo_bids_.clear();
+    mbo_asks_.clear();
+    for (auto &[order_id, order] : book.orders)
+      (order.side == Side::BUY ? mbo_bids_ : mbo_asks_)
+          .push_back({
+              .price = order.price,
+              .remaining_quantity = order.remaining_quantity,
+              .action = OrderUpdateAction::NEW,
+              .priority = order.priority,
+              .order_id = order_id,
+          });
+    handler_(
+        MarketByOrderUpdate{
+            .stream_id = {},
+            .exchange = book.exchange,
+            .symbol = book.symbol,
+            .bids = mbo_bids_,
+            .asks = mbo_asks_,
+            .snapshot = true,
+            .exchange_time_utc = {},
+        },
+        timestamp_utc);
+  }
+}
+
+}  // namespace import
+}  // namespace samples
+}  // namespace roq
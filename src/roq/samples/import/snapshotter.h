@@ -0,0 +1,131 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "roq/api.h"
+
+#include "roq/samples/import/handler.h"
+
+namespace roq {
+namespace samples {
+namespace import {
+
+// keeps a book per symbol and periodically injects full snapshots
+//
+// at each snapshot boundary, and for each symbol, the latest ReferenceData
+// and MarketStatus are repeated, followed by a MarketByPriceUpdate (and a
+// MarketByOrderUpdate) image having snapshot=true
+//
+// a replay can then start from any snapshot boundary
+//
+// boundaries are
+//   interval  multiples of the interval (since epoch), i.e. aligned
+//             across files and shards
+//   events    every N events
+//
+// note!
+//   the snapshot is injected *before* the first event *after* the boundary
+//   interval snapshots use the time of the boundary, i.e. a snapshot includes
+//   all events having a timestamp up to (and including) the boundary
+//   event snapshots use the timestamp of the event
+//
+// aligned (shards)
+//   all boundaries crossed are snapshotted, also when there were no events,
+//   and flush() injects the boundaries before the end of the other shards
+//   the merged output then has a snapshot of every book before the first
+//   event after each boundary
+
+class Snapshotter final : public Handler {
+ public:
+  explicit Snapshotter(Handler &);  // note! triggers from flags
+  // note! zero disables the trigger
+  Snapshotter(
+      Handler &, std::chrono::nanoseconds interval, uint64_t events, bool aligned = false);
+
+  struct Aligned final {};
+  Snapshotter(Handler &, Aligned);  // note! interval from flags
+
+  static bool enabled();  // note! any trigger from flags
+
+  std::chrono::nanoseconds timestamp_utc() const { return timestamp_utc_; }  // note! last event
+
+  // inject the interval boundaries before timestamp_utc (e.g. the last event of all shards)
+  void flush(std::chrono::nanoseconds timestamp_utc);
+
+  Snapshotter(Snapshotter &&) = delete;
+  Snapshotter(const Snapshotter &) = delete;
+
+  void operator()(const GatewaySettings &, std::chrono::nanoseconds timestamp_utc) override;
+  void operator()(const ReferenceData &, std::chrono::nanoseconds timestamp_utc) override;
+  void operator()(const MarketStatus &, std::chrono::nanoseconds timestamp_utc) override;
+  void operator()(const MarketByPriceUpdate &, std::chrono::nanoseconds timestamp_utc) override;
+  void operator()(const MarketByOrderUpdate &, std::chrono::nanoseconds timestamp_utc) override;
+  void operator()(const TradeSummary &, std::chrono::nanoseconds timestamp_utc) override;
+
+ protected:
+  struct Order final {
+    Side side;
+    double price;
+    double remaining_quantity;
+    uint32_t priority;
+  };
+
+  struct Book final {
+    std::string exchange;
+    std::string symbol;
+    // note! views point into strings
+    bool has_reference_data = false;
+    ReferenceData reference_data = {};
+    std::array<std::string, 9> strings;
+    bool has_market_status = false;
+    TradingStatus trading_status = {};
+    bool has_market_by_price = false;
+    std::map<double, double, std::greater<double>> bids;
+    std::map<double, double> asks;
+    bool has_market_by_order = false;
+    std::unordered_map<std::string, Order> orders;
+    std::string key;  // note! re-used
+
+    void update(const ReferenceData &);
+    void update(const MarketByPriceUpdate &);
+    void update(const MarketByOrderUpdate &);
+  };
+
+  Book &get_book(const std::string_view &exchange, const std::string_view &symbol);
+
+  void check(std::chrono::nanoseconds timestamp_utc);
+
+  bool check_interval(std::chrono::nanoseconds timestamp_utc);
+
+  void snapshot(std::chrono::nanoseconds timestamp_utc);
+  void snapshot(Book &, std::chrono::nanoseconds timestamp_utc);
+
+ private:
+  Handler &handler_;
+  const std::chrono::nanoseconds interval_;
+  const uint64_t events_;
+  const bool aligned_;
+  std::chrono::nanoseconds next_ = {};
+  uint64_t counter_ = {};
+  std::chrono::nanoseconds timestamp_utc_ = {};
+  std::string key_;  // note! re-used
+  std::unordered_map<std::string, Book> books_;
+  std::vector<Book *> insertion_order_;  // note! deterministic output
+  // note! re-used to avoid allocations
+  std::vector<MBPUpdate> bids_;
+  std::vector<MBPUpdate> asks_;
+  std::vector<MBOUpdate> mbo_bids_;
+  std::vector<MBOUpdate> mbo_asks_;
+};
+
+}  // namespace import
+}  // namespace samples
+}  // namespace roq
@@ -0,0 +1,187 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#include "roq/samples/import/sorter.h"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <queue>
+#include <thread>
+#include <utility>
+
+#include "roq/exceptions.h"
+#include "roq/logging.h"
+
+#include "roq/samples/import/csv_reader.h"
+#include "roq/samples/import/flags.h"
+#include "roq/samples/import/parse.h"
+#include "roq/samples/import/writer.h"
+
+using namespace roq::literals;
+
+namespace roq {
+namespace samples {
+namespace import {
+
+namespace {
+// note! all message types have timestamp as the 2nd field
+static bool get_timestamp(const std::string_view &line, uint64_t &result) {
+  auto begin = line.data(), end = begin + line.size();
+  begin = static_cast<char const *>(std::memchr(begin, ',', end - begin));
+  if (begin == nullptr)
+    return false;
+  ++begin;
+  auto next = static_cast<char const *>(std::memchr(begin, ',', end - begin));
+  return parse_integer(std::string_view(begin, (next == nullptr ? end : next) - begin), result);
+}
+
+// returns the line and advances begin (past the line)
+static std::string_view next_line(char const *&begin, char const *end) {
+  auto next = static_cast<char const *>(std::memchr(begin, '\n', end - begin));
+  if (next == nullptr)
+    next = end;
+  std::string_view result(begin, next - begin);
+  if (!result.empty() && result.back() == '\r')  // windows line endings
+    result.remove_suffix(1);
+  begin = next < end ? next + 1 : end;
+  return result;
+}
+}  // namespace
+
+Sorter::Sorter(
+    const std::string_view &path,
+    const roq::span<std::string_view> &inputs,
+    size_t threads,
+    size_t run_size)
+    : path_(path), inputs_(inputs), threads_(std::max<size_t>(threads, 1)),
+      run_size_(std::max<size_t>(run_size, 1)) {
+}
+
+Sorter::~Sorter() {
+  // best effort
+  for (auto &run : runs_)
+    std::remove(run.c_str());
+}
+
+void Sorter::dispatch(Handler &handler) {
+  split();
+  // note! workers pull chunks until there are no more
+  std::atomic<size_t> next = {0};
+  std::vector<std::exception_ptr> errors(threads_);
+  std::vector<std::thread> workers;
+  workers.reserve(threads_);
+  for (size_t i = 0; i < threads_; ++i) {
+    workers.emplace_back([this, i, &next, &errors]() {
+      try {
+        std::vector<Line> lines;  // note! re-used
+        for (size_t run; (run = next++) < chunks_.size();)
+          generate(run, lines);
+      } catch (...) {
+        errors[i] = std::current_exception();
+      }
+    });
+  }
+  for (auto &worker : workers)
+    worker.join();
+  for (auto &error : errors)
+    if (error)
+      std::rethrow_exception(error);
+  // note! the inputs are no longer needed
+  files_.clear();
+  merge(handler);
+}
+
+// note! chunks always end at a line boundary
+void Sorter::split() {
+  for (size_t i = 0; i < inputs_.size(); ++i) {
+    auto &file = files_.emplace_back(std::make_unique<MappedFile>(inputs_[i]));
+    auto data = file->data();
+    size_t begin = 0;
+    while (begin < data.size()) {
+      auto end = std::min(begin + run_size_, data.size());
+      if (end < data.size()) {
+        auto next = static_cast<char const *>(
+            std::memchr(data.data() + end, '\n', data.size() - end));
+        end = next == nullptr ? data.size() : static_cast<size_t>(next - data.data()) + 1;
+      }
+      chunks_.push_back({.input = i, .begin = begin, .end = end});
+      begin = end;
+    }
+  }
+  for (size_t i = 0; i < chunks_.size(); ++i)
+    runs_.emplace_back(fmt::format("{}.run-{}", path_, i));
+  log::info("Sorting: inputs={}, runs={}, threads={}"_fmt, inputs_.size(), runs_.size(), threads_);
+}
+
+void Sorter::generate(size_t run, std::vector<Line> &lines) {
+  auto &chunk = chunks_[run];
+  auto data = files_[chunk.input]->data();
+  lines.clear();
+  auto begin = data.data() + chunk.begin, end = data.data() + chunk.end;
+  while (begin < end) {
+    auto line = next_line(begin, end);
+    if (line.empty() || line[0] == '#')
+      continue;
+    uint64_t timestamp;
+    if (!get_timestamp(line, timestamp))
+      throw RuntimeErrorException(
+          R"(Unable to parse timestamp: path="{}", line="{}")"_fmt, inputs_[chunk.input], line);
+    lines.push_back({.timestamp = timestamp, .data = line.data(), .length = line.size()});
+  }
+  std::stable_sort(std::begin(lines), std::end(lines), [](auto &lhs, auto &rhs) {
+    return lhs.timestamp < rhs.timestamp;
+  });
+  Writer writer(runs_[run], Flags::block_size(), Flags::direct_io(), 0u);
+  for (auto &line : lines) {
+    writer.write(line.data, line.length);
+    writer.write("\n", 1);
+  }
+  writer.close();
+}
+
+void Sorter::merge(Handler &handler) {
+  struct Cursor final {
+    char const *begin;
+    char const *end;
+    std::string_view line;
+  };
+  std::vector<std::unique_ptr<MappedFile>> files;
+  std::vector<Cursor> cursors;
+  // note! ties are broken by run index (stable)
+  using Item = std::pair<uint64_t, size_t>;
+  std::priority_queue<Item, std::vector<Item>, std::greater<Item>> queue;
+  auto advance = [&](size_t index) {
+    auto &cursor = cursors[index];
+    if (cursor.begin >= cursor.end)
+      return;
+    cursor.line = next_line(cursor.begin, cursor.end);
+    uint64_t timestamp;
+    if (!get_timestamp(cursor.line, timestamp))
+      throw RuntimeErrorException(R"(Unexpected: path="{}")"_fmt, runs_[index]);
+    queue.emplace(timestamp, index);
+  };
+  for (auto &run : runs_) {
+    auto &file = files.emplace_back(std::make_unique<MappedFile>(run));
+    auto data = file->data();
+    cursors.push_back({.begin = data.data(), .end = data.data() + data.size(), .line = {}});
+    advance(cursors.size() - 1);
+  }
+  CSVReader reader(path_, CSVReader::Push{});
+  while (!queue.empty()) {
+    auto index = queue.top().second;
+    queue.pop();
+    reader(cursors[index].line, handler);
+    advance(index);
+  }
+  reader.flush(handler);
+  log::info("Merged {} run(s)"_fmt, runs_.size());
+}
+
+}  // namespace import
+}  // namespace samples
+}  // namespace roq
@@ -0,0 +1,81 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "roq/span.h"
+
+#include "roq/samples/import/handler.h"
+#include "roq/samples/import/mapped_file.h"
+
+namespace roq {
+namespace samples {
+namespace import {
+
+// external (out-of-core) merge sort of delimited tick files by timestamp
+//
+// 1. run generation (parallel)
+//    inputs are split into chunks of (at most) run_size bytes at line
+//    boundaries, each chunk is sorted by timestamp and spilled to a
+//    temporary run file
+// 2. merge
+//    runs are k-way merged and each line is pushed to a CSVReader
+//
+// note!
+//   the sort is stable (lines sharing a timestamp keep their input order)
+//   lines are never copied into memory, only (timestamp, view) entries are
+//   sorted, i.e. memory is bounded by the number of lines in a run (times
+//   the number of threads)
+
+class Sorter final {
+ public:
+  Sorter(
+      const std::string_view &path,
+      const roq::span<std::string_view> &inputs,
+      size_t threads,
+      size_t run_size);
+
+  Sorter(Sorter &&) = delete;
+  Sorter(const Sorter &) = delete;
+
+  ~Sorter();
+
+  void dispatch(Handler &);
+
+ protected:
+  struct Chunk final {
+    size_t input;
+    size_t begin;
+    size_t end;
+  };
+
+  struct Line final {
+    uint64_t timestamp;
+    char const *data;
+    size_t length;
+  };
+
+  void split();
+
+  void generate(size_t run, std::vector<Line> &lines);
+
+  void merge(Handler &);
+
+ private:
+  const std::string_view path_;
+  const roq::span<std::string_view> inputs_;
+  const size_t threads_;
+  const size_t run_size_;
+  std::vector<std::unique_ptr<MappedFile>> files_;
+  std::vector<Chunk> chunks_;
+  std::vector<std::string> runs_;
+};
+
+}  // namespace import
+}  // namespace samples
+}  // namespace roq
@@ -0,0 +1,85 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "roq/exceptions.h"
+
+namespace roq {
+namespace samples {
+namespace import {
+
+// bounded lock-free single-producer single-consumer queue
+//
+// slots are pre-allocated and re-used: the producer fills a slot in place
+// (claim, then push) and the consumer reads it in place (front, then pop)
+//
+// note!
+//   capacity must be a power of two
+//   claim (front) returns nullptr when the queue is full (empty), the caller
+//   decides how to wait (backpressure)
+//   each side caches the other side's index to avoid sharing cache lines
+
+template <typename T>
+class SPSCQueue final {
+ public:
+  explicit SPSCQueue(size_t capacity) : mask_(capacity - 1), slots_(capacity) {
+    using namespace roq::literals;
+    if (capacity == 0 || (capacity & mask_) != 0)
+      throw RuntimeErrorException("Capacity must be a power of two, got {}"_fmt, capacity);
+  }
+
+  SPSCQueue(SPSCQueue &&) = delete;
+  SPSCQueue(const SPSCQueue &) = delete;
+
+  size_t capacity() const { return slots_.size(); }
+
+  // note! used to pre-allocate the slots (before any thread is started)
+  std::vector<T> &slots() { return slots_; }
+
+  // producer
+
+  T *claim() {
+    auto head = head_.load(std::memory_order_relaxed);
+    if ((head - tail_cache_) > mask_) {
+      tail_cache_ = tail_.load(std::memory_order_acquire);
+      if ((head - tail_cache_) > mask_)
+        return nullptr;
+    }
+    return &slots_[head & mask_];
+  }
+
+  void push() { head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+  // consumer
+
+  T *front() {
+    auto tail = tail_.load(std::memory_order_relaxed);
+    if (tail == head_cache_) {
+      head_cache_ = head_.load(std::memory_order_acquire);
+      if (tail == head_cache_)
+        return nullptr;
+    }
+    return &slots_[tail & mask_];
+  }
+
+  void pop() { tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+ private:
+  static constexpr size_t CACHE_LINE_SIZE = 64;
+
+  const uint64_t mask_;
+  std::vector<T> slots_;
+  alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> head_ = {};
+  uint64_t tail_cache_ = {};  // note! producer only
+  alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> tail_ = {};
+  uint64_t head_cache_ = {};  // note! consumer only
+};
+
+}  // namespace import
+}  // namespace samples
+}  // namespace roq
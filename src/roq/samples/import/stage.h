@@ -0,0 +1,90 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <thread>
+
+#include "roq/logging.h"
+
+namespace roq {
+namespace samples {
+namespace import {
+
+// utilization counters of a pipeline stage
+//
+//   starved  time spent waiting for input (upstream is slower)
+//   blocked  time spent waiting for output (backpressure, downstream is slower)
+//
+// the remaining time is busy, i.e. the slowest stage is the one with the
+// highest utilization
+
+class Stage final {
+ public:
+  explicit Stage(const std::string_view &name)
+      : name_(name), start_(std::chrono::steady_clock::now()) {}
+
+  Stage(Stage &&) = delete;
+  Stage(const Stage &) = delete;
+
+  // polls until the result is not null
+  template <typename F>
+  auto wait_for_input(F &&poll) {
+    return wait(poll, starved_);
+  }
+
+  template <typename F>
+  auto wait_for_output(F &&poll) {
+    return wait(poll, blocked_);
+  }
+
+  void operator++() { ++items_; }
+
+  void log() const {
+    using namespace roq::literals;
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_);
+    auto percent = [&](std::chrono::nanoseconds value) {
+      return elapsed.count() > 0.0
+                 ? 100.0 * std::chrono::duration<double>(value).count() / elapsed.count()
+                 : 0.0;
+    };
+    log::info(
+        "Pipeline: stage={}, items={}, utilization={:.1f}%, starved={:.1f}%, blocked={:.1f}%"_fmt,
+        name_,
+        items_,
+        100.0 - percent(starved_) - percent(blocked_),
+        percent(starved_),
+        percent(blocked_));
+  }
+
+ protected:
+  // note! spin briefly before yielding (the other stage is usually close)
+  template <typename F>
+  static auto wait(F &poll, std::chrono::nanoseconds &waited) {
+    auto result = poll();
+    if (result != nullptr)
+      return result;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; (result = poll()) == nullptr; ++i)
+      if (i >= SPIN_COUNT)
+        std::this_thread::yield();
+    waited += std::chrono::steady_clock::now() - start;
+    return result;
+  }
+
+ private:
+  static constexpr size_t SPIN_COUNT = 1000;
+
+  const std::string_view name_;
+  const std::chrono::steady_clock::time_point start_;
+  uint64_t items_ = {};
+  std::chrono::nanoseconds starved_ = {};
+  std::chrono::nanoseconds blocked_ = {};
+};
+
+}  // namespace import
+}  // namespace samples
+}  // namespace roq
@@ -0,0 +1,159 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#include "roq/samples/import/validator.h"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <functional>
+
+#include "roq/exceptions.h"
+#include "roq/logging.h"
+
+using namespace roq::literals;
+
+namespace roq {
+namespace samples {
+namespace import {
+
+namespace {
+static size_t round_up_to_power_of_two(size_t value) {
+  size_t result = 1;
+  while (result < value)
+    result <<= 1;
+  return result;
+}
+
+// note! zero is reserved (unknown)
+static uint64_t hash(const std::string_view &message) {
+  return std::hash<std::string_view>()(message) | 1u;
+}
+}  // namespace
+
+Validator::Validator(size_t window, const std::string_view &markers)
+    : mask_(round_up_to_power_of_two(std::max<size_t>(window, 1)) - 1), markers_path_(markers) {
+  if (!markers_path_.empty()) {
+    markers_ = std::fopen(markers_path_.c_str(), "w");
+    if (markers_ == nullptr)
+      throw RuntimeErrorException(
+          R"(Unable to open file for writing: path="{}", error="{}")"_fmt,
+          markers_path_,
+          std::strerror(errno));
+    std::fputs("channel,first_missing_seqno,last_missing_seqno\n", markers_);
+  }
+}
+
+Validator::~Validator() {
+  try {
+    // best effort
+    close();
+  } catch (...) {
+  }
+}
+
+bool Validator::operator()(
+    const std::string_view &channel, uint64_t seqno, const std::string_view &message) {
+  auto &state = get_channel(channel);
+  auto &slot = state.hashes[seqno & mask_];
+  if (seqno == state.expected) {
+    slot = hash(message);
+    ++state.expected;
+    ++stats_.accepted;
+    return true;
+  }
+  if (state.expected == 0 || seqno > state.expected) {
+    if (state.expected != 0)
+      gap(state, state.expected, seqno - 1);
+    else
+      state.first = seqno;
+    slot = hash(message);
+    state.expected = seqno + 1;
+    ++stats_.accepted;
+    return true;
+  }
+  // older
+  if (seqno < state.first || (state.expected - seqno) > mask_) {
+    ++stats_.stale;
+    return false;
+  }
+  auto value = hash(message);
+  if (slot == value) {
+    ++stats_.duplicates;
+    return false;
+  }
+  if (slot == 0) {
+    // note! would fill a gap, but newer lines have already been emitted
+    ++stats_.late;
+    return false;
+  }
+  log::warn(R"(Conflict: channel="{}", seqno={})"_fmt, state.name, seqno);
+  ++stats_.conflicts;
+  return false;
+}
+
+void Validator::close() {
+  if (closed_)
+    return;
+  closed_ = true;
+  if (markers_ != nullptr) {
+    auto result = std::fclose(markers_);
+    markers_ = nullptr;
+    if (result != 0)
+      throw RuntimeErrorException(R"(Unable to write: path="{}")"_fmt, markers_path_);
+  }
+  log::info(
+      "Validator: channels={}, accepted={}, duplicates={}, conflicts={}, stale={}, "
+      "late={}, gaps={}, missing={}"_fmt,
+      channels_.size(),
+      stats_.accepted,
+      stats_.duplicates,
+      stats_.conflicts,
+      stats_.stale,
+      stats_.late,
+      stats_.gaps,
+      stats_.missing);
+}
+
+// note! there are typically very few channels
+Validator::Channel &Validator::get_channel(const std::string_view &channel) {
+  if (last_ < channels_.size() && channels_[last_].name.compare(channel) == 0)
+    return channels_[last_];
+  for (size_t i = 0; i < channels_.size(); ++i) {
+    if (channels_[i].name.compare(channel) == 0) {
+      last_ = i;
+      return channels_[i];
+    }
+  }
+  last_ = channels_.size();
+  auto &result = channels_.emplace_back();
+  result.name = channel;
+  result.hashes.resize(mask_ + 1);
+  return result;
+}
+
+void Validator::gap(Channel &channel, uint64_t first, uint64_t last) {
+  auto missing = last - first + 1;
+  log::warn(
+      R"(Gap: channel="{}", first={}, last={}, missing={})"_fmt,
+      channel.name,
+      first,
+      last,
+      missing);
+  ++stats_.gaps;
+  stats_.missing += missing;
+  // note! the content of the missing sequence numbers is unknown
+  if (missing > mask_) {
+    std::fill(channel.hashes.begin(), channel.hashes.end(), 0);
+  } else {
+    for (auto seqno = first; seqno <= last; ++seqno)
+      channel.hashes[seqno & mask_] = 0;
+  }
+  if (markers_ != nullptr)
+    fmt::print(markers_, "{},{},{}\n", channel.name, first, last);
+}
+
+}  // namespace import
+}  // namespace samples
+}  // namespace roq
@@ -0,0 +1,80 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace roq {
+namespace samples {
+namespace import {
+
+// vendor sequence validation (per channel)
+//
+// expected   accepted
+// gap        accepted, the gap is logged (and optionally a snapshot request
+//            marker is written to the markers file)
+// older      always dropped, classified as duplicate (the content is an exact
+//            duplicate (hash) of what was received for that sequence
+//            number), late (it would have filled a gap) or conflict
+//
+// note!
+//   late lines are dropped because they carry an older timestamp than what
+//   has already been emitted, i.e. the output stays ordered by time (the gap
+//   has already been reported and should be recovered from a snapshot)
+//   only the hashes of the most recent sequence numbers are kept (a ring
+//   indexed by sequence number), anything older (or older than the first
+//   sequence number of the channel) is dropped as stale
+
+class Validator final {
+ public:
+  // note! markers is optional (empty means no markers)
+  Validator(size_t window, const std::string_view &markers);
+
+  Validator(Validator &&) = delete;
+  Validator(const Validator &) = delete;
+
+  ~Validator();
+
+  // returns false if the message should be dropped
+  bool operator()(const std::string_view &channel, uint64_t seqno, const std::string_view &message);
+
+  // flush markers and log statistics
+  void close();
+
+ protected:
+  struct Channel final {
+    std::string name;
+    uint64_t first = {};
+    uint64_t expected = {};  // note! zero means nothing received yet
+    std::vector<uint64_t> hashes;  // note! zero means unknown
+  };
+
+  Channel &get_channel(const std::string_view &channel);
+
+  void gap(Channel &, uint64_t first, uint64_t last);
+
+ private:
+  const size_t mask_;
+  const std::string markers_path_;
+  std::FILE *markers_ = nullptr;
+  std::vector<Channel> channels_;
+  size_t last_ = {};  // note! most recently used channel
+  bool closed_ = false;
+  struct {
+    uint64_t accepted = {};
+    uint64_t duplicates = {};
+    uint64_t conflicts = {};
+    uint64_t stale = {};
+    uint64_t late = {};
+    uint64_t gaps = {};
+    uint64_t missing = {};
+  } stats_;
+};
+
+}  // namespace import
+}  // namespace samples
+}  // namespace roq
@@ -0,0 +1,281 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#include "roq/samples/import/verifier.h"
+
+#include <flatbuffers/flatbuffers.h>
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <thread>
+
+#include "roq/exceptions.h"
+#include "roq/logging.h"
+
+#include "roq/samples/import/base64.h"
+#include "roq/samples/import/codec.h"
+#include "roq/samples/import/decompressor.h"
+#include "roq/samples/import/frame.h"
+#include "roq/samples/import/index.h"
+
+using namespace roq::literals;
+
+namespace roq {
+namespace samples {
+namespace import {
+
+namespace {
+// note! enough to decode the size prefix
+static constexpr size_t BASE64_PREFIX_SIZE = Base64::encoded_length(Frame::PREFIX_SIZE);
+}  // namespace
+
+Verifier::Verifier(
+    const std::string_view &path,
+    size_t threads,
+    bool verify,
+    std::chrono::nanoseconds start_time_utc,
+    std::chrono::nanoseconds end_time_utc)
+    : path_(path), threads_(std::max<size_t>(threads, 1)), verify_(verify),
+      start_time_utc_(start_time_utc),
+      end_time_utc_(
+          end_time_utc.count() ? end_time_utc : std::chrono::nanoseconds::max()),
+      file_(path), format_(detect(file_.data())) {
+}
+
+void Verifier::Summary::operator+=(const Summary &rhs) {
+  for (size_t i = 0; i < SIZE; ++i) {
+    count[i] += rhs.count[i];
+    bytes[i] += rhs.bytes[i];
+  }
+}
+
+void Verifier::dispatch() {
+  auto start = std::chrono::steady_clock::now();
+  split();
+  std::atomic<size_t> next = {0};
+  std::vector<Summary> summaries(threads_);
+  std::vector<std::exception_ptr> errors(threads_);
+  std::vector<std::thread> workers;
+  workers.reserve(threads_);
+  for (size_t i = 0; i < threads_; ++i) {
+    workers.emplace_back([this, i, &next, &summaries, &errors]() {
+      try {
+        std::vector<char> buffer;  // note! re-used (base64)
+        for (size_t chunk; (chunk = next++) < chunks_.size();)
+          process(chunks_[chunk], summaries[i], buffer);
+      } catch (...) {
+        errors[i] = std::current_exception();
+      }
+    });
+  }
+  for (auto &worker : workers)
+    worker.join();
+  for (auto &error : errors)
+    if (error)
+      std::rethrow_exception(error);
+  Summary summary;
+  for (auto &item : summaries)
+    summary += item;
+  auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+  // table
+  uint64_t count = 0, bytes = 0;
+  fmt::print("{:<24} {:>14} {:>16} {:>10}\n", "type", "count", "bytes", "avg");
+  for (size_t i = 0; i < Summary::SIZE; ++i) {
+    if (summary.count[i] == 0)
+      continue;
+    fmt::print(
+        "{:<24} {:>14} {:>16} {:>10.1f}\n",
+        fbs::EnumNameMessage(static_cast<fbs::Message>(i)),
+        summary.count[i],
+        summary.bytes[i],
+        static_cast<double>(summary.bytes[i]) / summary.count[i]);
+    count += summary.count[i];
+    bytes += summary.bytes[i];
+  }
+  fmt::print(
+      "{:<24} {:>14} {:>16} {:>10.1f}\n",
+      "total",
+      count,
+      bytes,
+      count > 0 ? static_cast<double>(bytes) / count : 0.0);
+  log::info(
+      R"(path="{}", format={}, size={}, chunks={}, threads={}, verify={}, )"
+      R"(elapsed={:.3f}s, throughput={:.1f} MB/s)"_fmt,
+      path_,
+      format_name(),
+      file_.size(),
+      chunks_.size(),
+      threads_,
+      verify_,
+      elapsed.count(),
+      elapsed.count() > 0.0 ? 1.0e-6 * file_.size() / elapsed.count() : 0.0);
+}
+
+std::string_view Verifier::format_name() const {
+  switch (format_) {
+    case Format::BINARY:
+      return "binary"_sv;
+    case Format::BASE64:
+      return "base64"_sv;
+    case Format::COMPRESSED:
+      return "compressed"_sv;
+  }
+  return {};
+}
+
+Verifier::Format Verifier::detect(const std::string_view &data) {
+  if (Decompressor::is_compressed(data))
+    return Format::COMPRESSED;
+  // note! the size prefix of a binary frame always contains zero bytes
+  char prefix[Base64::decoded_length(BASE64_PREFIX_SIZE)];
+  if (data.size() >= BASE64_PREFIX_SIZE &&
+      Base64::decode(prefix, data.data(), BASE64_PREFIX_SIZE) != Base64::INVALID)
+    return Format::BASE64;
+  return Format::BINARY;
+}
+
+// returns the offset of the next frame (or block)
+size_t Verifier::next(size_t offset) const {
+  auto data = file_.data();
+  size_t result = 0;
+  switch (format_) {
+    case Format::BINARY:
+      if (offset + Frame::PREFIX_SIZE > data.size())
+        throw RuntimeErrorException(R"(Truncated frame: path="{}", offset={})"_fmt, path_, offset);
+      result = offset + Frame::length(data.data() + offset);
+      break;
+    case Format::BASE64: {
+      char prefix[Base64::decoded_length(BASE64_PREFIX_SIZE)];
+      if (offset + BASE64_PREFIX_SIZE > data.size() ||
+          Base64::decode(prefix, data.data() + offset, BASE64_PREFIX_SIZE) == Base64::INVALID)
+        throw RuntimeErrorException(R"(Invalid frame: path="{}", offset={})"_fmt, path_, offset);
+      result = offset + Base64::encoded_length(Frame::length(prefix));
+      break;
+    }
+    case Format::COMPRESSED: {
+      BlockHeader header;
+      if (offset + sizeof(header) > data.size())
+        throw RuntimeErrorException(R"(Truncated block: path="{}", offset={})"_fmt, path_, offset);
+      std::memcpy(&header, data.data() + offset, sizeof(header));
+      result = offset + sizeof(header) + header.compressed_size;
+      break;
+    }
+  }
+  if (result > data.size())
+    throw RuntimeErrorException(R"(Truncated: path="{}", offset={})"_fmt, path_, offset);
+  return result;
+}
+
+// returns the part of the file which must be processed (time window)
+std::pair<size_t, size_t> Verifier::range() const {
+  size_t begin = 0, end = file_.size();
+  if (format_ == Format::COMPRESSED)
+    begin = Decompressor(file_.data()).offset();  // skip the header
+  auto window = start_time_utc_.count() != 0 || end_time_utc_ != std::chrono::nanoseconds::max();
+  if (!window)
+    return {begin, end};
+  auto path = Index::path(path_);
+  if (!std::filesystem::exists(path)) {
+    log::warn(R"(No index (must scan everything): path="{}")"_fmt, path);
+    return {begin, end};
+  }
+  Index index(path);
+  if (auto entry = index.before(start_time_utc_); entry != nullptr)
+    begin = entry->offset;
+  if (auto entry = index.after(end_time_utc_); entry != nullptr)
+    end = entry->offset;
+  log::info(R"(path="{}", begin={}, end={}, checkpoints={})"_fmt, path, begin, end, index.size());
+  return {begin, std::max(begin, end)};
+}
+
+// note! chunks of (roughly) equal size so the work is evenly distributed
+void Verifier::split() {
+  auto [offset, end] = range();
+  auto target = std::max<size_t>((end - offset) / threads_, 1);
+  auto begin = offset;
+  while (offset < end) {
+    offset = next(offset);
+    if ((offset - begin) >= target) {
+      chunks_.push_back({.begin = begin, .end = offset});
+      begin = offset;
+    }
+  }
+  if (begin < offset)
+    chunks_.push_back({.begin = begin, .end = offset});
+}
+
+void Verifier::process(const Chunk &chunk, Summary &summary, std::vector<char> &buffer) const {
+  auto data = file_.data();
+  switch (format_) {
+    case Format::BINARY:
+      process_frames(data.substr(chunk.begin, chunk.end - chunk.begin), chunk.begin, summary);
+      break;
+    case Format::BASE64:
+      for (auto offset = chunk.begin; offset < chunk.end;) {
+        auto end = next(offset);
+        auto length = end - offset;
+        if (buffer.size() < Base64::decoded_length(length))
+          buffer.resize(Base64::decoded_length(length));
+        auto result = Base64::decode(buffer.data(), data.data() + offset, length);
+        if (result == Base64::INVALID)
+          throw RuntimeErrorException(R"(Invalid frame: path="{}", offset={})"_fmt, path_, offset);
+        process_frame(buffer.data(), result, offset, summary);
+        offset = end;
+      }
+      break;
+    case Format::COMPRESSED: {
+      // note! each block can be decompressed independently
+      Decompressor decompressor(data);
+      decompressor.seek(chunk.begin);
+      std::string_view frames;
+      while (decompressor.offset() < chunk.end) {
+        auto offset = decompressor.offset();
+        decompressor.next(frames);
+        process_frames(frames, offset, summary);
+      }
+      break;
+    }
+  }
+}
+
+// note! offset is the position in the file (of the chunk, or of the block if compressed)
+void Verifier::process_frames(
+    const std::string_view &frames, size_t offset, Summary &summary) const {
+  size_t position = 0;
+  while (position < frames.size()) {
+    auto data = frames.data() + position;
+    if (position + Frame::PREFIX_SIZE > frames.size() ||
+        position + Frame::length(data) > frames.size())
+      throw RuntimeErrorException(
+          R"(Truncated frame: path="{}", offset={}, position={})"_fmt, path_, offset, position);
+    auto length = Frame::length(data);
+    process_frame(
+        data, length, format_ == Format::COMPRESSED ? offset : offset + position, summary);
+    position += length;
+  }
+}
+
+void Verifier::process_frame(
+    char const *data, size_t length, size_t offset, Summary &summary) const {
+  if (verify_) {
+    flatbuffers::Verifier verifier(reinterpret_cast<uint8_t const *>(data), length);
+    if (!fbs::VerifySizePrefixedEventBuffer(verifier))
+      throw RuntimeErrorException(R"(Invalid frame: path="{}", offset={})"_fmt, path_, offset);
+  }
+  auto receive_time_utc = Frame::receive_time_utc(data);
+  if (receive_time_utc < start_time_utc_ || receive_time_utc >= end_time_utc_)
+    return;
+  auto index = static_cast<size_t>(Frame::type(data));
+  if (index >= Summary::SIZE)
+    throw RuntimeErrorException(R"(Unknown message: path="{}", offset={})"_fmt, path_, offset);
+  ++summary.count[index];
+  summary.bytes[index] += length;
+}
+
+}  // namespace import
+}  // namespace samples
+}  // namespace roq
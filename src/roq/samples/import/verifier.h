@@ -0,0 +1,100 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "roq/fbs/api.h"
+
+#include "roq/samples/import/mapped_file.h"
+
+namespace roq {
+namespace samples {
+namespace import {
+
+// reads back what Processor writes (binary, base64 or compressed)
+//
+// frames are never copied (except for base64 and compressed streams which
+// must be decoded, one frame or one block at a time)
+//
+// the stream is split into chunks at frame (or block) boundaries and the
+// chunks are processed in parallel, optionally running the flatbuffers
+// verifier on each frame
+//
+// a time window can be given, in which case the time index (sidecar file)
+// is used to skip directly to the first relevant frame (or block)
+//
+// note!
+//   finding the frame boundaries is a sequential walk of the size prefixes,
+//   all other work is done by the worker threads
+
+class Verifier final {
+ public:
+  Verifier(
+      const std::string_view &path,
+      size_t threads,
+      bool verify,
+      std::chrono::nanoseconds start_time_utc = {},
+      std::chrono::nanoseconds end_time_utc = {});  // note! zero means no limit
+
+  Verifier(Verifier &&) = delete;
+  Verifier(const Verifier &) = delete;
+
+  void dispatch();
+
+ protected:
+  enum class Format {
+    BINARY,
+    BASE64,
+    COMPRESSED,
+  };
+
+  struct Chunk final {
+    size_t begin;
+    size_t end;
+  };
+
+  struct Summary final {
+    static constexpr size_t SIZE = static_cast<size_t>(fbs::Message::MAX) + 1;
+    std::array<uint64_t, SIZE> count = {};
+    std::array<uint64_t, SIZE> bytes = {};
+
+    void operator+=(const Summary &);
+  };
+
+  static Format detect(const std::string_view &data);
+
+  std::string_view format_name() const;
+
+  size_t next(size_t offset) const;
+
+  std::pair<size_t, size_t> range() const;
+
+  void split();
+
+  void process(const Chunk &, Summary &, std::vector<char> &buffer) const;
+
+  void process_frames(const std::string_view &frames, size_t offset, Summary &) const;
+
+  void process_frame(char const *data, size_t length, size_t offset, Summary &) const;
+
+ private:
+  const std::string_view path_;
+  const size_t threads_;
+  const bool verify_;
+  const std::chrono::nanoseconds start_time_utc_;
+  const std::chrono::nanoseconds end_time_utc_;
+  MappedFile file_;
+  const Format format_;
+  size_t header_size_ = {};  // compressed
+  std::vector<Chunk> chunks_;
+};
+
+}  // namespace import
+}  // namespace samples
+}  // namespace roq
@@ -0,0 +1,233 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#include "roq/samples/import/writer.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "roq/exceptions.h"
+#include "roq/logging.h"
+
+using namespace roq::literals;
+
+namespace roq {
+namespace samples {
+namespace import {
+
+Writer::Writer(
+    const std::string_view &path, size_t block_size, bool direct, uint64_t preallocate)
+    : Writer(path, block_size, direct, preallocate, 1u, nullptr) {
+}
+
+Writer::Writer(
+    const std::string_view &path,
+    size_t block_size,
+    bool direct,
+    uint64_t preallocate,
+    size_t blocks,
+    Stage *producer)
+    : path_(path), block_size_(block_size), direct_(direct),
+      start_(std::chrono::steady_clock::now()), producer_(producer), stage_("write"_sv) {
+  if (block_size_ == 0 || (block_size_ % ALIGNMENT) != 0)
+    throw RuntimeErrorException(
+        "Block size must be a (non-zero) multiple of {}, got {}"_fmt, ALIGNMENT, block_size_);
+  auto flags = O_WRONLY | O_CREAT | O_TRUNC;
+#if defined(__linux__)
+  if (direct_)
+    flags |= O_DIRECT;
+#endif
+  fd_ = ::open(path_.c_str(), flags, 0644);
+  if (fd_ < 0)
+    throw RuntimeErrorException(
+        R"(Unable to open file for writing: path="{}", error="{}")"_fmt,
+        path_,
+        std::strerror(errno));
+#if defined(__APPLE__)
+  if (direct_)
+    ::fcntl(fd_, F_NOCACHE, 1);  // closest equivalent of O_DIRECT
+#endif
+  if (preallocate > 0) {
+#if defined(__linux__)
+    // note! keep size so we don't have to truncate when closing
+    if (::fallocate(fd_, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(preallocate)) < 0)
+      log::warn(
+          R"(Unable to pre-allocate: path="{}", error="{}")"_fmt, path_, std::strerror(errno));
+#else
+    log::warn(R"(Pre-allocation not supported: path="{}")"_fmt, path_);
+#endif
+  }
+  if (blocks <= 1u) {
+    if (::posix_memalign(reinterpret_cast<void **>(&buffer_), ALIGNMENT, block_size_) != 0) {
+      ::close(fd_);
+      throw std::bad_alloc();
+    }
+    return;
+  }
+  queue_ = std::make_unique<SPSCQueue<Block>>(blocks);
+  for (auto &block : queue_->slots()) {
+    if (::posix_memalign(reinterpret_cast<void **>(&block.data), ALIGNMENT, block_size_) != 0) {
+      for (auto &item : queue_->slots())
+        std::free(item.data);
+      ::close(fd_);
+      throw std::bad_alloc();
+    }
+  }
+  block_ = queue_->claim();
+  buffer_ = block_->data;
+  thread_ = std::thread([this]() { run(); });
+}
+
+Writer::~Writer() {
+  try {
+    // best effort
+    close();
+  } catch (...) {
+  }
+  // note! close may have failed before the write stage was stopped
+  if (thread_.joinable()) {
+    block_->length = 0;
+    queue_->push();
+    thread_.join();
+  }
+  if (fd_ >= 0)
+    ::close(fd_);
+  if (queue_) {
+    for (auto &block : queue_->slots())
+      std::free(block.data);
+  } else {
+    std::free(buffer_);
+  }
+}
+
+void Writer::write(void const *data, size_t length) {
+  auto source = static_cast<char const *>(data);
+  while (length > 0) {
+    auto size = std::min(length, block_size_ - used_);
+    std::memcpy(buffer_ + used_, source, size);
+    used_ += size;
+    source += size;
+    length -= size;
+    if (used_ == block_size_)
+      flush(block_size_);
+  }
+}
+
+void Writer::close() {
+  if (fd_ < 0)
+    return;
+  auto size = offset_ + used_;
+  if (used_ > 0) {
+    if (direct_) {
+      // note! O_DIRECT requires aligned length, so we pad and truncate
+      auto length = (used_ + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+      std::memset(buffer_ + used_, 0, length - used_);
+      flush(length);
+    } else {
+      flush(used_);
+    }
+  }
+  if (queue_) {
+    // note! signal end of stream and wait for all blocks to be written
+    block_->length = 0;
+    queue_->push();
+    thread_.join();
+    stage_.log();
+    if (error_) {
+      ::close(fd_);
+      fd_ = -1;
+      std::rethrow_exception(error_);
+    }
+  }
+  if (offset_ > size && ::ftruncate(fd_, static_cast<off_t>(size)) < 0)
+    throw RuntimeErrorException(
+        R"(Unable to truncate: path="{}", error="{}")"_fmt, path_, std::strerror(errno));
+  ::close(fd_);
+  fd_ = -1;
+  auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_);
+  auto flush_time = std::chrono::duration<double>(stats_.flush_time);
+  log::info(
+      R"(path="{}", bytes={}, blocks={}, throughput={:.1f} MB/s, )"
+      "flush_throughput={:.1f} MB/s, flush_latency={{avg={}, max={}}}"_fmt,
+      path_,
+      size,
+      stats_.flushes,
+      elapsed.count() > 0.0 ? static_cast<double>(size) / elapsed.count() * 1.0e-6 : 0.0,
+      flush_time.count() > 0.0 ? static_cast<double>(stats_.bytes) / flush_time.count() * 1.0e-6
+                               : 0.0,
+      stats_.flushes > 0 ? stats_.flush_time / static_cast<int64_t>(stats_.flushes)
+                         : std::chrono::nanoseconds{},
+      stats_.max_flush_time);
+}
+
+void Writer::flush(size_t length) {
+  assert(length <= block_size_);
+  if (!queue_) {
+    write_block(buffer_, length, offset_);
+  } else {
+    if (ROQ_UNLIKELY(failed_.load(std::memory_order_acquire)))
+      std::rethrow_exception(error_);
+    block_->length = length;
+    block_->offset = offset_;
+    queue_->push();
+    // note! the producer is charged for waiting (backpressure)
+    auto &stage = producer_ != nullptr ? *producer_ : stage_;
+    block_ = stage.wait_for_output([this]() { return queue_->claim(); });
+    buffer_ = block_->data;
+  }
+  offset_ += length;
+  used_ = 0;
+}
+
+// note! called from the write stage when pipelined
+void Writer::write_block(char const *data, size_t length, uint64_t offset) {
+  auto start = std::chrono::steady_clock::now();
+  size_t done = 0;
+  while (done < length) {
+    auto result = ::pwrite(fd_, data + done, length - done, offset + done);
+    if (result < 0) {
+      if (errno == EINTR)
+        continue;
+      throw RuntimeErrorException(
+          R"(Unable to write: path="{}", error="{}")"_fmt, path_, std::strerror(errno));
+    }
+    done += static_cast<size_t>(result);
+  }
+  auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start);
+  ++stats_.flushes;
+  stats_.bytes += length;
+  stats_.flush_time += latency;
+  stats_.max_flush_time = std::max(stats_.max_flush_time, latency);
+}
+
+void Writer::run() {
+  for (;;) {
+    auto block = stage_.wait_for_input([this]() { return queue_->front(); });
+    if (block->length == 0) {
+      queue_->pop();
+      break;
+    }
+    // note! after a failure we keep draining so the producer never blocks
+    if (!error_) {
+      try {
+        write_block(block->data, block->length, block->offset);
+        ++stage_;
+      } catch (...) {
+        error_ = std::current_exception();
+        failed_.store(true, std::memory_order_release);
+      }
+    }
+    queue_->pop();
+  }
+}
+
+}  // namespace import
+}  // namespace samples
+}  // namespace roq
@@ -0,0 +1,105 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "roq/samples/import/spsc_queue.h"
+#include "roq/samples/import/stage.h"
+
+namespace roq {
+namespace samples {
+namespace import {
+
+// buffered output stage
+//
+// frames are packed into large aligned blocks which are written
+// using a single pwrite each time a block is full
+//
+// options
+//   direct      bypass the page cache (O_DIRECT)
+//   preallocate reserve disk space up front (fallocate)
+//
+// pipeline
+//   with more than one block, full blocks are handed to a background thread
+//   (the write stage) and the caller continues filling the next free block
+//   the caller only waits when all blocks are in flight (backpressure) and
+//   that time is charged to the producer stage (if any)
+//
+// note!
+//   frames may span blocks -- the output is just a byte stream
+
+class Writer final {
+ public:
+  static constexpr size_t ALIGNMENT = 4096u;  // O_DIRECT requirement
+
+  Writer(const std::string_view &path, size_t block_size, bool direct, uint64_t preallocate);
+  Writer(
+      const std::string_view &path,
+      size_t block_size,
+      bool direct,
+      uint64_t preallocate,
+      size_t blocks,
+      Stage *producer);
+
+  Writer(Writer &&) = delete;
+  Writer(const Writer &) = delete;
+
+  ~Writer();
+
+  void write(void const *data, size_t length);
+
+  // number of bytes written so far (i.e. the file offset of the next byte)
+  uint64_t position() const { return offset_ + used_; }
+
+  // flush all pending data and close the file (also logs statistics)
+  void close();
+
+ protected:
+  void flush(size_t length);
+
+  void write_block(char const *data, size_t length, uint64_t offset);
+
+  void run();
+
+ private:
+  struct Block final {
+    char *data = nullptr;
+    size_t length = {};  // note! 0 means end of stream
+    uint64_t offset = {};
+  };
+
+  const std::string path_;
+  const size_t block_size_;
+  const bool direct_;
+  int fd_ = -1;
+  char *buffer_ = nullptr;
+  size_t used_ = {};
+  uint64_t offset_ = {};  // file offset of the current block
+  std::chrono::steady_clock::time_point start_;
+  // pipeline
+  std::unique_ptr<SPSCQueue<Block>> queue_;  // note! only used with more than one block
+  Block *block_ = nullptr;                   // note! the block currently being filled
+  Stage *const producer_;
+  Stage stage_;
+  std::thread thread_;
+  std::exception_ptr error_;
+  std::atomic<bool> failed_ = {false};
+  struct {
+    uint64_t bytes = {};
+    uint64_t flushes = {};
+    std::chrono::nanoseconds flush_time = {};
+    std::chrono::nanoseconds max_flush_time = {};
+  } stats_;
+};
+
+}  // namespace import
+}  // namespace samples
+}  // namespace roq
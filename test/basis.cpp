@@ -0,0 +1,213 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <deque>
+#include <numeric>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "roq/api.h"
+
+#include "roq/samples/example-2/basis.h"
+
+using namespace std::chrono_literals;
+using namespace roq;
+using namespace roq::samples::example_2;
+
+namespace {
+static const double ALPHA = 0.5;
+static const auto MAX_SKEW = 100ms;
+
+// (index, value) of each sample
+struct Collector final {
+  void operator()(size_t index, const Basis::Result &result) {
+    samples.emplace_back(index, result.value);
+  }
+  std::vector<std::pair<size_t, double>> samples;
+};
+
+// note! population statistics
+struct Reference final {
+  explicit Reference(size_t window) : window(window) {}
+  void operator()(double value) {
+    samples.push_back(value);
+    if (samples.size() > window)
+      samples.pop_front();
+    mean = std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+    auto variance = 0.0;
+    for (auto sample : samples)
+      variance += (sample - mean) * (sample - mean);
+    stddev = std::sqrt(variance / samples.size());
+    zscore = stddev > 0.0 ? (value - mean) / stddev : NaN;
+  }
+  const size_t window;
+  std::deque<double> samples;
+  double mean = NaN;
+  double stddev = NaN;
+  double zscore = NaN;
+};
+}  // namespace
+
+TEST(basis, simple) {
+  Basis basis(2, 4, ALPHA, MAX_SKEW);
+  ASSERT_EQ(basis.size(), 2u);
+  Collector collector;
+  // note! no sample until both sides are available
+  basis.update_futures(0, 101.0, 1s, collector);
+  EXPECT_TRUE(collector.samples.empty());
+  EXPECT_TRUE(std::isnan(basis[0].value));
+  // note! a cash update refreshes all legs with a futures price
+  basis.update_cash(100.0, 1s, collector);
+  EXPECT_EQ(collector.samples, (std::vector<std::pair<size_t, double>>{{0, 1.0}}));
+  basis.update_futures(1, 99.0, 1s, collector);
+  basis.update_futures(0, 103.0, 1s, collector);
+  EXPECT_EQ(
+      collector.samples,
+      (std::vector<std::pair<size_t, double>>{{0, 1.0}, {1, -1.0}, {0, 3.0}}));
+  EXPECT_DOUBLE_EQ(basis[0].value, 3.0);
+  EXPECT_DOUBLE_EQ(basis[0].ema, ALPHA * 3.0 + (1.0 - ALPHA) * 1.0);
+  EXPECT_DOUBLE_EQ(basis[0].mean, 2.0);
+  EXPECT_DOUBLE_EQ(basis[0].stddev, 1.0);
+  EXPECT_DOUBLE_EQ(basis[0].zscore, 1.0);
+  // note! the first sample has no dispersion
+  EXPECT_DOUBLE_EQ(basis[1].stddev, 0.0);
+  EXPECT_TRUE(std::isnan(basis[1].zscore));
+  // note! an unchanged price is not a new sample
+  collector.samples.clear();
+  basis.update_futures(0, 103.0, 2s, collector);
+  basis.update_cash(100.0, 2s, collector);
+  EXPECT_TRUE(collector.samples.empty());
+}
+
+// note! an update older than the other side by more than max_skew is not used
+TEST(basis, skew) {
+  Basis basis(1, 4, ALPHA, MAX_SKEW);
+  Collector collector;
+  basis.update_cash(100.0, 10s, collector);
+  basis.update_futures(0, 101.0, 10s - MAX_SKEW - 1ns, collector);  // note! delayed
+  EXPECT_TRUE(collector.samples.empty());
+  EXPECT_TRUE(std::isnan(basis[0].value));
+  basis.update_futures(0, 102.0, 10s - MAX_SKEW, collector);  // note! at the limit
+  EXPECT_EQ(collector.samples, (std::vector<std::pair<size_t, double>>{{0, 2.0}}));
+  // note! a delayed cash update is not used either
+  basis.update_futures(0, 103.0, 20s, collector);
+  basis.update_cash(99.0, 19s, collector);
+  EXPECT_EQ(collector.samples.size(), 2u);
+  EXPECT_DOUBLE_EQ(basis[0].value, 3.0);
+  // note! a quiet side is not stale, the price is still valid
+  basis.update_cash(98.0, 20s, collector);
+  EXPECT_EQ(collector.samples.size(), 3u);
+  EXPECT_DOUBLE_EQ(basis[0].value, 5.0);
+}
+
+TEST(basis, window) {
+  static const size_t WINDOW = 3;
+  Basis basis(1, WINDOW, ALPHA, MAX_SKEW);
+  Collector collector;
+  Reference reference(WINDOW);
+  basis.update_cash(0.0, 1s, collector);
+  // note! wraps around the window several times
+  for (auto value : {1.0, 2.0, 4.0, 8.0, 7.0, 5.0, 1.0, 2.0}) {
+    basis.update_futures(0, value, 1s, collector);
+    reference(value);
+    EXPECT_DOUBLE_EQ(basis[0].mean, reference.mean) << "value=" << value;
+    EXPECT_NEAR(basis[0].stddev, reference.stddev, 1.0e-12) << "value=" << value;
+  }
+  // note! (5 + 1 + 2) / 3
+  EXPECT_DOUBLE_EQ(basis[0].mean, 8.0 / 3.0);
+}
+
+// running sums must match the naive statistics (also for a large offset)
+TEST(basis, random) {
+  static const size_t WINDOW = 50;
+  std::mt19937_64 generator(1);
+  std::normal_distribution<double> distribution(0.0, 1.0);
+  Basis basis(1, WINDOW, ALPHA, MAX_SKEW);
+  Collector collector;
+  Reference reference(WINDOW);
+  auto ema = NaN;
+  basis.update_cash(50000.0, 1s, collector);
+  for (size_t i = 0; i < 10000; ++i) {
+    auto value = 10.0 + distribution(generator);
+    basis.update_futures(0, 50000.0 + value, 1s, collector);
+    // note! the basis is only as precise as the prices
+    value = (50000.0 + value) - 50000.0;
+    reference(value);
+    ema = std::isnan(ema) ? value : ALPHA * value + (1.0 - ALPHA) * ema;
+    ASSERT_NEAR(basis[0].value, value, 1.0e-12) << "i=" << i;
+    ASSERT_NEAR(basis[0].ema, ema, 1.0e-9) << "i=" << i;
+    ASSERT_NEAR(basis[0].mean, reference.mean, 1.0e-9) << "i=" << i;
+    ASSERT_NEAR(basis[0].stddev, reference.stddev, 1.0e-9) << "i=" << i;
+    if (i > 0) {
+      ASSERT_NEAR(basis[0].zscore, reference.zscore, 1.0e-6) << "i=" << i;
+    }
+  }
+  EXPECT_EQ(collector.samples.size(), 10000u);
+}
+
+// note! NaN means unavailable
+TEST(basis, nan) {
+  Basis basis(2, 4, ALPHA, MAX_SKEW);
+  Collector collector;
+  basis.update_futures(0, 101.0, 1s, collector);
+  basis.update_futures(1, 102.0, 1s, collector);
+  basis.update_cash(100.0, 1s, collector);
+  ASSERT_EQ(collector.samples.size(), 2u);
+  // one leg
+  collector.samples.clear();
+  basis.update_futures(0, NaN, 2s, collector);
+  basis.update_cash(99.0, 2s, collector);
+  EXPECT_EQ(collector.samples, (std::vector<std::pair<size_t, double>>{{1, 3.0}}));
+  EXPECT_DOUBLE_EQ(basis[0].value, 1.0);  // note! the last sample
+  // cash
+  collector.samples.clear();
+  basis.update_cash(NaN, 3s, collector);
+  basis.update_futures(1, 103.0, 3s, collector);
+  EXPECT_TRUE(collector.samples.empty());
+  // recovery
+  basis.update_futures(0, 104.0, 4s, collector);
+  basis.update_cash(100.0, 4s, collector);
+  EXPECT_EQ(
+      collector.samples, (std::vector<std::pair<size_t, double>>{{0, 4.0}, {1, 3.0}}));
+  // note! samples from before the gap are still used
+  EXPECT_DOUBLE_EQ(basis[0].mean, 2.5);
+}
+
+TEST(basis, reset) {
+  Basis basis(2, 4, ALPHA, MAX_SKEW);
+  Collector collector;
+  basis.update_cash(100.0, 1s, collector);
+  basis.update_futures(0, 101.0, 1s, collector);
+  basis.update_futures(1, 102.0, 1s, collector);
+  basis.update_futures(0, 105.0, 1s, collector);
+  // futures
+  basis.reset_futures(0);
+  EXPECT_TRUE(std::isnan(basis[0].value));
+  EXPECT_TRUE(std::isnan(basis[0].mean));
+  EXPECT_DOUBLE_EQ(basis[1].value, 2.0);  // note! other legs are not affected
+  collector.samples.clear();
+  basis.update_cash(100.0, 2s, collector);  // note! unchanged
+  EXPECT_TRUE(collector.samples.empty());
+  basis.update_futures(0, 103.0, 2s, collector);
+  EXPECT_EQ(collector.samples, (std::vector<std::pair<size_t, double>>{{0, 3.0}}));
+  // note! samples from before the reset are discarded
+  EXPECT_DOUBLE_EQ(basis[0].mean, 3.0);
+  EXPECT_DOUBLE_EQ(basis[0].ema, 3.0);
+  EXPECT_DOUBLE_EQ(basis[0].stddev, 0.0);
+  // cash
+  basis.reset_cash();
+  for (size_t i = 0; i < basis.size(); ++i)
+    EXPECT_TRUE(std::isnan(basis[i].value)) << "index=" << i;
+  collector.samples.clear();
+  basis.update_futures(0, 103.0, 3s, collector);  // note! unchanged, no cash
+  EXPECT_TRUE(collector.samples.empty());
+  basis.update_cash(101.0, 3s, collector);
+  EXPECT_EQ(
+      collector.samples, (std::vector<std::pair<size_t, double>>{{0, 2.0}, {1, 1.0}}));
+  EXPECT_DOUBLE_EQ(basis[1].mean, 1.0);
+}
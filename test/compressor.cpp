@@ -0,0 +1,141 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "roq/samples/import/codec.h"
+#include "roq/samples/import/compressor.h"
+#include "roq/samples/import/decompressor.h"
+#include "roq/samples/import/mapped_file.h"
+#include "roq/samples/import/writer.h"
+
+using namespace roq::samples::import;
+
+namespace {
+static const size_t FRAMES = 20000;
+static const size_t BLOCK_SIZE = 16384;
+static const size_t DICTIONARY_SIZE = 4096;
+
+// note! size-prefixed and repetitive (like encoded messages)
+std::vector<std::string> create_frames() {
+  std::vector<std::string> result;
+  for (size_t i = 0; i < FRAMES; ++i) {
+    auto payload = "exchange=CME,symbol=GEZ" + std::to_string(i % 7) +
+                   ",price=" + std::to_string(99785 + (i * 31) % 97) +
+                   ",quantity=" + std::to_string(1 + i % 13) + ",seqno=" + std::to_string(i);
+    auto length = static_cast<uint32_t>(payload.size());
+    std::string frame(sizeof(length), '\0');
+    std::memcpy(frame.data(), &length, sizeof(length));
+    result.emplace_back(frame + payload);
+  }
+  return result;
+}
+
+// compresses the frames and returns the (offset, first frame) of each block
+std::vector<std::pair<size_t, size_t>> compress(
+    const std::string &path,
+    const std::vector<std::string> &frames,
+    Codec codec,
+    size_t dictionary_samples) {
+  std::vector<std::pair<size_t, size_t>> result;
+  Writer writer(path, 4096u, false, 0u);
+  Compressor compressor(writer, codec, 1, BLOCK_SIZE, dictionary_samples, DICTIONARY_SIZE);
+  for (size_t i = 0; i < frames.size(); ++i) {
+    auto &frame = frames[i];
+    if (compressor.write(frame.data(), frame.size()))
+      result.emplace_back(writer.position(), i);
+  }
+  compressor.flush();
+  writer.close();
+  return result;
+}
+
+void round_trip(Codec codec, size_t dictionary_samples) {
+  auto path = ::testing::TempDir() + "roq-samples-test-compressor";
+  auto frames = create_frames();
+  std::string expected;
+  for (auto &frame : frames)
+    expected += frame;
+  auto blocks = compress(path, frames, codec, dictionary_samples);
+  {
+    MappedFile file(path);
+    auto data = file.data();
+    ASSERT_TRUE(Decompressor::is_compressed(data));
+    EXPECT_LT(data.size(), expected.size() / 2);
+    uint32_t dictionary_size;
+    auto position = CODEC_HEADER_SIZE - sizeof(dictionary_size);
+    std::memcpy(&dictionary_size, data.data() + position, sizeof(dictionary_size));
+    if (dictionary_samples > 0)
+      EXPECT_GT(dictionary_size, 0u);
+    else
+      EXPECT_EQ(dictionary_size, 0u);
+    // all blocks
+    Decompressor decompressor(data);
+    std::string result;
+    std::string_view block;
+    size_t count = 0;
+    while (decompressor.next(block)) {
+      EXPECT_LE(block.size(), BLOCK_SIZE);
+      result += block;
+      ++count;
+    }
+    EXPECT_EQ(result, expected);
+    // note! frames used for training are never checkpoints
+    EXPECT_GE(count, blocks.size());
+    EXPECT_GT(blocks.size(), 10u);
+    // seek
+    for (auto [offset, index] : blocks) {
+      Decompressor decompressor(data);
+      decompressor.seek(offset);
+      ASSERT_TRUE(decompressor.next(block));
+      auto &frame = frames[index];
+      ASSERT_GE(block.size(), frame.size());
+      EXPECT_EQ(block.substr(0, frame.size()), frame);
+    }
+  }
+  std::remove(path.c_str());
+}
+}  // namespace
+
+TEST(compressor, lz4) {
+  round_trip(Codec::LZ4, 0u);
+}
+
+TEST(compressor, lz4_dictionary) {
+  round_trip(Codec::LZ4, 1000u);
+}
+
+TEST(compressor, zstd) {
+  round_trip(Codec::ZSTD, 0u);
+}
+
+TEST(compressor, zstd_dictionary) {
+  round_trip(Codec::ZSTD, 1000u);
+}
+
+TEST(compressor, truncated) {
+  auto path = ::testing::TempDir() + "roq-samples-test-compressor-truncated";
+  auto frames = create_frames();
+  compress(path, frames, Codec::ZSTD, 1000u);
+  {
+    MappedFile file(path);
+    auto data = file.data();
+    Decompressor decompressor(data.substr(0, data.size() - 1));
+    std::string_view block;
+    EXPECT_THROW(
+        {
+          while (decompressor.next(block)) {
+          }
+        },
+        std::exception);
+  }
+  std::remove(path.c_str());
+}
@@ -0,0 +1,127 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+
+#include "roq/api.h"
+
+#include "roq/samples/example-2/conflation.h"
+
+using namespace std::chrono_literals;
+using namespace roq;
+using namespace roq::samples::example_2;
+
+namespace {
+static const auto THRESHOLD = 10ms;
+
+MessageInfo create_message_info(std::chrono::nanoseconds receive_time, bool is_last) {
+  return MessageInfo{
+      .source = {},
+      .source_name = {},
+      .source_session_id = {},
+      .source_seqno = {},
+      .receive_time_utc = {},
+      .receive_time = receive_time,
+      .source_send_time = {},
+      .source_receive_time = {},
+      .origin_create_time = {},
+      .origin_create_time_utc = {},
+      .is_last = is_last,
+      .opaque = {},
+  };
+}
+
+// note! a batch of updates received at receive_time and processed at now
+bool batch(
+    Conflation &conflation,
+    std::chrono::nanoseconds receive_time,
+    std::chrono::nanoseconds now,
+    size_t updates = 3) {
+  for (size_t i = 1; i < updates; ++i)
+    EXPECT_FALSE(conflation(create_message_info(receive_time, false), now));
+  return conflation(create_message_info(receive_time, true), now);
+}
+}  // namespace
+
+TEST(conflation, disabled) {
+  Conflation conflation(0ms);
+  // note! also when lagging
+  for (auto receive_time : {1s, 2s, 3s})
+    EXPECT_TRUE(batch(conflation, receive_time, 1h));
+  EXPECT_FALSE(conflation.is_lagging());
+  EXPECT_FALSE(conflation.is_pending());
+  EXPECT_FALSE(conflation.drain(2h));
+  auto &counters = conflation.counters();
+  EXPECT_EQ(counters.updates, 9u);
+  EXPECT_EQ(counters.batches, 3u);
+  EXPECT_EQ(counters.flushes, 3u);
+  EXPECT_EQ(counters.conflated, 0u);
+}
+
+TEST(conflation, not_lagging) {
+  Conflation conflation(THRESHOLD);
+  // note! every batch, also when close together
+  for (auto receive_time : {1000us, 1001us, 1002us, 1003us})
+    EXPECT_TRUE(batch(conflation, receive_time, receive_time + THRESHOLD));  // note! at the limit
+  EXPECT_FALSE(conflation.is_lagging());
+  EXPECT_EQ(conflation.counters().flushes, 4u);
+  EXPECT_EQ(conflation.counters().conflated, 0u);
+}
+
+TEST(conflation, enter_and_leave) {
+  Conflation conflation(THRESHOLD);
+  EXPECT_TRUE(batch(conflation, 1s, 1s + 1ms));
+  // note! entering conflation, the first batch updates the model
+  EXPECT_TRUE(batch(conflation, 2s, 2s + 50ms));
+  EXPECT_TRUE(conflation.is_lagging());
+  EXPECT_FALSE(conflation.is_pending());
+  // note! conflated until the threshold has elapsed since the last model update
+  EXPECT_FALSE(batch(conflation, 2s + 1ms, 2s + 51ms));
+  EXPECT_TRUE(conflation.is_pending());
+  EXPECT_FALSE(batch(conflation, 2s + 9ms, 2s + 52ms));
+  EXPECT_TRUE(batch(conflation, 2s + 10ms, 2s + 53ms));
+  EXPECT_FALSE(conflation.is_pending());
+  EXPECT_FALSE(batch(conflation, 2s + 11ms, 2s + 54ms));
+  EXPECT_TRUE(conflation.is_pending());
+  // note! leaving conflation always drains the pending batch
+  EXPECT_TRUE(batch(conflation, 2s + 12ms, 2s + 13ms));
+  EXPECT_FALSE(conflation.is_lagging());
+  EXPECT_FALSE(conflation.is_pending());
+  EXPECT_TRUE(batch(conflation, 2s + 14ms, 2s + 15ms));
+  auto &counters = conflation.counters();
+  EXPECT_EQ(counters.batches, 8u);
+  EXPECT_EQ(counters.flushes, 5u);
+  EXPECT_EQ(counters.conflated, 3u);
+  EXPECT_EQ(counters.updates, 3 * counters.batches);
+}
+
+// note! the batch ends (is_last) are what is conflated, not the updates
+TEST(conflation, updates) {
+  Conflation conflation(THRESHOLD);
+  EXPECT_TRUE(batch(conflation, 1s, 1s + 50ms, 1));
+  EXPECT_FALSE(batch(conflation, 1s + 1ms, 1s + 51ms, 100));
+  auto &counters = conflation.counters();
+  EXPECT_EQ(counters.updates, 101u);
+  EXPECT_EQ(counters.batches, 2u);
+  EXPECT_EQ(counters.conflated, 1u);
+}
+
+TEST(conflation, drain) {
+  Conflation conflation(THRESHOLD);
+  // note! nothing pending
+  EXPECT_FALSE(conflation.drain(1s));
+  EXPECT_TRUE(batch(conflation, 1s, 1s + 50ms));
+  EXPECT_FALSE(batch(conflation, 1s + 1ms, 1s + 51ms));
+  ASSERT_TRUE(conflation.is_pending());
+  // note! not before the threshold has elapsed since the last model update
+  EXPECT_FALSE(conflation.drain(1s + 9ms));
+  EXPECT_TRUE(conflation.drain(1s + 10ms));
+  EXPECT_FALSE(conflation.is_pending());
+  EXPECT_FALSE(conflation.drain(1s + 100ms));
+  EXPECT_EQ(conflation.counters().flushes, 2u);
+  // note! the drain is a model update, i.e. the next batch is conflated
+  EXPECT_FALSE(batch(conflation, 1s + 15ms, 1s + 60ms));
+  EXPECT_TRUE(conflation.is_pending());
+  EXPECT_TRUE(batch(conflation, 1s + 20ms, 1s + 70ms));
+}
@@ -0,0 +1,251 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#include <gtest/gtest.h>
+
+#include <fmt/format.h>
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "roq/api.h"
+
+#include "roq/samples/import/csv_reader.h"
+#include "roq/samples/import/handler.h"
+
+#include "frames.h"
+
+using namespace roq;
+using namespace roq::samples::import;
+
+namespace {
+char side(Side side) {
+  return side == Side::BUY ? 'B' : side == Side::SELL ? 'S' : '?';
+}
+
+char action(OrderUpdateAction action) {
+  switch (action) {
+    case OrderUpdateAction::NEW:
+      return 'N';
+    case OrderUpdateAction::MODIFY:
+      return 'M';
+    case OrderUpdateAction::REMOVE:
+      return 'R';
+    default:
+      return '?';
+  }
+}
+
+// one line per event: type|exchange|symbol|timestamp|...
+struct Collector final : public Handler {
+  void operator()(const GatewaySettings &, std::chrono::nanoseconds) override {}
+  void operator()(
+      const ReferenceData &reference_data, std::chrono::nanoseconds timestamp_utc) override {
+    result.push_back(fmt::format(
+        "R|{}|{}|{}|{}|{}|{}",
+        reference_data.exchange,
+        reference_data.symbol,
+        timestamp_utc.count(),
+        reference_data.tick_size,
+        reference_data.multiplier,
+        reference_data.min_trade_vol));
+  }
+  void operator()(
+      const MarketStatus &market_status, std::chrono::nanoseconds timestamp_utc) override {
+    result.push_back(fmt::format(
+        "S|{}|{}|{}|{}",
+        market_status.exchange,
+        market_status.symbol,
+        timestamp_utc.count(),
+        market_status.trading_status == TradingStatus::OPEN ? "OPEN" : "OTHER"));
+  }
+  void operator()(
+      const MarketByPriceUpdate &market_by_price_update,
+      std::chrono::nanoseconds timestamp_utc) override {
+    EXPECT_EQ(market_by_price_update.exchange_time_utc, timestamp_utc);
+    auto levels = [](auto &updates) {
+      std::string result;
+      for (auto &update : updates)
+        result += fmt::format("{}{}:{}", result.empty() ? "" : ",", update.price, update.quantity);
+      return result;
+    };
+    result.push_back(fmt::format(
+        "P|{}|{}|{}|{}|{}|{}",
+        market_by_price_update.exchange,
+        market_by_price_update.symbol,
+        timestamp_utc.count(),
+        market_by_price_update.snapshot ? "snapshot" : "update",
+        levels(market_by_price_update.bids),
+        levels(market_by_price_update.asks)));
+  }
+  void operator()(
+      const MarketByOrderUpdate &market_by_order_update,
+      std::chrono::nanoseconds timestamp_utc) override {
+    EXPECT_EQ(market_by_order_update.exchange_time_utc, timestamp_utc);
+    auto orders = [](auto &updates) {
+      std::string result;
+      for (auto &update : updates)
+        result += fmt::format(
+            "{}{}:{}:{}:{}",
+            result.empty() ? "" : ",",
+            update.price,
+            update.remaining_quantity,
+            action(update.action),
+            update.order_id);
+      return result;
+    };
+    result.push_back(fmt::format(
+        "O|{}|{}|{}|{}|{}|{}",
+        market_by_order_update.exchange,
+        market_by_order_update.symbol,
+        timestamp_utc.count(),
+        market_by_order_update.snapshot ? "snapshot" : "update",
+        orders(market_by_order_update.bids),
+        orders(market_by_order_update.asks)));
+  }
+  void operator()(
+      const TradeSummary &trade_summary, std::chrono::nanoseconds timestamp_utc) override {
+    EXPECT_EQ(trade_summary.exchange_time_utc, timestamp_utc);
+    std::string trades;
+    for (auto &trade : trade_summary.trades)
+      trades += fmt::format(
+          "{}{}:{}:{}:{}",
+          trades.empty() ? "" : ",",
+          side(trade.side),
+          trade.price,
+          trade.quantity,
+          trade.trade_id);
+    result.push_back(fmt::format(
+        "T|{}|{}|{}|{}",
+        trade_summary.exchange,
+        trade_summary.symbol,
+        timestamp_utc.count(),
+        trades));
+  }
+  std::vector<std::string> result;
+};
+
+std::vector<std::string> read(const std::string_view &name, const std::string_view &data) {
+  auto path = ::testing::TempDir() + "roq-samples-test-csv-reader-" + std::string{name};
+  test::write_file(path, data);
+  Collector collector;
+  try {
+    CSVReader(path).dispatch(collector);
+  } catch (...) {
+    std::remove(path.c_str());
+    throw;
+  }
+  std::remove(path.c_str());
+  return collector.result;
+}
+}  // namespace
+
+TEST(csv_reader, messages) {
+  auto data =
+      "# comment\n"
+      "R,1,CME,GEZ1,0.0025,2500,1\n"
+      "S,2,CME,GEZ1,OPEN\n"
+      "\n"
+      "P,3,CME,GEZ1,1,B,99.785,3\n"
+      "P,3,CME,GEZ1,1,S,99.8,2\n"
+      "P,3,CME,GEZ1,1,B,99.78,1\r\n"  // note! windows line ending
+      "P,4,CME,GEZ1,0,B,99.785,0\n"
+      "O,5,CME,GEZ1,0,B,99.785,1,N,order-1\n"
+      "O,5,CME,GEZ1,0,S,99.8,2,M,order-2\n"
+      "O,5,CME,GEZ1,0,S,99.805,0,R,order-3\n"
+      "T,6,CME,GEZ1,B,99.8,1,trade-1\n"
+      "T,6,CME,GEZ1,S,99.785,2,trade-2\n"
+      "T,7,CME,GEZ1,S,99.785,1,";  // note! no trade id and no trailing newline
+  EXPECT_EQ(
+      read("messages", data),
+      (std::vector<std::string>{
+          "R|CME|GEZ1|1|0.0025|2500|1",
+          "S|CME|GEZ1|2|OPEN",
+          "P|CME|GEZ1|3|snapshot|99.785:3,99.78:1|99.8:2",
+          "P|CME|GEZ1|4|update|99.785:0|",
+          "O|CME|GEZ1|5|update|99.785:1:N:order-1|99.8:2:M:order-2,99.805:0:R:order-3",
+          "T|CME|GEZ1|6|B:99.8:1:trade-1,S:99.785:2:trade-2",
+          "T|CME|GEZ1|7|S:99.785:1:",
+      }));
+}
+
+// note! consecutive lines are only grouped when timestamp, exchange, symbol (and snapshot) match
+TEST(csv_reader, grouping) {
+  auto data =
+      "P,1,CME,GEZ1,0,B,1,1\n"
+      "P,1,CME,GEZ2,0,B,2,1\n"
+      "P,1,CME,GEZ2,1,B,3,1\n"
+      "P,1,ICE,GEZ2,1,B,4,1\n"
+      "P,2,ICE,GEZ2,1,B,5,1\n"
+      "T,2,ICE,GEZ2,B,5,1,1\n"
+      "P,2,ICE,GEZ2,1,B,6,1\n"
+      "S,2,ICE,GEZ2,HALT\n"  // note! flushes
+      "P,2,ICE,GEZ2,1,B,7,1";
+  EXPECT_EQ(
+      read("grouping", data),
+      (std::vector<std::string>{
+          "P|CME|GEZ1|1|update|1:1|",
+          "P|CME|GEZ2|1|update|2:1|",
+          "P|CME|GEZ2|1|snapshot|3:1|",
+          "P|ICE|GEZ2|1|snapshot|4:1|",
+          "P|ICE|GEZ2|2|snapshot|5:1|",
+          "T|ICE|GEZ2|2|B:5:1:1",
+          "P|ICE|GEZ2|2|snapshot|6:1|",
+          "S|ICE|GEZ2|2|OTHER",
+          "P|ICE|GEZ2|2|snapshot|7:1|",
+      }));
+}
+
+TEST(csv_reader, invalid) {
+  std::string_view lines[] = {
+      "X,1,CME,GEZ1",
+      "P",
+      "R,1,CME,GEZ1,0.0025,2500",
+      "R,1,CME,GEZ1,tick,2500,1",
+      "S,1,CME,GEZ1,UNKNOWN",
+      "S,-1,CME,GEZ1,OPEN",
+      "P,1,CME,GEZ1,2,B,1,1",
+      "P,1,CME,GEZ1,0,X,1,1",
+      "P,1,CME,GEZ1,0,B,1",
+      "P,1,CME,GEZ1,0,B,one,1",
+      "O,1,CME,GEZ1,0,B,1,1,N,",
+      "O,1,CME,GEZ1,0,B,1,1,X,order-1",
+      "T,1,CME,GEZ1,X,1,1,trade-1",
+      "T,1,CME,GEZ1,B,1,1",
+  };
+  for (auto &line : lines) {
+    // note! after a valid line
+    auto data = "S,1,CME,GEZ1,OPEN\n" + std::string{line} + "\n";
+    EXPECT_THROW(read("invalid", data), RuntimeErrorException) << line;
+  }
+}
+
+// note! all lines of a symbol are assigned to the same shard
+TEST(csv_reader, shard) {
+  static const size_t SHARDS = 4;
+  for (auto symbol : {"GEZ1", "GEZ2", "GEH2", "GEM2", "BTC-PERPETUAL"}) {
+    auto expected = std::hash<std::string_view>()(symbol) % SHARDS;
+    for (auto line : {
+             fmt::format("R,1,CME,{},0.0025,2500,1", symbol),
+             fmt::format("P,1,CME,{},0,B,1,1", symbol),
+             fmt::format("T,1,CME,{}", symbol),
+         })
+      EXPECT_EQ(CSVReader::shard(line, SHARDS), expected) << line;
+  }
+  EXPECT_EQ(CSVReader::shard("", SHARDS), 0u);
+  EXPECT_EQ(CSVReader::shard("XYZ", SHARDS), 0u);
+}
+
+TEST(csv_reader, push) {
+  Collector collector;
+  CSVReader reader("push", CSVReader::Push{});
+  reader("P,1,CME,GEZ1,0,B,1,1", 10, collector);
+  reader("P,1,CME,GEZ1,0,S,2,1", 20, collector);
+  EXPECT_TRUE(collector.result.empty());
+  reader.flush(collector);
+  EXPECT_EQ(collector.result, (std::vector<std::string>{"P|CME|GEZ1|1|update|1:1|2:1"}));
+  EXPECT_THROW(reader("P,1,CME", 30, collector), RuntimeErrorException);
+}
@@ -0,0 +1,51 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#include <gtest/gtest.h>
+
+#include <iterator>
+
+#include "roq/api.h"
+
+#include "roq/samples/common/depth.h"
+
+using namespace roq;
+using namespace roq::samples::common;
+
+namespace {
+template <typename T>
+void update(T &depth, MBPUpdate bid, MBPUpdate ask) {
+  MBPUpdate bids[] = {bid};
+  MBPUpdate asks[] = {ask};
+  depth.update(MarketByPriceUpdate{
+      .stream_id = {},
+      .exchange = {},
+      .symbol = {},
+      .bids = {bids, std::size(bids)},
+      .asks = {asks, std::size(asks)},
+      .snapshot = true,
+      .exchange_time_utc = {},
+  });
+}
+}  // namespace
+
+TEST(depth, is_valid) {
+  Depth<2> depth;
+  depth.set_tick_size(0.5);
+  // empty
+  EXPECT_TRUE(depth.is_valid());
+  // one-sided
+  update(depth, {.price = 100.0, .quantity = 1.0}, {.price = 100.5, .quantity = 0.0});
+  EXPECT_TRUE(depth.is_valid());
+  update(depth, {.price = 100.0, .quantity = 0.0}, {.price = 100.5, .quantity = 1.0});
+  EXPECT_TRUE(depth.is_valid());
+  // both sides
+  update(depth, {.price = 100.0, .quantity = 1.0}, {.price = 100.5, .quantity = 1.0});
+  EXPECT_TRUE(depth.is_valid());
+  EXPECT_FALSE(depth.is_full());
+  // locked
+  update(depth, {.price = 100.0, .quantity = 1.0}, {.price = 100.0, .quantity = 1.0});
+  EXPECT_FALSE(depth.is_valid());
+  // crossed
+  update(depth, {.price = 100.5, .quantity = 1.0}, {.price = 100.0, .quantity = 1.0});
+  EXPECT_FALSE(depth.is_valid());
+}
@@ -0,0 +1,158 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iterator>
+
+#include "roq/api.h"
+
+#include "roq/samples/common/depth_history.h"
+
+using namespace std::chrono_literals;
+using namespace roq;
+using namespace roq::samples::common;
+
+namespace {
+static const double TICK_SIZE = 0.5;
+
+using History = DepthHistory<4, 3>;
+
+// note! one level per side
+void append(
+    History &history,
+    int64_t bid_tick,
+    double bid_quantity,
+    int64_t ask_tick,
+    double ask_quantity,
+    std::chrono::nanoseconds exchange_time = {}) {
+  Layer layers[] = {
+      {
+          .bid_price = bid_tick * TICK_SIZE,
+          .bid_quantity = bid_quantity,
+          .ask_price = ask_tick * TICK_SIZE,
+          .ask_quantity = ask_quantity,
+      },
+  };
+  history.append({layers, std::size(layers)}, TICK_SIZE, exchange_time);
+}
+}  // namespace
+
+// note! SIZE is a power of two, the oldest entry is overwritten
+TEST(depth_history, wraparound) {
+  History history;
+  EXPECT_TRUE(history.empty());
+  EXPECT_EQ(history.size(), 0u);
+  for (int64_t i = 0; i < 10; ++i) {
+    append(history, 200 - i, 1.0, 201 + i, 1.0, std::chrono::seconds{i});
+    EXPECT_EQ(history.size(), std::min<size_t>(i + 1, 4));
+    EXPECT_EQ(history.count(), static_cast<uint64_t>(i + 1));
+  }
+  // note! age 0 is the latest entry
+  for (size_t age = 0; age < history.size(); ++age) {
+    auto i = 9 - static_cast<int64_t>(age);
+    auto &entry = history[age];
+    EXPECT_EQ(entry.exchange_time, std::chrono::seconds{i}) << "age=" << age;
+    EXPECT_EQ(entry.bid_tick, 200 - i) << "age=" << age;
+    EXPECT_EQ(entry.ask_tick, 201 + i) << "age=" << age;
+  }
+}
+
+TEST(depth_history, levels) {
+  History history;
+  Layer layers[] = {
+      {.bid_price = 100.0, .bid_quantity = 1.0, .ask_price = 100.5, .ask_quantity = 4.0},
+      {.bid_price = 99.0, .bid_quantity = 2.0, .ask_price = 0.0, .ask_quantity = 0.0},
+      {.bid_price = 98.5, .bid_quantity = 3.0, .ask_price = 0.0, .ask_quantity = 0.0},
+      {.bid_price = 98.0, .bid_quantity = 5.0, .ask_price = 0.0, .ask_quantity = 0.0},
+  };
+  history.append({layers, std::size(layers)}, TICK_SIZE, 1s);
+  auto &entry = history[0];
+  // note! LEVELS is 3
+  ASSERT_EQ(entry.bid_levels, 3u);
+  EXPECT_EQ(entry.bid(0), 200);
+  EXPECT_EQ(entry.bid(1), 198);
+  EXPECT_EQ(entry.bid(2), 197);
+  EXPECT_EQ(entry.bid_quantity[2], 3.0f);
+  ASSERT_EQ(entry.ask_levels, 1u);
+  EXPECT_EQ(entry.ask(0), 201);
+  EXPECT_EQ(entry.ask_quantity[0], 4.0f);
+}
+
+// note! offsets are uint16_t, a side stops at the first level which can't be represented
+TEST(depth_history, max_offset) {
+  History history;
+  auto far = static_cast<double>(History::MAX_OFFSET + 1) * TICK_SIZE;
+  Layer layers[] = {
+      {.bid_price = far + 100.0, .bid_quantity = 1.0, .ask_price = 100.0, .ask_quantity = 1.0},
+      {.bid_price = far + 99.5, .bid_quantity = 2.0, .ask_price = far + 99.5, .ask_quantity = 2.0},
+      {.bid_price = 99.5, .bid_quantity = 3.0, .ask_price = far + 100.5, .ask_quantity = 3.0},
+  };
+  history.append({layers, std::size(layers)}, TICK_SIZE, 1s);
+  auto &entry = history[0];
+  ASSERT_EQ(entry.bid_levels, 2u);
+  EXPECT_EQ(entry.bid(1), static_cast<int64_t>((far + 99.5) / TICK_SIZE));
+  // note! exactly MAX_OFFSET is stored
+  ASSERT_EQ(entry.ask_levels, 2u);
+  EXPECT_EQ(entry.ask(1), 200 + History::MAX_OFFSET);
+  EXPECT_EQ(entry.ask_offset[1], History::MAX_OFFSET);
+  // note! out of order
+  Layer crossed[] = {
+      {.bid_price = 100.0, .bid_quantity = 1.0, .ask_price = 101.0, .ask_quantity = 1.0},
+      {.bid_price = 100.5, .bid_quantity = 1.0, .ask_price = 100.5, .ask_quantity = 1.0},
+  };
+  history.append({crossed, std::size(crossed)}, TICK_SIZE, 2s);
+  EXPECT_EQ(history[0].bid_levels, 1u);
+  EXPECT_EQ(history[0].ask_levels, 1u);
+}
+
+// note! positive means buying pressure
+TEST(depth_history, order_flow_imbalance) {
+  History history;
+  append(history, 200, 5.0, 202, 5.0);
+  EXPECT_EQ(history[0].order_flow_imbalance, 0.0f);  // note! no previous entry
+  // bid grows
+  append(history, 200, 7.0, 202, 5.0);
+  EXPECT_EQ(history[0].order_flow_imbalance, 2.0f);
+  // bid improves
+  append(history, 201, 1.0, 202, 5.0);
+  EXPECT_EQ(history[0].order_flow_imbalance, 1.0f);
+  // bid retreats
+  append(history, 200, 3.0, 202, 5.0);
+  EXPECT_EQ(history[0].order_flow_imbalance, -1.0f);
+  // ask shrinks
+  append(history, 200, 3.0, 202, 2.0);
+  EXPECT_EQ(history[0].order_flow_imbalance, 3.0f);
+  // ask retreats
+  append(history, 200, 3.0, 203, 4.0);
+  EXPECT_EQ(history[0].order_flow_imbalance, 2.0f);
+  // ask improves
+  append(history, 200, 3.0, 201, 6.0);
+  EXPECT_EQ(history[0].order_flow_imbalance, -6.0f);
+  // note! an empty side is ignored
+  append(history, 200, 3.0, 201, 0.0);
+  EXPECT_EQ(history[0].order_flow_imbalance, 0.0f);
+  // sum of the latest entries
+  EXPECT_DOUBLE_EQ(history.order_flow_imbalance(2), -6.0);
+  EXPECT_DOUBLE_EQ(history.order_flow_imbalance(3), -4.0);
+  EXPECT_DOUBLE_EQ(history.order_flow_imbalance(100), -1.0);  // note! only SIZE entries
+  EXPECT_DOUBLE_EQ(history.order_flow_imbalance(0), 0.0);
+}
+
+TEST(depth_history, clear) {
+  History history;
+  append(history, 200, 5.0, 202, 5.0);
+  append(history, 201, 5.0, 202, 5.0);
+  history.clear();
+  EXPECT_TRUE(history.empty());
+  EXPECT_EQ(history.size(), 0u);
+  EXPECT_EQ(history.count(), 0u);
+  EXPECT_DOUBLE_EQ(history.order_flow_imbalance(4), 0.0);
+  // note! not compared with the entry from before clear
+  append(history, 300, 1.0, 302, 1.0);
+  EXPECT_EQ(history.size(), 1u);
+  EXPECT_EQ(history[0].bid_tick, 300);
+  EXPECT_EQ(history[0].order_flow_imbalance, 0.0f);
+}
@@ -0,0 +1,225 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#include <gtest/gtest.h>
+
+#include <flatbuffers/flatbuffers.h>
+
+#include <chrono>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "roq/api.h"
+
+#include "roq/fbs/api.h"
+
+#include "roq/samples/import/encoder.h"
+#include "roq/samples/import/frame.h"
+
+using namespace std::chrono_literals;
+using namespace roq;
+using namespace roq::samples::import;
+
+namespace {
+MessageInfo create_message_info(uint64_t source_seqno, bool is_last) {
+  std::chrono::nanoseconds timestamp_utc = std::chrono::seconds(source_seqno);
+  return MessageInfo{
+      .source = 1,
+      .source_name = "test",
+      .source_session_id = {},
+      .source_seqno = source_seqno,
+      .receive_time_utc = timestamp_utc,
+      .receive_time = timestamp_utc,
+      .source_send_time = timestamp_utc,
+      .source_receive_time = timestamp_utc,
+      .origin_create_time = timestamp_utc,
+      .origin_create_time_utc = timestamp_utc,
+      .is_last = is_last,
+      .opaque = {},
+  };
+}
+
+// note! verifies the frame before it is accessed
+const fbs::Event &decode(const Encoder &encoder) {
+  EXPECT_EQ(Frame::length(encoder.data()), encoder.size());
+  flatbuffers::Verifier verifier(encoder.data(), encoder.size());
+  EXPECT_TRUE(fbs::VerifySizePrefixedEventBuffer(verifier));
+  return Frame::event(encoder.data());
+}
+
+void check(const fbs::Event &event, uint64_t source_seqno, bool is_last) {
+  auto &message_info = *event.message_info();
+  EXPECT_EQ(message_info.source(), 1u);
+  EXPECT_EQ(message_info.source_name()->str(), "test");
+  EXPECT_EQ(message_info.source_seqno(), source_seqno);
+  std::chrono::nanoseconds timestamp_utc = std::chrono::seconds(source_seqno);
+  EXPECT_EQ(message_info.receive_time_utc(), timestamp_utc.count());
+  EXPECT_EQ(message_info.is_last(), is_last);
+}
+
+template <typename T>
+void check(
+    const flatbuffers::Vector<flatbuffers::Offset<fbs::MBOUpdate>> *result, const T &expected) {
+  ASSERT_NE(result, nullptr);
+  ASSERT_EQ(result->size(), std::size(expected));
+  for (size_t i = 0; i < std::size(expected); ++i) {
+    SCOPED_TRACE(::testing::Message() << "i=" << i);
+    auto &update = *(*result)[i];
+    EXPECT_EQ(update.price(), expected[i].price);
+    EXPECT_EQ(update.remaining_quantity(), expected[i].remaining_quantity);
+    EXPECT_EQ(static_cast<int>(update.action()), static_cast<int>(expected[i].action));
+    EXPECT_EQ(update.priority(), expected[i].priority);
+    EXPECT_EQ(update.order_id()->str(), expected[i].order_id);
+  }
+}
+
+void check(const fbs::MarketByOrderUpdate *result, const MarketByOrderUpdate &expected) {
+  ASSERT_NE(result, nullptr);
+  EXPECT_EQ(result->stream_id(), expected.stream_id);
+  EXPECT_EQ(result->exchange()->str(), expected.exchange);
+  EXPECT_EQ(result->symbol()->str(), expected.symbol);
+  check(result->bids(), expected.bids);
+  check(result->asks(), expected.asks);
+  EXPECT_EQ(result->snapshot(), expected.snapshot);
+  EXPECT_EQ(result->exchange_time_utc(), expected.exchange_time_utc.count());
+}
+
+void check(const fbs::TradeSummary *result, const TradeSummary &expected) {
+  ASSERT_NE(result, nullptr);
+  EXPECT_EQ(result->stream_id(), expected.stream_id);
+  EXPECT_EQ(result->exchange()->str(), expected.exchange);
+  EXPECT_EQ(result->symbol()->str(), expected.symbol);
+  auto trades = result->trades();
+  ASSERT_NE(trades, nullptr);
+  ASSERT_EQ(trades->size(), std::size(expected.trades));
+  for (size_t i = 0; i < std::size(expected.trades); ++i) {
+    SCOPED_TRACE(::testing::Message() << "i=" << i);
+    auto &trade = *(*trades)[i];
+    EXPECT_EQ(static_cast<int>(trade.side()), static_cast<int>(expected.trades[i].side));
+    EXPECT_EQ(trade.price(), expected.trades[i].price);
+    EXPECT_EQ(trade.quantity(), expected.trades[i].quantity);
+    EXPECT_EQ(trade.trade_id()->str(), expected.trades[i].trade_id);
+  }
+  EXPECT_EQ(result->exchange_time_utc(), expected.exchange_time_utc.count());
+}
+}  // namespace
+
+// note! the builder and the offsets are re-used, a smaller event must not see anything from a
+// previous (larger) event
+TEST(encoder, market_by_order_update) {
+  Encoder encoder(64);  // note! must grow
+  MBOUpdate bids[] = {
+      {.price = 100.0,
+       .remaining_quantity = 1.0,
+       .action = OrderUpdateAction::NEW,
+       .priority = 1,
+       .order_id = "order-1"},
+      {.price = 99.5,
+       .remaining_quantity = 2.0,
+       .action = OrderUpdateAction::MODIFY,
+       .priority = 2,
+       .order_id = "order-2"},
+      {.price = 99.0,
+       .remaining_quantity = 0.0,
+       .action = OrderUpdateAction::REMOVE,
+       .priority = 3,
+       .order_id = "order-3"},
+  };
+  MBOUpdate asks[] = {
+      {.price = 101.0,
+       .remaining_quantity = 4.0,
+       .action = OrderUpdateAction::NEW,
+       .priority = 4,
+       .order_id = "order-4"},
+      {.price = 101.5,
+       .remaining_quantity = 5.0,
+       .action = OrderUpdateAction::NEW,
+       .priority = 5,
+       .order_id = "order-5"},
+  };
+  MarketByOrderUpdate large{
+      .stream_id = 7,
+      .exchange = "deribit",
+      .symbol = "BTC-PERPETUAL",
+      .bids = {bids, std::size(bids)},
+      .asks = {asks, std::size(asks)},
+      .snapshot = true,
+      .exchange_time_utc = 123s,
+  };
+  encoder(Event<MarketByOrderUpdate>(create_message_info(1, false), large));
+  auto &event = decode(encoder);
+  check(event, 1, false);
+  ASSERT_EQ(event.message_type(), fbs::Message::MarketByOrderUpdate);
+  check(event.message_as_MarketByOrderUpdate(), large);
+  auto size = encoder.size();
+  // smaller
+  MarketByOrderUpdate small{
+      .stream_id = {},
+      .exchange = "CME",
+      .symbol = "GEZ1",
+      .bids = {&asks[1], 1},
+      .asks = {},
+      .snapshot = false,
+      .exchange_time_utc = 124s,
+  };
+  encoder(Event<MarketByOrderUpdate>(create_message_info(2, true), small));
+  EXPECT_LT(encoder.size(), size);
+  auto &event_2 = decode(encoder);
+  check(event_2, 2, true);
+  ASSERT_EQ(event_2.message_type(), fbs::Message::MarketByOrderUpdate);
+  check(event_2.message_as_MarketByOrderUpdate(), small);
+}
+
+TEST(encoder, trade_summary) {
+  Encoder encoder(64);
+  Trade trades[] = {
+      {.side = Side::BUY, .price = 100.0, .quantity = 1.0, .trade_id = "trade-1"},
+      {.side = Side::SELL, .price = 99.5, .quantity = 2.0, .trade_id = "trade-2"},
+      {.side = Side::BUY, .price = 100.5, .quantity = 3.0, .trade_id = "trade-3"},
+  };
+  TradeSummary large{
+      .stream_id = 7,
+      .exchange = "deribit",
+      .symbol = "BTC-PERPETUAL",
+      .trades = {trades, std::size(trades)},
+      .exchange_time_utc = 123s,
+  };
+  encoder(Event<TradeSummary>(create_message_info(1, true), large));
+  auto &event = decode(encoder);
+  check(event, 1, true);
+  ASSERT_EQ(event.message_type(), fbs::Message::TradeSummary);
+  check(event.message_as_TradeSummary(), large);
+  // note! interleaved with another message type
+  MBOUpdate bids[] = {
+      {.price = 100.0,
+       .remaining_quantity = 1.0,
+       .action = OrderUpdateAction::NEW,
+       .priority = 1,
+       .order_id = "order-1"},
+  };
+  MarketByOrderUpdate market_by_order_update{
+      .stream_id = 7,
+      .exchange = "deribit",
+      .symbol = "BTC-PERPETUAL",
+      .bids = {bids, std::size(bids)},
+      .asks = {},
+      .snapshot = false,
+      .exchange_time_utc = 124s,
+  };
+  encoder(Event<MarketByOrderUpdate>(create_message_info(2, true), market_by_order_update));
+  ASSERT_EQ(decode(encoder).message_type(), fbs::Message::MarketByOrderUpdate);
+  // smaller
+  TradeSummary small{
+      .stream_id = {},
+      .exchange = "CME",
+      .symbol = "GEZ1",
+      .trades = {&trades[2], 1},
+      .exchange_time_utc = 125s,
+  };
+  encoder(Event<TradeSummary>(create_message_info(3, false), small));
+  auto &event_2 = decode(encoder);
+  check(event_2, 3, false);
+  ASSERT_EQ(event_2.message_type(), fbs::Message::TradeSummary);
+  check(event_2.message_as_TradeSummary(), small);
+}
@@ -0,0 +1,138 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <random>
+#include <string_view>
+#include <vector>
+
+#include "roq/api.h"
+
+#include "roq/samples/example-3/features.h"
+
+using namespace roq;
+using namespace roq::samples::example_3;
+
+namespace {
+static const double ALPHA = 0.33;
+static const double TOLERANCE = 1.0e-12;  // note! relative
+static const size_t ROUNDS = 5;
+
+// note! some instruments are one-sided or empty (NaN)
+void populate(std::mt19937_64 &generator, Features &lhs, Features &rhs) {
+  std::uniform_real_distribution<double> offset(0.0, 1.0);
+  std::uniform_real_distribution<double> quantity(0.001, 100.0);
+  std::uniform_int_distribution<size_t> levels(0, lhs.depth());
+  std::vector<Layer> layers(lhs.depth());
+  for (size_t i = 0; i < lhs.capacity(); ++i) {
+    auto mid = 100.0 + 1000.0 * offset(generator);
+    auto bid_levels = levels(generator), ask_levels = levels(generator);
+    auto bid_price = mid, ask_price = mid;
+    for (size_t j = 0; j < layers.size(); ++j) {
+      bid_price -= offset(generator);
+      ask_price += offset(generator);
+      layers[j] = {
+          .bid_price = j < bid_levels ? bid_price : 0.0,
+          .bid_quantity = j < bid_levels ? quantity(generator) : 0.0,
+          .ask_price = j < ask_levels ? ask_price : 0.0,
+          .ask_quantity = j < ask_levels ? quantity(generator) : 0.0,
+      };
+    }
+    lhs.set(i, {layers.data(), layers.size()});
+    rhs.set(i, {layers.data(), layers.size()});
+  }
+}
+
+void compare(double lhs, double rhs, const char *name, size_t index) {
+  if (std::isnan(lhs)) {
+    EXPECT_TRUE(std::isnan(rhs)) << name << ", index=" << index;
+    return;
+  }
+  EXPECT_NEAR(lhs, rhs, TOLERANCE * std::max(std::abs(lhs), 1.0)) << name << ", index=" << index;
+}
+
+void compare(const Features &lhs, const Features &rhs) {
+  for (size_t i = 0; i < lhs.capacity(); ++i) {
+    compare(lhs.weighted_bid(i), rhs.weighted_bid(i), "weighted_bid", i);
+    compare(lhs.weighted_ask(i), rhs.weighted_ask(i), "weighted_ask", i);
+    compare(lhs.spread(i), rhs.spread(i), "spread", i);
+    compare(lhs.imbalance(i), rhs.imbalance(i), "imbalance", i);
+    compare(lhs.bid_ema(i), rhs.bid_ema(i), "bid_ema", i);
+    compare(lhs.ask_ema(i), rhs.ask_ema(i), "ask_ema", i);
+  }
+}
+}  // namespace
+
+TEST(features, implementations) {
+  auto implementations = Features::implementations();
+  ASSERT_FALSE(implementations.empty());
+  EXPECT_EQ(implementations.front(), Features::implementation());
+  EXPECT_EQ(implementations.back(), "scalar");
+#if defined(__x86_64__)
+  __builtin_cpu_init();
+  auto supported = [&](auto name) {
+    return std::find(implementations.begin(), implementations.end(), name) !=
+           implementations.end();
+  };
+  EXPECT_EQ(supported("avx2"), __builtin_cpu_supports("avx2") != 0);
+  EXPECT_EQ(supported("avx512"), __builtin_cpu_supports("avx512f") != 0);
+#endif
+  Features features(8, 1, ALPHA);
+  EXPECT_THROW(features.update("unknown"), std::exception);
+}
+
+// each implementation supported by the cpu must match the reference implementation
+// note! capacities are not multiples of the vector width (padding)
+TEST(features, compare) {
+  std::mt19937_64 generator(1);
+  for (auto implementation : Features::implementations()) {
+    for (size_t capacity : {1, 3, 7, 8, 13, 16, 37, 100}) {
+      for (size_t depth : {1, 2, 5, 10}) {
+        SCOPED_TRACE(::testing::Message() << "implementation=" << implementation
+                                          << ", capacity=" << capacity << ", depth=" << depth);
+        Features reference(capacity, depth, ALPHA), features(capacity, depth, ALPHA);
+        // note! several rounds to compare the ema
+        for (size_t round = 0; round < ROUNDS; ++round) {
+          populate(generator, reference, features);
+          if (round == 2) {
+            reference.reset(0);
+            features.reset(0);
+          }
+          reference.update_scalar();
+          features.update(implementation);
+          compare(reference, features);
+        }
+      }
+    }
+  }
+}
+
+TEST(features, values) {
+  Features features(3, 2, 0.5);
+  Layer layers[] = {
+      {.bid_price = 99.0, .bid_quantity = 1.0, .ask_price = 101.0, .ask_quantity = 3.0},
+      {.bid_price = 98.0, .bid_quantity = 3.0, .ask_price = 102.0, .ask_quantity = 1.0},
+  };
+  features.set(1, {layers, 2});
+  for (auto implementation : Features::implementations()) {
+    features.reset(1);
+    features.update(implementation);
+    EXPECT_DOUBLE_EQ(features.weighted_bid(1), 98.25) << implementation;
+    EXPECT_DOUBLE_EQ(features.weighted_ask(1), 101.25) << implementation;
+    EXPECT_DOUBLE_EQ(features.spread(1), 2.0) << implementation;
+    EXPECT_DOUBLE_EQ(features.imbalance(1), 0.0) << implementation;
+    EXPECT_DOUBLE_EQ(features.bid_ema(1), 98.25) << implementation;
+    // note! empty
+    EXPECT_TRUE(std::isnan(features.weighted_bid(0))) << implementation;
+    EXPECT_TRUE(std::isnan(features.bid_ema(2))) << implementation;
+  }
+  layers[0].bid_quantity = 5.0;
+  features.set(1, {layers, 2});
+  features.update();
+  // note! (99 * 5 + 98 * 3) / 8 = 98.625
+  EXPECT_DOUBLE_EQ(features.weighted_bid(1), 98.625);
+  EXPECT_DOUBLE_EQ(features.bid_ema(1), 0.5 * 98.625 + 0.5 * 98.25);
+}
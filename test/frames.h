@@ -0,0 +1,72 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#pragma once
+
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "roq/api.h"
+
+#include "roq/samples/import/encoder.h"
+
+// helpers shared by the tests of the import tool
+
+namespace roq {
+namespace samples {
+namespace import {
+namespace test {
+
+// binary frames (MarketStatus), one per second (starting from 1s)
+// note! source_seqno is the number of seconds
+inline std::vector<std::string> create_frames(size_t count) {
+  std::vector<std::string> result;
+  Encoder encoder;
+  for (size_t i = 0; i < count; ++i) {
+    std::chrono::nanoseconds timestamp_utc = std::chrono::seconds(i + 1);
+    MessageInfo message_info{
+        .source = {},
+        .source_name = {},
+        .source_session_id = {},
+        .source_seqno = i + 1,
+        .receive_time_utc = timestamp_utc,
+        .receive_time = timestamp_utc,
+        .source_send_time = timestamp_utc,
+        .source_receive_time = timestamp_utc,
+        .origin_create_time = timestamp_utc,
+        .origin_create_time_utc = timestamp_utc,
+        .is_last = true,
+        .opaque = {},
+    };
+    MarketStatus market_status{
+        .stream_id = {},
+        .exchange = "CME",
+        .symbol = "GEZ1",
+        .trading_status = TradingStatus::OPEN,
+    };
+    Event<MarketStatus> event(message_info, market_status);
+    encoder(event);
+    result.emplace_back(reinterpret_cast<char const *>(encoder.data()), encoder.size());
+  }
+  return result;
+}
+
+// concatenated frames
+inline std::string binary(const std::vector<std::string> &frames) {
+  std::string result;
+  for (auto &frame : frames)
+    result += frame;
+  return result;
+}
+
+inline void write_file(const std::string &path, const std::string_view &data) {
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file.write(data.data(), data.size());
+}
+
+}  // namespace test
+}  // namespace import
+}  // namespace samples
+}  // namespace roq
@@ -0,0 +1,297 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#include <gtest/gtest.h>
+
+#include <fmt/format.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "roq/api.h"
+
+#include "roq/samples/import/generator.h"
+#include "roq/samples/import/handler.h"
+
+using namespace roq;
+using namespace roq::samples::import;
+
+namespace {
+static const double TICK_SIZE = 0.01;
+static const uint32_t DEPTH = 5;
+
+Generator::Config create_config(uint64_t seed) {
+  return {
+      .seed = seed,
+      .events = 100000,
+      .symbols = 10,
+      .rate = 1.0e6,
+      .skew = 1.0,
+      .depth = DEPTH,
+      .trade_ratio = 0.1,
+      .mbo_ratio = 0.3,
+  };
+}
+
+int64_t ticks(double price) {
+  auto result = std::llround(price / TICK_SIZE);
+  EXPECT_NEAR(static_cast<double>(result) * TICK_SIZE, price, 1.0e-9) << "price=" << price;
+  return result;
+}
+
+// one line per event (same timestamp format as the csv)
+struct Recorder final : public Handler {
+  void operator()(const GatewaySettings &, std::chrono::nanoseconds) override {}
+  void operator()(
+      const ReferenceData &reference_data, std::chrono::nanoseconds timestamp_utc) override {
+    result.push_back(fmt::format(
+        "R,{},{},{},{}",
+        timestamp_utc.count(),
+        reference_data.exchange,
+        reference_data.symbol,
+        reference_data.tick_size));
+  }
+  void operator()(
+      const MarketStatus &market_status, std::chrono::nanoseconds timestamp_utc) override {
+    result.push_back(fmt::format(
+        "S,{},{},{}", timestamp_utc.count(), market_status.exchange, market_status.symbol));
+  }
+  void operator()(
+      const MarketByPriceUpdate &market_by_price_update,
+      std::chrono::nanoseconds timestamp_utc) override {
+    auto line = fmt::format(
+        "P,{},{},{},{}",
+        timestamp_utc.count(),
+        market_by_price_update.exchange,
+        market_by_price_update.symbol,
+        market_by_price_update.snapshot);
+    for (auto &update : market_by_price_update.bids)
+      line += fmt::format(",B:{}:{}", update.price, update.quantity);
+    for (auto &update : market_by_price_update.asks)
+      line += fmt::format(",S:{}:{}", update.price, update.quantity);
+    result.push_back(line);
+  }
+  void operator()(
+      const MarketByOrderUpdate &market_by_order_update,
+      std::chrono::nanoseconds timestamp_utc) override {
+    auto line = fmt::format(
+        "O,{},{},{}",
+        timestamp_utc.count(),
+        market_by_order_update.exchange,
+        market_by_order_update.symbol);
+    for (auto &update : market_by_order_update.bids)
+      line += fmt::format(
+          ",B:{}:{}:{}:{}",
+          update.price,
+          update.remaining_quantity,
+          static_cast<int>(update.action),
+          update.order_id);
+    for (auto &update : market_by_order_update.asks)
+      line += fmt::format(
+          ",S:{}:{}:{}:{}",
+          update.price,
+          update.remaining_quantity,
+          static_cast<int>(update.action),
+          update.order_id);
+    result.push_back(line);
+  }
+  void operator()(
+      const TradeSummary &trade_summary, std::chrono::nanoseconds timestamp_utc) override {
+    auto line = fmt::format(
+        "T,{},{},{}", timestamp_utc.count(), trade_summary.exchange, trade_summary.symbol);
+    for (auto &trade : trade_summary.trades)
+      line += fmt::format(
+          ",{}:{}:{}:{}",
+          static_cast<int>(trade.side),
+          trade.price,
+          trade.quantity,
+          trade.trade_id);
+    result.push_back(line);
+  }
+  std::vector<std::string> result;
+};
+
+// note! maintains the books and checks every event against them
+struct Checker final : public Handler {
+  struct Order final {
+    Side side;
+    int64_t price;
+  };
+  struct Book final {
+    bool reference_data = false;
+    bool market_status = false;
+    std::map<int64_t, double> bids;
+    std::map<int64_t, double> asks;
+    std::unordered_map<std::string, Order> orders;
+    // note! the mid price is between the best bid and the best ask
+    int64_t mid() const { return bids.rbegin()->first + 1; }
+  };
+
+  Book &get_book(const std::string_view &exchange, const std::string_view &symbol) {
+    EXPECT_EQ(exchange, "SIM");
+    return books[std::string{symbol}];
+  }
+
+  void check_timestamp(std::chrono::nanoseconds timestamp_utc) {
+    EXPECT_GE(timestamp_utc, previous);
+    previous = timestamp_utc;
+  }
+
+  void operator()(const GatewaySettings &, std::chrono::nanoseconds) override {}
+  void operator()(
+      const ReferenceData &reference_data, std::chrono::nanoseconds timestamp_utc) override {
+    check_timestamp(timestamp_utc);
+    auto &book = get_book(reference_data.exchange, reference_data.symbol);
+    EXPECT_FALSE(book.reference_data);
+    EXPECT_DOUBLE_EQ(reference_data.tick_size, TICK_SIZE);
+    book.reference_data = true;
+  }
+  void operator()(
+      const MarketStatus &market_status, std::chrono::nanoseconds timestamp_utc) override {
+    check_timestamp(timestamp_utc);
+    auto &book = get_book(market_status.exchange, market_status.symbol);
+    EXPECT_TRUE(book.reference_data);
+    EXPECT_EQ(market_status.trading_status, TradingStatus::OPEN);
+    book.market_status = true;
+  }
+  void operator()(
+      const MarketByPriceUpdate &market_by_price_update,
+      std::chrono::nanoseconds timestamp_utc) override {
+    check_timestamp(timestamp_utc);
+    auto &book = get_book(market_by_price_update.exchange, market_by_price_update.symbol);
+    ASSERT_TRUE(book.market_status);
+    // note! the first update is the image
+    EXPECT_EQ(market_by_price_update.snapshot, book.bids.empty() && book.asks.empty());
+    auto apply = [](auto &updates, auto &levels) {
+      for (auto &update : updates) {
+        EXPECT_GE(update.quantity, 0.0);
+        if (update.quantity > 0.0)
+          levels[ticks(update.price)] = update.quantity;
+        else
+          EXPECT_EQ(levels.erase(ticks(update.price)), 1u) << "price=" << update.price;
+      }
+    };
+    apply(market_by_price_update.bids, book.bids);
+    apply(market_by_price_update.asks, book.asks);
+    // note! always the same depth, contiguous and one tick either side of the mid price
+    ASSERT_EQ(book.bids.size(), DEPTH);
+    ASSERT_EQ(book.asks.size(), DEPTH);
+    auto mid = book.mid();
+    EXPECT_EQ(book.bids.begin()->first, mid - static_cast<int64_t>(DEPTH));
+    EXPECT_EQ(book.asks.begin()->first, mid + 1);
+    EXPECT_EQ(book.asks.rbegin()->first, mid + static_cast<int64_t>(DEPTH));
+    ++market_by_price;
+  }
+  void operator()(
+      const MarketByOrderUpdate &market_by_order_update,
+      std::chrono::nanoseconds timestamp_utc) override {
+    check_timestamp(timestamp_utc);
+    auto &book = get_book(market_by_order_update.exchange, market_by_order_update.symbol);
+    ASSERT_FALSE(book.bids.empty());
+    EXPECT_FALSE(market_by_order_update.snapshot);
+    auto apply = [&](auto &updates, Side side) {
+      for (auto &update : updates) {
+        std::string order_id{update.order_id};
+        auto price = ticks(update.price);
+        auto iter = book.orders.find(order_id);
+        switch (update.action) {
+          case OrderUpdateAction::NEW:
+            EXPECT_EQ(iter, book.orders.end()) << "order_id=" << order_id;
+            EXPECT_GT(update.remaining_quantity, 0.0);
+            book.orders[order_id] = {.side = side, .price = price};
+            break;
+          case OrderUpdateAction::MODIFY:
+          case OrderUpdateAction::REMOVE:
+            ASSERT_NE(iter, book.orders.end()) << "order_id=" << order_id;
+            EXPECT_EQ((*iter).second.side, side);
+            EXPECT_EQ((*iter).second.price, price);
+            if (update.action == OrderUpdateAction::REMOVE) {
+              EXPECT_EQ(update.remaining_quantity, 0.0);
+              book.orders.erase(iter);
+            } else {
+              EXPECT_GT(update.remaining_quantity, 0.0);
+            }
+            break;
+          default:
+            ADD_FAILURE() << "action=" << static_cast<int>(update.action);
+        }
+      }
+    };
+    apply(market_by_order_update.bids, Side::BUY);
+    apply(market_by_order_update.asks, Side::SELL);
+    // note! orders never cross the mid price
+    auto mid = book.mid();
+    for (auto &[order_id, order] : book.orders) {
+      if (order.side == Side::BUY) {
+        EXPECT_LT(order.price, mid) << "order_id=" << order_id;
+      } else {
+        EXPECT_GT(order.price, mid) << "order_id=" << order_id;
+      }
+    }
+    ++market_by_order;
+  }
+  void operator()(
+      const TradeSummary &trade_summary, std::chrono::nanoseconds timestamp_utc) override {
+    check_timestamp(timestamp_utc);
+    auto &book = get_book(trade_summary.exchange, trade_summary.symbol);
+    ASSERT_FALSE(book.bids.empty());
+    ASSERT_EQ(std::size(trade_summary.trades), 1u);
+    auto &trade = trade_summary.trades[0];
+    // note! the aggressor trades at the best opposite price
+    auto expected = trade.side == Side::BUY ? book.asks.begin()->first : book.bids.rbegin()->first;
+    EXPECT_EQ(ticks(trade.price), expected);
+    EXPECT_GT(trade.quantity, 0.0);
+    EXPECT_FALSE(trade.trade_id.empty());
+    ++trades;
+  }
+
+  std::unordered_map<std::string, Book> books;
+  std::chrono::nanoseconds previous = {};
+  size_t market_by_price = {};
+  size_t market_by_order = {};
+  size_t trades = {};
+};
+}  // namespace
+
+TEST(generator, deterministic) {
+  Recorder lhs, rhs, other;
+  Generator(create_config(1)).dispatch(lhs);
+  Generator(create_config(1)).dispatch(rhs);
+  Generator(create_config(2)).dispatch(other);
+  ASSERT_FALSE(lhs.result.empty());
+  EXPECT_TRUE(lhs.result == rhs.result);
+  EXPECT_FALSE(lhs.result == other.result);
+}
+
+TEST(generator, valid) {
+  auto config = create_config(3);
+  Checker checker;
+  Generator(config).dispatch(checker);
+  EXPECT_EQ(checker.books.size(), config.symbols);
+  // note! roughly the configured ratios (moves also remove crossing orders)
+  auto events = static_cast<double>(config.events);
+  EXPECT_NEAR(checker.trades / events, config.trade_ratio, 0.01);
+  EXPECT_GT(checker.market_by_order / events, config.mbo_ratio - 0.01);
+  EXPECT_LT(checker.market_by_order / events, config.mbo_ratio + 0.05);
+  EXPECT_GT(checker.market_by_price, config.events / 2);
+}
+
+TEST(generator, invalid) {
+  auto config = create_config(1);
+  config.symbols = 0;
+  EXPECT_THROW(Generator{config}, RuntimeErrorException);
+  config = create_config(1);
+  config.rate = 0.0;
+  EXPECT_THROW(Generator{config}, RuntimeErrorException);
+  config = create_config(1);
+  config.depth = 0;
+  EXPECT_THROW(Generator{config}, RuntimeErrorException);
+  config = create_config(1);
+  config.trade_ratio = 0.6;
+  config.mbo_ratio = 0.5;
+  EXPECT_THROW(Generator{config}, RuntimeErrorException);
+}
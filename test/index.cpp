@@ -0,0 +1,147 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "roq/api.h"
+
+#include "roq/samples/import/codec.h"
+#include "roq/samples/import/compressor.h"
+#include "roq/samples/import/decompressor.h"
+#include "roq/samples/import/frame.h"
+#include "roq/samples/import/index.h"
+#include "roq/samples/import/mapped_file.h"
+#include "roq/samples/import/writer.h"
+
+#include "frames.h"
+
+using namespace std::chrono_literals;
+using namespace roq;
+using namespace roq::samples::import;
+
+namespace {
+static const size_t FRAMES = 1000;
+static const auto INTERVAL = 10s;
+
+// note! returns the binary stream
+std::string write_binary(const std::string &path, const std::vector<std::string> &frames) {
+  IndexWriter index(Index::path(path), INTERVAL);
+  size_t offset = 0;
+  for (auto &frame : frames) {
+    index(frame.data(), offset);
+    offset += frame.size();
+  }
+  index.close();
+  auto result = test::binary(frames);
+  test::write_file(path, result);
+  return result;
+}
+
+// note! same as the processor: only frames starting a block are checkpoints
+void write_compressed(const std::string &path, const std::vector<std::string> &frames) {
+  Writer writer(path, 4096u, false, 0u);
+  Compressor compressor(writer, Codec::LZ4, 1, 1024u, 0u, 0u);
+  IndexWriter index(Index::path(path), INTERVAL);
+  for (auto &frame : frames)
+    if (compressor.write(frame.data(), frame.size()))
+      index(frame.data(), writer.position());
+  compressor.flush();
+  writer.close();
+  index.close();
+}
+
+void remove_files(const std::string &path) {
+  std::remove(path.c_str());
+  std::remove(Index::path(path).c_str());
+}
+}  // namespace
+
+TEST(index, lookup) {
+  auto path = ::testing::TempDir() + "roq-samples-test-index-lookup";
+  write_binary(path, test::create_frames(FRAMES));
+  {
+    Index index(Index::path(path));
+    // note! checkpoints at 1s, 11s, 21s, ...
+    ASSERT_EQ(index.size(), FRAMES / 10);
+    EXPECT_EQ(index.before(1s), nullptr);
+    auto before = index.before(15s);
+    ASSERT_NE(before, nullptr);
+    EXPECT_EQ(before->receive_time_utc, std::chrono::nanoseconds{11s}.count());
+    EXPECT_EQ(before->source_seqno, 11u);
+    before = index.before(11s);  // note! strictly before
+    ASSERT_NE(before, nullptr);
+    EXPECT_EQ(before->receive_time_utc, std::chrono::nanoseconds{1s}.count());
+    auto after = index.after(15s);
+    ASSERT_NE(after, nullptr);
+    EXPECT_EQ(after->receive_time_utc, std::chrono::nanoseconds{21s}.count());
+    after = index.after(21s);  // note! inclusive
+    ASSERT_NE(after, nullptr);
+    EXPECT_EQ(after->receive_time_utc, std::chrono::nanoseconds{21s}.count());
+    EXPECT_EQ(index.after(std::chrono::seconds(FRAMES + 1)), nullptr);
+  }
+  remove_files(path);
+}
+
+TEST(index, seek_binary) {
+  auto path = ::testing::TempDir() + "roq-samples-test-index-seek-binary";
+  auto data = write_binary(path, test::create_frames(FRAMES));
+  {
+    Index index(Index::path(path));
+    for (auto start : {2s, 10s, 11s, 12s, 500s, 999s}) {
+      auto entry = index.before(start);
+      ASSERT_NE(entry, nullptr);
+      // checkpoint is a frame boundary
+      auto offset = entry->offset;
+      EXPECT_EQ(Frame::receive_time_utc(data.data() + offset).count(), entry->receive_time_utc);
+      EXPECT_EQ(Frame::source_seqno(data.data() + offset), entry->source_seqno);
+      // the first frame at (or after) start is never more than one interval away
+      size_t count = 0;
+      while (Frame::receive_time_utc(data.data() + offset) < start) {
+        offset += Frame::length(data.data() + offset);
+        ++count;
+      }
+      EXPECT_LE(count, 10u);
+      EXPECT_EQ(Frame::receive_time_utc(data.data() + offset), start);
+    }
+  }
+  remove_files(path);
+}
+
+TEST(index, seek_compressed) {
+  auto path = ::testing::TempDir() + "roq-samples-test-index-seek-compressed";
+  write_compressed(path, test::create_frames(FRAMES));
+  {
+    MappedFile file(path);
+    Index index(Index::path(path));
+    ASSERT_GT(index.size(), 1u);
+    for (auto start : {1s, 100s, 500s}) {
+      auto entry = index.after(start);
+      ASSERT_NE(entry, nullptr);
+      // checkpoint is a block boundary and the block starts with the frame
+      Decompressor decompressor(file.data());
+      decompressor.seek(entry->offset);
+      std::string_view frames;
+      ASSERT_TRUE(decompressor.next(frames));
+      EXPECT_EQ(Frame::receive_time_utc(frames.data()).count(), entry->receive_time_utc);
+      EXPECT_EQ(Frame::source_seqno(frames.data()), entry->source_seqno);
+    }
+  }
+  remove_files(path);
+}
+
+TEST(index, invalid) {
+  auto path = ::testing::TempDir() + "roq-samples-test-index-invalid";
+  {
+    std::ofstream file(Index::path(path), std::ios::binary | std::ios::trunc);
+    file << "not an index";
+  }
+  EXPECT_THROW(Index index(Index::path(path)), std::exception);
+  remove_files(path);
+}
@@ -0,0 +1,125 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#include <gtest/gtest.h>
+
+#include <fmt/format.h>
+
+#include <cstdint>
+#include <exception>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "roq/samples/common/instrument_registry.h"
+
+using namespace roq::samples::common;
+
+namespace {
+struct Instrument final {
+  Instrument(const std::string_view &symbol, size_t &count) : symbol(symbol), count(count) {
+    ++count;
+  }
+
+  Instrument(Instrument &&) = delete;
+  Instrument(const Instrument &) = delete;
+
+  ~Instrument() { --count; }
+
+  const std::string symbol;
+  size_t &count;
+};
+
+using Registry = InstrumentRegistry<Instrument>;
+}  // namespace
+
+TEST(instrument_registry, simple) {
+  size_t count = 0;
+  {
+    Registry registry(4);
+    auto id = registry.emplace(1, "CME", "GEZ1", "GEZ1", count);
+    EXPECT_EQ(id, 0u);
+    EXPECT_EQ(registry.size(), 1u);
+    EXPECT_EQ(count, 1u);
+    EXPECT_EQ(registry.find(1, "CME", "GEZ1"), id);
+    EXPECT_EQ(registry[id].symbol, "GEZ1");
+    EXPECT_EQ(registry.find(1, "CME", "GEH2"), Registry::NONE);
+    EXPECT_TRUE(registry.dispatch(1, "CME", "GEZ1", [](auto &instrument) {
+      EXPECT_EQ(instrument.symbol, "GEZ1");
+    }));
+    EXPECT_FALSE(registry.dispatch(1, "CME", "GEH2", [](auto &) { FAIL(); }));
+  }
+  // note! instruments are destroyed with the registry
+  EXPECT_EQ(count, 0u);
+}
+
+// keys only differing by one part must not be confused
+TEST(instrument_registry, collisions) {
+  size_t count = 0;
+  Registry registry(8);
+  auto a = registry.emplace(1, "CME", "GEZ1", "a", count);
+  auto b = registry.emplace(1, "CME", "GEH2", "b", count);
+  auto c = registry.emplace(1, "ICE", "GEZ1", "c", count);
+  // note! parts are not concatenated
+  auto d = registry.emplace(1, "CMEG", "EZ1", "d", count);
+  auto e = registry.emplace(1, "", "CMEGEZ1", "e", count);
+  EXPECT_EQ(registry.find(1, "CME", "GEZ1"), a);
+  EXPECT_EQ(registry.find(1, "CME", "GEH2"), b);
+  EXPECT_EQ(registry.find(1, "ICE", "GEZ1"), c);
+  EXPECT_EQ(registry.find(1, "CMEG", "EZ1"), d);
+  EXPECT_EQ(registry.find(1, "", "CMEGEZ1"), e);
+  EXPECT_EQ(registry.find(1, "CMEGEZ1", ""), Registry::NONE);
+  // duplicate
+  EXPECT_THROW(registry.emplace(1, "CME", "GEZ1", "x", count), std::exception);
+  EXPECT_EQ(registry.size(), 5u);
+  EXPECT_EQ(count, 5u);
+}
+
+TEST(instrument_registry, sources) {
+  size_t count = 0;
+  Registry registry(8);
+  auto a = registry.emplace(0, "CME", "GEZ1", "a", count);
+  auto b = registry.emplace(3, "CME", "GEZ1", "b", count);
+  auto c = registry.emplace(3, "CME", "GEH2", "c", count);
+  // note! same symbol, different source
+  EXPECT_NE(a, b);
+  EXPECT_EQ(registry.find(0, "CME", "GEZ1"), a);
+  EXPECT_EQ(registry.find(3, "CME", "GEZ1"), b);
+  EXPECT_EQ(registry.find(1, "CME", "GEZ1"), Registry::NONE);
+  EXPECT_EQ(registry.find(0, "CME", "GEH2"), Registry::NONE);
+  EXPECT_EQ(registry.find(3, "CME", "GEH2"), c);
+  std::string result;
+  registry.for_each(3, [&](auto &instrument) { result += instrument.symbol; });
+  EXPECT_EQ(result, "bc");
+  result.clear();
+  registry.for_each(0, [&](auto &instrument) { result += instrument.symbol; });
+  EXPECT_EQ(result, "a");
+  // unknown sources
+  registry.for_each(1, [](auto &) { FAIL(); });
+  registry.for_each(255, [](auto &) { FAIL(); });
+}
+
+// note! the capacity is fixed (no rehash), the table is sized for a load
+// factor <= 0.5 and instruments are never moved
+TEST(instrument_registry, capacity) {
+  static const size_t CAPACITY = 1000;
+  size_t count = 0;
+  Registry registry(CAPACITY);
+  std::vector<const Instrument *> addresses;
+  for (size_t i = 0; i < CAPACITY; ++i) {
+    auto symbol = fmt::format("S{}", i);
+    auto id = registry.emplace(i % 4, "CME", symbol, symbol, count);
+    ASSERT_EQ(id, i);
+    addresses.push_back(&registry[id]);
+  }
+  EXPECT_EQ(registry.size(), CAPACITY);
+  for (size_t i = 0; i < CAPACITY; ++i) {
+    auto symbol = fmt::format("S{}", i);
+    ASSERT_EQ(registry.find(i % 4, "CME", symbol), i);
+    ASSERT_EQ(registry.find((i + 1) % 4, "CME", symbol), Registry::NONE);
+    ASSERT_EQ(&registry[i], addresses[i]);
+    ASSERT_EQ(registry[i].symbol, symbol);
+  }
+  EXPECT_THROW(registry.emplace(0, "CME", "X", "X", count), std::exception);
+  EXPECT_EQ(registry.size(), CAPACITY);
+  EXPECT_EQ(count, CAPACITY);
+}
@@ -0,0 +1,226 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#include <gtest/gtest.h>
+
+#include <fmt/format.h>
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "roq/api.h"
+
+#include "roq/samples/import/handler.h"
+#include "roq/samples/import/json_reader.h"
+
+#include "frames.h"
+
+using namespace roq;
+using namespace roq::samples::import;
+
+namespace {
+// one line per event: type|exchange|symbol|timestamp|...
+struct Collector final : public Handler {
+  void operator()(const GatewaySettings &, std::chrono::nanoseconds) override {}
+  void operator()(const ReferenceData &, std::chrono::nanoseconds) override {}
+  void operator()(const MarketStatus &, std::chrono::nanoseconds) override {}
+  void operator()(
+      const MarketByPriceUpdate &market_by_price_update,
+      std::chrono::nanoseconds timestamp_utc) override {
+    EXPECT_EQ(market_by_price_update.exchange_time_utc, timestamp_utc);
+    auto levels = [](auto &updates) {
+      std::string result;
+      for (auto &update : updates)
+        result += fmt::format("{}{}:{}", result.empty() ? "" : ",", update.price, update.quantity);
+      return result;
+    };
+    result.push_back(fmt::format(
+        "P|{}|{}|{}|{}|{}|{}",
+        market_by_price_update.exchange,
+        market_by_price_update.symbol,
+        timestamp_utc.count(),
+        market_by_price_update.snapshot ? "snapshot" : "update",
+        levels(market_by_price_update.bids),
+        levels(market_by_price_update.asks)));
+  }
+  void operator()(const MarketByOrderUpdate &, std::chrono::nanoseconds) override {}
+  void operator()(
+      const TradeSummary &trade_summary, std::chrono::nanoseconds timestamp_utc) override {
+    EXPECT_EQ(trade_summary.exchange_time_utc, timestamp_utc);
+    std::string trades;
+    for (auto &trade : trade_summary.trades)
+      trades += fmt::format(
+          "{}{}:{}:{}:{}",
+          trades.empty() ? "" : ",",
+          trade.side == Side::BUY ? "B" : trade.side == Side::SELL ? "S" : "?",
+          trade.price,
+          trade.quantity,
+          trade.trade_id);
+    result.push_back(fmt::format(
+        "T|{}|{}|{}|{}",
+        trade_summary.exchange,
+        trade_summary.symbol,
+        timestamp_utc.count(),
+        trades));
+  }
+  std::vector<std::string> result;
+};
+
+std::vector<std::string> read(
+    const std::string_view &name, const std::string_view &data, JSONReader::Format format) {
+  auto path = ::testing::TempDir() + "roq-samples-test-json-reader-" + std::string{name};
+  test::write_file(path, data);
+  Collector collector;
+  {
+    JSONReader reader(path, format);
+    reader.dispatch(collector);
+  }
+  std::remove(path.c_str());
+  return collector.result;
+}
+
+std::string lines(const std::vector<std::string_view> &messages) {
+  std::string result;
+  for (auto &message : messages)
+    (result += message) += '\n';
+  return result;
+}
+
+const std::vector<std::string_view> DERIBIT = {
+    // note! subscription response
+    R"({"jsonrpc":"2.0","id":42,"result":["book.BTC-PERPETUAL.raw","trades.BTC-PERPETUAL.raw"]})",
+    R"({"jsonrpc":"2.0","method":"subscription","params":{"channel":"book.BTC-PERPETUAL.raw",)"
+    R"("data":{"type":"snapshot","timestamp":1554373962454,"instrument_name":"BTC-PERPETUAL",)"
+    R"("change_id":1,"bids":[["new",5042.34,30.0],["new",5042.0,10.0]],)"
+    R"("asks":[["new",5043.0,20.0]]}}})",
+    R"({"jsonrpc":"2.0","method":"heartbeat","params":{"type":"test_request"}})",
+    "",
+    R"({"jsonrpc":"2.0","method":"subscription","params":{"channel":"book.BTC-PERPETUAL.raw",)"
+    R"("data":{"type":"change","timestamp":1554373962455,"instrument_name":"BTC-PERPETUAL",)"
+    R"("prev_change_id":1,"change_id":2,"bids":[["delete",5042.0,0.0]],)"
+    R"("asks":[["change",5043.0,25.0],["new",5043.5,1.5]]}}})",
+    // note! not a book or trades channel
+    R"({"jsonrpc":"2.0","method":"subscription","params":{"channel":"ticker.BTC-PERPETUAL.raw",)"
+    R"("data":{"timestamp":1554373962456,"instrument_name":"BTC-PERPETUAL",)"
+    R"("best_bid_price":1.0}}})",
+    R"({"jsonrpc":"2.0","method":"subscription","params":{"channel":"trades.BTC-PERPETUAL.raw",)"
+    R"("data":[{"trade_seq":1,"trade_id":"48079254","timestamp":1590484156350,"tick_direction":0,)"
+    R"("price":8950.0,"instrument_name":"BTC-PERPETUAL","direction":"sell","amount":10.0},)"
+    R"({"trade_seq":2,"trade_id":"48079255","timestamp":1590484156351,"tick_direction":1,)"
+    R"("price":8950.5,"instrument_name":"BTC-PERPETUAL","direction":"buy","amount":20.0}]}})",
+    "  \r",
+    // note! grouped book, an image
+    R"({"jsonrpc":"2.0","method":"subscription",)"
+    R"("params":{"channel":"book.ETH-PERPETUAL.none.10.100ms",)"
+    R"("data":{"timestamp":1590484156400,"instrument_name":"ETH-PERPETUAL","change_id":3,)"
+    R"("bids":[[200.25,3.0]],"asks":[[200.5,4.0],[201.0,5.0]]}}})",
+};
+
+const std::vector<std::string> DERIBIT_RESULT = {
+    "P|deribit|BTC-PERPETUAL|1554373962454000000|snapshot|5042.34:30,5042:10|5043:20",
+    "P|deribit|BTC-PERPETUAL|1554373962455000000|update|5042:0|5043:25,5043.5:1.5",
+    "T|deribit|BTC-PERPETUAL|1590484156351000000|S:8950:10:48079254,B:8950.5:20:48079255",
+    "P|deribit|ETH-PERPETUAL|1590484156400000000|snapshot|200.25:3|200.5:4,201:5",
+};
+
+const std::vector<std::string_view> COINBASE = {
+    R"({"type":"subscriptions","channels":[{"name":"level2","product_ids":["BTC-USD"]}]})",
+    R"({"type":"l2update","product_id":"BTC-USD","time":"2019-08-14T20:42:27.265Z",)"
+    R"("changes":[["buy","10101.80","0.162567"],["sell","10102.55","0"]]})",
+    // note! no time
+    R"({"type":"snapshot","product_id":"BTC-USD","bids":[["10101.10","0.45"],["10101.00","1"]],)"
+    R"("asks":[["10102.55","0.57"]]})",
+    R"({"type":"match","trade_id":10,"sequence":50,)"
+    R"("maker_order_id":"ac928c66-ca53-498f-9c13-a110027a60e8",)"
+    R"("taker_order_id":"132fb6ae-456b-4654-b4e0-d681ac05cea1",)"
+    R"("time":"2014-11-07T08:19:27.028459Z","product_id":"BTC-USD","size":"5.23512",)"
+    R"("price":"400.23","side":"sell"})",
+    // note! ignored, but the time is used by the next snapshot
+    R"({"type":"heartbeat","sequence":90,"last_trade_id":20,"product_id":"BTC-USD",)"
+    R"("time":"2014-11-07T08:19:28.464459Z"})",
+    R"({"type":"snapshot","product_id":"ETH-USD","bids":[],"asks":[["300.5","2"]]})",
+    R"({"type":"last_match","trade_id": 11 ,"time":"2014-11-07T08:19:29.5Z",)"
+    R"("product_id":"BTC-USD","size":"1","price":"400.5","side":"buy"})",
+    R"({"type":"ticker","product_id":"BTC-USD","price":"400.5","time":"2014-11-07T08:19:30Z"})",
+};
+
+const std::vector<std::string> COINBASE_RESULT = {
+    "P|coinbase|BTC-USD|1565815347265000000|update|10101.8:0.162567|10102.55:0",
+    "P|coinbase|BTC-USD|1565815347265000000|snapshot|10101.1:0.45,10101:1|10102.55:0.57",
+    "T|coinbase|BTC-USD|1415348367028459000|B:400.23:5.23512:10",  // note! taker side
+    "P|coinbase|ETH-USD|1415348368464459000|snapshot||300.5:2",
+    "T|coinbase|BTC-USD|1415348369500000000|S:400.5:1:11",
+};
+}  // namespace
+
+TEST(json_reader, deribit) {
+  auto result = read("deribit", lines(DERIBIT), JSONReader::Format::DERIBIT);
+  EXPECT_EQ(result, DERIBIT_RESULT);
+}
+
+TEST(json_reader, coinbase) {
+  auto result = read("coinbase", lines(COINBASE), JSONReader::Format::COINBASE);
+  EXPECT_EQ(result, COINBASE_RESULT);
+}
+
+// note! lines closer to the end of the file than the padding are parsed from a copy
+TEST(json_reader, padding) {
+  // no trailing newline
+  auto data = lines(DERIBIT);
+  data.pop_back();
+  EXPECT_EQ(read("padding-1", data, JSONReader::Format::DERIBIT), DERIBIT_RESULT);
+  // the copy is re-used for a shorter line
+  std::string_view match =
+      R"({"type":"match","trade_id":1,"time":"1970-01-01T00:00:01Z",)"
+      R"("product_id":"X","size":"2","price":"1.5","side":"sell"})";
+  std::string_view snapshot = R"({"type":"snapshot","product_id":"X","bids":[],"asks":[]})";
+  ASSERT_LT(snapshot.size() + 1, simdjson::SIMDJSON_PADDING);
+  data = lines({match, snapshot});
+  data.pop_back();
+  EXPECT_EQ(
+      read("padding-2", data, JSONReader::Format::COINBASE),
+      (std::vector<std::string>{
+          "T|coinbase|X|1000000000|B:1.5:2:1",
+          "P|coinbase|X|1000000000|snapshot||",
+      }));
+  // note! a snapshot without a previous message
+  data = COINBASE[2];
+  EXPECT_EQ(
+      read("padding-3", data, JSONReader::Format::COINBASE),
+      (std::vector<std::string>{
+          "P|coinbase|BTC-USD|0|snapshot|10101.1:0.45,10101:1|10102.55:0.57",
+      }));
+}
+
+TEST(json_reader, invalid) {
+  std::vector<std::pair<JSONReader::Format, std::string_view>> messages{
+      {JSONReader::Format::DERIBIT, R"({"params":{"channel":"book.X","data":{"timestamp":1}}})"},
+      {JSONReader::Format::DERIBIT,
+       R"({"params":{"channel":"book.X","data":{"timestamp":1,"instrument_name":"X",)"
+       R"("bids":[[1.0]]}}})"},
+      {JSONReader::Format::DERIBIT,
+       R"({"params":{"channel":"trades.X","data":[{"trade_id":"1","timestamp":1,)"
+       R"("instrument_name":"X","direction":"up"}]}})"},
+      {JSONReader::Format::DERIBIT, R"({"params":{"channel":"book.X","data":[]}})"},
+      {JSONReader::Format::DERIBIT, R"({"params":)"},
+      {JSONReader::Format::DERIBIT, R"([])"},
+      {JSONReader::Format::COINBASE, R"({"type":"snapshot","bids":[],"asks":[]})"},
+      {JSONReader::Format::COINBASE,
+       R"({"type":"snapshot","product_id":"X","bids":[["1.0","2.0","3.0"]]})"},
+      {JSONReader::Format::COINBASE,
+       R"({"type":"l2update","product_id":"X","changes":[["buy","1.0"]]})"},
+      {JSONReader::Format::COINBASE,
+       R"({"type":"l2update","product_id":"X","changes":[["bid","1.0","2.0"]]})"},
+      {JSONReader::Format::COINBASE,
+       R"({"type":"match","product_id":"X","price":"1.0","size":"2.0","side":"up"})"},
+      {JSONReader::Format::COINBASE,
+       R"({"type":"match","product_id":"X","price":"one","size":"2.0","side":"buy"})"},
+      {JSONReader::Format::COINBASE, R"({"type":"match","time":"2014-11-07"})"},
+  };
+  for (auto &[format, message] : messages) {
+    auto data = lines({R"({"type":"ignored"})", message});
+    EXPECT_THROW(read("invalid", data, format), RuntimeErrorException) << message;
+  }
+}
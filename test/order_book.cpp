@@ -0,0 +1,290 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <exception>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "roq/api.h"
+
+#include "roq/samples/example-3/order_book.h"
+
+using namespace roq;
+using namespace roq::samples::example_3;
+
+namespace {
+static const double TICK_SIZE = 0.5;
+
+using Index = OrderBook::Index;
+using Table = OrderBook::Table;
+
+// (is_bid, tick) => quantity
+using Levels = std::map<std::pair<bool, int64_t>, double>;
+
+// note! the hash of each index is chosen by the test (collisions)
+struct Hashes final {
+  Index find(const Table &table, Index index) const {
+    return table.find(hashes[index], [&](auto i) { return i == index; });
+  }
+  std::vector<uint64_t> hashes;
+};
+
+ReferenceData create_reference_data() {
+  return ReferenceData{
+      .stream_id = {},
+      .exchange = {},
+      .symbol = {},
+      .description = {},
+      .security_type = {},
+      .currency = {},
+      .settlement_currency = {},
+      .commission_currency = {},
+      .tick_size = TICK_SIZE,
+      .multiplier = {},
+      .min_trade_vol = {},
+      .option_type = {},
+      .strike_currency = {},
+      .strike_price = {},
+      .underlying = {},
+      .time_zone = {},
+      .issue_date = {},
+      .settlement_date = {},
+      .expiry_datetime = {},
+      .expiry_datetime_utc = {},
+  };
+}
+
+// note! the order_id must outlive the update
+MBOUpdate create_mbo_update(const std::string_view &order_id, int64_t tick, double quantity) {
+  return MBOUpdate{
+      .price = static_cast<double>(tick) * TICK_SIZE,
+      .remaining_quantity = quantity,
+      .action = quantity > 0.0 ? OrderUpdateAction::NEW : OrderUpdateAction::REMOVE,
+      .priority = {},
+      .order_id = order_id,
+  };
+}
+
+// order book and the aggregated levels it has published
+class Fixture final {
+ public:
+  Fixture() : order_book_(4) { order_book_(create_reference_data()); }
+
+  const OrderBook &order_book() const { return order_book_; }
+
+  const Levels &levels() const { return levels_; }
+
+  // note! returns the published (price level) updates
+  Levels update(std::vector<MBOUpdate> bids, std::vector<MBOUpdate> asks, bool snapshot = false) {
+    Levels result;
+    if (snapshot)
+      levels_.clear();
+    order_book_(
+        MarketByOrderUpdate{
+            .stream_id = {},
+            .exchange = {},
+            .symbol = {},
+            .bids = {bids.data(), bids.size()},
+            .asks = {asks.data(), asks.size()},
+            .snapshot = snapshot,
+            .exchange_time_utc = {},
+        },
+        [&](const MarketByPriceUpdate &market_by_price_update) {
+          apply(result, true, market_by_price_update.bids);
+          apply(result, false, market_by_price_update.asks);
+        });
+    for (auto &[key, quantity] : result)
+      if (quantity > 0.0)
+        levels_[key] = quantity;
+      else
+        levels_.erase(key);
+    return result;
+  }
+
+ protected:
+  template <typename T>
+  static void apply(Levels &result, bool is_bid, const T &updates) {
+    for (auto &[price, quantity] : updates)
+      result[{is_bid, std::llround(price / TICK_SIZE)}] = quantity;  // note! last wins
+  }
+
+ private:
+  OrderBook order_book_;
+  Levels levels_;
+};
+}  // namespace
+
+// === TABLE ===
+
+// note! capacity is rounded up to 16 slots (mask is 15)
+TEST(order_book, table_collisions_and_wraparound) {
+  Table table(8);
+  ASSERT_EQ(table.capacity(), 16u);
+  // home slot 15, i.e. the probe sequence wraps around to 0, 1, ...
+  Hashes hashes{{15, 31, 47, 16}};
+  for (Index i = 0; i < 4; ++i)
+    table.insert(hashes.hashes[i], i);
+  EXPECT_EQ(table.size(), 4u);
+  for (Index i = 0; i < 4; ++i)
+    EXPECT_EQ(hashes.find(table, i), i);
+  // the hash matches but the equality doesn't
+  EXPECT_EQ(table.find(15, [](auto) { return false; }), OrderBook::NONE);
+  // unused home slot
+  EXPECT_EQ(table.find(7, [](auto) { return true; }), OrderBook::NONE);
+}
+
+TEST(order_book, table_erase_backward_shift) {
+  Table table(8);
+  // slots 15, 0, 1 (home 15), 2 (home 0) and 3 (home 1)
+  Hashes hashes{{15, 31, 47, 16, 1}};
+  for (Index i = 0; i < 5; ++i)
+    table.insert(hashes.hashes[i], i);
+  // erase the head of the wrapping cluster, everything must shift back
+  table.erase(hashes.hashes[0], 0);
+  EXPECT_EQ(hashes.find(table, 0), OrderBook::NONE);
+  for (Index i = 1; i < 5; ++i)
+    EXPECT_EQ(hashes.find(table, i), i) << "index=" << i;
+  // erase in the middle of the cluster (after the wraparound)
+  table.erase(hashes.hashes[2], 2);
+  EXPECT_EQ(hashes.find(table, 2), OrderBook::NONE);
+  for (auto i : {1u, 3u, 4u})
+    EXPECT_EQ(hashes.find(table, i), i) << "index=" << i;
+  // re-insert
+  table.insert(hashes.hashes[0], 0);
+  table.insert(hashes.hashes[2], 2);
+  for (Index i = 0; i < 5; ++i)
+    EXPECT_EQ(hashes.find(table, i), i) << "index=" << i;
+  EXPECT_EQ(table.size(), 5u);
+}
+
+TEST(order_book, table_growth) {
+  Table table(4);
+  ASSERT_EQ(table.capacity(), 16u);
+  Hashes hashes;
+  // note! load factor <= 0.5
+  for (Index i = 0; i < 8; ++i) {
+    hashes.hashes.push_back(i * 16);  // note! same home slot
+    table.insert(hashes.hashes[i], i);
+  }
+  EXPECT_EQ(table.capacity(), 16u);
+  hashes.hashes.push_back(8 * 16);
+  table.insert(hashes.hashes[8], 8);
+  EXPECT_EQ(table.capacity(), 32u);
+  for (Index i = 0; i < 9; ++i)
+    EXPECT_EQ(hashes.find(table, i), i) << "index=" << i;
+  table.clear();
+  EXPECT_EQ(table.size(), 0u);
+  EXPECT_EQ(table.capacity(), 32u);
+  for (Index i = 0; i < 9; ++i)
+    EXPECT_EQ(hashes.find(table, i), OrderBook::NONE);
+}
+
+// note! few distinct hashes, i.e. long clusters
+TEST(order_book, table_random) {
+  static const Index COUNT = 256;
+  std::mt19937_64 generator(1);
+  std::uniform_int_distribution<uint64_t> hash(0, 63);
+  std::uniform_int_distribution<Index> index(0, COUNT - 1);
+  Table table(1);
+  Hashes hashes;
+  for (Index i = 0; i < COUNT; ++i)
+    hashes.hashes.push_back(hash(generator));
+  std::set<Index> live;
+  for (size_t step = 0; step < 20000; ++step) {
+    auto i = index(generator);
+    if (live.count(i)) {
+      table.erase(hashes.hashes[i], i);
+      live.erase(i);
+    } else {
+      table.insert(hashes.hashes[i], i);
+      live.insert(i);
+    }
+    ASSERT_EQ(table.size(), live.size());
+    for (Index j = 0; j < COUNT; ++j)
+      ASSERT_EQ(hashes.find(table, j), live.count(j) ? j : OrderBook::NONE)
+          << "step=" << step << ", index=" << j;
+  }
+}
+
+// === ORDER BOOK ===
+
+TEST(order_book, add_modify_cancel) {
+  Fixture fixture;
+  // add
+  auto result = fixture.update(
+      {create_mbo_update("1", 200, 1.0), create_mbo_update("2", 200, 2.0)},
+      {create_mbo_update("3", 201, 4.0)});
+  EXPECT_EQ(fixture.order_book().size(), 3u);
+  EXPECT_EQ(result, (Levels{{{true, 200}, 3.0}, {{false, 201}, 4.0}}));
+  // modify (quantity)
+  result = fixture.update({create_mbo_update("1", 200, 5.0)}, {});
+  EXPECT_EQ(result, (Levels{{{true, 200}, 7.0}}));
+  // modify (price)
+  result = fixture.update({create_mbo_update("2", 199, 2.0)}, {});
+  EXPECT_EQ(result, (Levels{{{true, 200}, 5.0}, {{true, 199}, 2.0}}));
+  EXPECT_EQ(fixture.order_book().size(), 3u);
+  // cancel (the level is removed)
+  result = fixture.update({create_mbo_update("1", 200, 0.0)}, {});
+  EXPECT_EQ(result, (Levels{{{true, 200}, 0.0}}));
+  EXPECT_EQ(fixture.order_book().size(), 2u);
+  // cancel (unknown)
+  result = fixture.update({create_mbo_update("1", 200, 0.0)}, {});
+  EXPECT_TRUE(result.empty());
+  EXPECT_EQ(fixture.levels(), (Levels{{{true, 199}, 2.0}, {{false, 201}, 4.0}}));
+  // snapshot
+  fixture.update({create_mbo_update("4", 198, 1.0)}, {}, true);
+  EXPECT_EQ(fixture.order_book().size(), 1u);
+  EXPECT_EQ(fixture.levels(), (Levels{{{true, 198}, 1.0}}));
+}
+
+TEST(order_book, order_id_too_long) {
+  Fixture fixture;
+  std::string order_id(OrderBook::MAX_ORDER_ID_LENGTH + 1, 'x');
+  EXPECT_THROW(fixture.update({create_mbo_update(order_id, 200, 1.0)}, {}), std::exception);
+}
+
+// the aggregated levels must match a naive per-price sum of the live orders
+TEST(order_book, random) {
+  static const size_t ORDERS = 1000;
+  std::mt19937_64 generator(2);
+  std::uniform_int_distribution<size_t> order(0, ORDERS - 1);
+  std::uniform_int_distribution<int64_t> offset(1, 20);
+  std::uniform_int_distribution<int> quantity(0, 9);
+  Fixture fixture;
+  // order_id => (is_bid, tick, quantity)
+  std::map<std::string, std::tuple<bool, int64_t, double>> orders;
+  for (size_t step = 0; step < 20000; ++step) {
+    std::vector<MBOUpdate> bids, asks;
+    std::vector<std::string> order_ids;
+    order_ids.reserve(8);  // note! MBOUpdate references the order_id
+    for (size_t i = 0; i < 8; ++i) {
+      auto id = order(generator);
+      auto &order_id = order_ids.emplace_back(std::to_string(id));
+      auto is_bid = (id % 2) == 0;  // note! an order never changes side
+      auto tick = is_bid ? 1000 - offset(generator) : 1000 + offset(generator);
+      auto value = static_cast<double>(quantity(generator));
+      (is_bid ? bids : asks).push_back(create_mbo_update(order_id, tick, value));
+      if (value > 0.0)
+        orders[order_id] = {is_bid, tick, value};
+      else
+        orders.erase(order_id);
+    }
+    fixture.update(bids, asks);
+    Levels expected;
+    for (auto &[_, item] : orders) {
+      auto &[is_bid, tick, value] = item;
+      expected[{is_bid, tick}] += value;
+    }
+    ASSERT_EQ(fixture.order_book().size(), orders.size()) << "step=" << step;
+    ASSERT_EQ(fixture.levels(), expected) << "step=" << step;
+  }
+}
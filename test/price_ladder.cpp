@@ -0,0 +1,346 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "roq/api.h"
+
+#include "roq/samples/common/price_ladder.h"
+
+using namespace roq;
+using namespace roq::samples::common;
+
+namespace {
+// note! relative (aggregates are maintained incrementally)
+static const double TOLERANCE = 1.0e-9;
+
+// price ladder and a reference (map-based) order book receiving the same updates
+template <size_t N, size_t SIZE>
+class Fixture final {
+ public:
+  explicit Fixture(double tick_size) : tick_size_(tick_size) {
+    ladder_.set_tick_size(tick_size_);
+  }
+
+  const PriceLadder<SIZE> &ladder() const { return ladder_; }
+
+  const std::array<Layer, N> &depth() const { return depth_; }
+
+  // note! ticks
+  const auto &bids() const { return bids_; }
+  const auto &asks() const { return asks_; }
+
+  // note! same as the ladder: only a different tick size clears the book
+  void set_tick_size(double tick_size) {
+    if (tick_size == tick_size_)
+      return;
+    tick_size_ = tick_size;
+    ladder_.set_tick_size(tick_size_);
+    bids_.clear();
+    asks_.clear();
+  }
+
+  size_t update(
+      const std::vector<std::pair<int64_t, double>> &bids,
+      const std::vector<std::pair<int64_t, double>> &asks,
+      bool snapshot = false) {
+    std::vector<MBPUpdate> bid_updates, ask_updates;
+    if (snapshot) {
+      bids_.clear();
+      asks_.clear();
+    }
+    for (auto [tick, quantity] : bids) {
+      bid_updates.push_back({.price = to_price(tick), .quantity = quantity});
+      apply(bids_, tick, quantity);
+    }
+    for (auto [tick, quantity] : asks) {
+      ask_updates.push_back({.price = to_price(tick), .quantity = quantity});
+      apply(asks_, tick, quantity);
+    }
+    return ladder_.update(MarketByPriceUpdate{
+        .stream_id = {},
+        .exchange = {},
+        .symbol = {},
+        .bids = {bid_updates.data(), bid_updates.size()},
+        .asks = {ask_updates.data(), ask_updates.size()},
+        .snapshot = snapshot,
+        .exchange_time_utc = {},
+    });
+  }
+
+  // compares the depth and the aggregates with the reference
+  void check() const {
+    size_t bid_levels = 0, ask_levels = 0;
+    double bid_quantity = 0.0, bid_notional = 0.0, ask_quantity = 0.0, ask_notional = 0.0;
+    for (auto [tick, quantity] : bids_) {
+      if (bid_levels == N)
+        break;
+      ASSERT_EQ(depth_[bid_levels].bid_price, to_price(tick)) << "level=" << bid_levels;
+      ASSERT_EQ(depth_[bid_levels].bid_quantity, quantity) << "level=" << bid_levels;
+      bid_quantity += quantity;
+      bid_notional += to_price(tick) * quantity;
+      ++bid_levels;
+    }
+    for (auto [tick, quantity] : asks_) {
+      if (ask_levels == N)
+        break;
+      ASSERT_EQ(depth_[ask_levels].ask_price, to_price(tick)) << "level=" << ask_levels;
+      ASSERT_EQ(depth_[ask_levels].ask_quantity, quantity) << "level=" << ask_levels;
+      ask_quantity += quantity;
+      ask_notional += to_price(tick) * quantity;
+      ++ask_levels;
+    }
+    for (auto i = bid_levels; i < N; ++i) {
+      ASSERT_EQ(depth_[i].bid_price, 0.0);
+      ASSERT_EQ(depth_[i].bid_quantity, 0.0);
+    }
+    for (auto i = ask_levels; i < N; ++i) {
+      ASSERT_EQ(depth_[i].ask_price, 0.0);
+      ASSERT_EQ(depth_[i].ask_quantity, 0.0);
+    }
+    ASSERT_EQ(ladder_.bid_levels(), bid_levels);
+    ASSERT_EQ(ladder_.ask_levels(), ask_levels);
+    ASSERT_NEAR(ladder_.bid_quantity(), bid_quantity, TOLERANCE * std::max(bid_quantity, 1.0));
+    ASSERT_NEAR(ladder_.ask_quantity(), ask_quantity, TOLERANCE * std::max(ask_quantity, 1.0));
+    if (bid_levels > 0) {
+      auto weighted_bid = bid_notional / bid_quantity;
+      ASSERT_NEAR(ladder_.weighted_bid(), weighted_bid, TOLERANCE * std::abs(weighted_bid));
+    }
+    if (ask_levels > 0) {
+      auto weighted_ask = ask_notional / ask_quantity;
+      ASSERT_NEAR(ladder_.weighted_ask(), weighted_ask, TOLERANCE * std::abs(weighted_ask));
+    }
+  }
+
+ protected:
+  double to_price(int64_t tick) const { return static_cast<double>(tick) * tick_size_; }
+
+  template <typename T>
+  static void apply(T &side, int64_t tick, double quantity) {
+    if (quantity > 0.0)
+      side[tick] = quantity;
+    else
+      side.erase(tick);
+  }
+
+ private:
+  double tick_size_;
+  std::array<Layer, N> depth_;
+  PriceLadder<SIZE> ladder_{{depth_.data(), depth_.size()}};
+  std::map<int64_t, double, std::greater<int64_t>> bids_;  // note! best first
+  std::map<int64_t, double> asks_;
+};
+
+// simulated exchange
+//
+// the mid price is a random walk with occasional jumps (larger than the
+// window) and all levels are kept within a band around the mid price, i.e.
+// the window always covers the book and the reference is exact
+//
+// note! levels leaving the band are removed *before* new levels are added
+//
+// snapshots and jumps clear the book (and the aggregates), they can be
+// disabled to let the incremental aggregates accumulate rounding errors
+template <size_t N, size_t SIZE>
+void simulate(Fixture<N, SIZE> &fixture, size_t steps, size_t check_every, bool clear = true) {
+  static const int64_t BAND = static_cast<int64_t>(SIZE / 8);
+  std::mt19937_64 generator(42);
+  std::uniform_real_distribution<double> probability(0.0, 1.0);
+  std::uniform_real_distribution<double> quantity(0.001, 100.0);
+  int64_t mid = 1000000;
+  for (size_t step = 0; step < steps; ++step) {
+    auto p = probability(generator);
+    if (clear && p < 0.001)
+      mid += (p < 0.0005 ? -1 : 1) * static_cast<int64_t>(3 * SIZE);  // note! jump
+    else if (p < 0.3)
+      mid += p < 0.15 ? -1 : 1;
+    std::vector<std::pair<int64_t, double>> bids, asks;
+    for (auto [tick, _] : fixture.bids())
+      if (tick >= mid || tick < mid - BAND)
+        bids.emplace_back(tick, 0.0);
+    for (auto [tick, _] : fixture.asks())
+      if (tick <= mid || tick > mid + BAND)
+        asks.emplace_back(tick, 0.0);
+    if (!bids.empty() || !asks.empty())
+      fixture.update(bids, asks);
+    if (clear && step % 1000 == 999) {
+      // snapshot
+      bids.clear();
+      asks.clear();
+      for (int64_t i = 1; i <= BAND; ++i) {
+        if (probability(generator) < 0.5)
+          bids.emplace_back(mid - i, quantity(generator));
+        if (probability(generator) < 0.5)
+          asks.emplace_back(mid + i, quantity(generator));
+      }
+      fixture.update(bids, asks, true);
+    } else {
+      bids.clear();
+      asks.clear();
+      for (size_t i = 0; i < 4; ++i) {
+        auto offset = 1 + static_cast<int64_t>(probability(generator) * BAND);
+        auto value = probability(generator) < 0.3 ? 0.0 : quantity(generator);
+        if (probability(generator) < 0.5)
+          bids.emplace_back(mid - offset, value);
+        else
+          asks.emplace_back(mid + offset, value);
+      }
+      fixture.update(bids, asks);
+    }
+    if ((step % check_every) == 0) {
+      fixture.check();
+      if (::testing::Test::HasFatalFailure())
+        FAIL() << "step=" << step;
+    }
+  }
+  fixture.check();
+}
+}  // namespace
+
+TEST(price_ladder, simple) {
+  Fixture<3, 64> fixture(0.5);
+  EXPECT_EQ(fixture.update({{200, 1.0}, {199, 2.0}}, {{201, 3.0}}), 2u);  // note! depth
+  fixture.check();
+  EXPECT_EQ(fixture.depth()[0].bid_price, 100.0);
+  EXPECT_EQ(fixture.depth()[1].bid_price, 99.5);
+  EXPECT_EQ(fixture.depth()[0].ask_price, 100.5);
+  EXPECT_DOUBLE_EQ(fixture.ladder().weighted_bid(), (100.0 * 1.0 + 99.5 * 2.0) / 3.0);
+  EXPECT_DOUBLE_EQ(fixture.ladder().imbalance(), 0.0);
+  EXPECT_DOUBLE_EQ(fixture.ladder().microprice(), (100.0 * 3.0 + 100.5 * 1.0) / 4.0);
+  // remove best
+  fixture.update({{200, 0.0}}, {});
+  fixture.check();
+  // removing an unknown level is not a change
+  EXPECT_EQ(fixture.update({{150, 0.0}}, {}), 0u);
+  fixture.check();
+}
+
+TEST(price_ladder, requires_tick_size) {
+  std::array<Layer, 3> depth;
+  PriceLadder<64> ladder({depth.data(), depth.size()});
+  MBPUpdate bids[] = {{.price = 100.0, .quantity = 1.0}};
+  MarketByPriceUpdate market_by_price_update{
+      .stream_id = {},
+      .exchange = {},
+      .symbol = {},
+      .bids = {bids, std::size(bids)},
+      .asks = {},
+      .snapshot = false,
+      .exchange_time_utc = {},
+  };
+  EXPECT_EQ(ladder.update(market_by_price_update), 0u);
+  EXPECT_EQ(ladder.bid_levels(), 0u);
+  ladder.set_tick_size(0.5);
+  EXPECT_EQ(ladder.update(market_by_price_update), 1u);
+  EXPECT_EQ(ladder.bid_levels(), 1u);
+  EXPECT_EQ(depth[0].bid_price, 100.0);
+}
+
+// the deepest visible level is pushed out (and becomes visible again)
+TEST(price_ladder, push_out) {
+  Fixture<3, 64> fixture(1.0);
+  fixture.update({{100, 1.0}, {99, 1.0}, {98, 1.0}}, {{101, 1.0}});
+  fixture.check();
+  // deeper than the visible levels
+  EXPECT_EQ(fixture.update({{97, 5.0}}, {}), 0u);
+  fixture.check();
+  // better than the deepest visible level
+  fixture.update({{102, 2.0}}, {});
+  fixture.check();
+  EXPECT_EQ(fixture.depth()[2].bid_price, 99.0);
+  // removing a visible level makes the next level visible
+  fixture.update({{100, 0.0}}, {});
+  fixture.check();
+  EXPECT_EQ(fixture.depth()[2].bid_price, 98.0);
+  fixture.update({{102, 0.0}, {99, 0.0}}, {});
+  fixture.check();
+  EXPECT_EQ(fixture.depth()[1].bid_price, 97.0);
+  EXPECT_EQ(fixture.ladder().bid_levels(), 2u);
+}
+
+// levels deeper than the window are ignored
+TEST(price_ladder, too_deep) {
+  std::array<Layer, 3> depth;
+  PriceLadder<64> ladder({depth.data(), depth.size()});
+  ladder.set_tick_size(1.0);
+  // note! the best price is placed a quarter into the window
+  MBPUpdate asks[] = {
+      {.price = 100.0, .quantity = 1.0},
+      {.price = 147.0, .quantity = 1.0},  // inside
+      {.price = 148.0, .quantity = 1.0},  // outside
+  };
+  ladder.update(MarketByPriceUpdate{
+      .stream_id = {},
+      .exchange = {},
+      .symbol = {},
+      .bids = {},
+      .asks = {asks, std::size(asks)},
+      .snapshot = false,
+      .exchange_time_utc = {},
+  });
+  EXPECT_EQ(ladder.ask_levels(), 2u);
+  EXPECT_EQ(depth[1].ask_price, 147.0);
+  EXPECT_EQ(depth[2].ask_quantity, 0.0);
+}
+
+// the window is re-centred when the best price moves
+TEST(price_ladder, shift) {
+  Fixture<5, 64> fixture(1.0);
+  fixture.update({{1000, 1.0}, {995, 2.0}}, {{1001, 1.0}, {1010, 2.0}});
+  fixture.check();
+  // better (beyond the window)
+  fixture.update({{1030, 3.0}}, {{980, 3.0}});
+  fixture.check();
+  // back again
+  fixture.update({{1030, 0.0}}, {{980, 0.0}});
+  fixture.check();
+  // far away (nothing survives)
+  fixture.update({{1000, 0.0}, {995, 0.0}}, {{1001, 0.0}, {1010, 0.0}});
+  fixture.update({{5000, 1.0}}, {{5001, 1.0}});
+  fixture.check();
+  // note! levels dropped by the move are gone
+  fixture.update({{4990, 1.0}}, {{5010, 1.0}});
+  fixture.check();
+}
+
+TEST(price_ladder, tick_size) {
+  Fixture<3, 64> fixture(0.5);
+  fixture.update({{200, 1.0}}, {{201, 1.0}});
+  fixture.check();
+  // note! existing levels are cleared
+  fixture.set_tick_size(0.25);
+  fixture.check();
+  EXPECT_EQ(fixture.ladder().bid_levels(), 0u);
+  fixture.update({{400, 1.0}, {399, 2.0}}, {{401, 1.0}});
+  fixture.check();
+  EXPECT_EQ(fixture.depth()[1].bid_price, 99.75);
+  // same tick size is not a change
+  fixture.set_tick_size(0.25);
+  fixture.update({}, {{402, 1.0}});
+  fixture.check();
+}
+
+TEST(price_ladder, random_small_window) {
+  Fixture<5, 64> fixture(0.01);
+  simulate(fixture, 100000, 1);
+}
+
+TEST(price_ladder, random) {
+  Fixture<10, 4096> fixture(0.0025);
+  simulate(fixture, 100000, 1);
+}
+
+// incremental aggregates must not drift from a full recompute
+TEST(price_ladder, drift) {
+  Fixture<20, 4096> fixture(0.0025);
+  simulate(fixture, 200000, 1000, false);
+}
@@ -0,0 +1,79 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include "roq/samples/import/generator.h"
+#include "roq/samples/import/index.h"
+#include "roq/samples/import/processor.h"
+
+using namespace roq;
+using namespace roq::samples::import;
+
+namespace {
+// note! ~10 seconds of events, i.e. several index entries
+Generator::Config create_config() {
+  return {
+      .seed = 1,
+      .events = 100000,
+      .symbols = 10,
+      .rate = 1.0e4,
+      .skew = 1.0,
+      .depth = 5,
+      .trade_ratio = 0.1,
+      .mbo_ratio = 0.3,
+  };
+}
+
+std::string read_file(const std::string &path) {
+  std::ifstream file(path, std::ios::binary);
+  EXPECT_TRUE(file.is_open()) << path;
+  return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+}
+
+struct Output final {
+  std::string data;
+  std::string index;
+};
+
+Output process(Processor::Encoding encoding, bool pipeline) {
+  auto path = ::testing::TempDir() + "roq-samples-test-processor";
+  auto index_path = Index::path(path);
+  {
+    Processor processor(path, encoding, 1u, pipeline);
+    Generator(create_config()).dispatch(processor);
+    processor.close();
+  }
+  Output result{
+      .data = read_file(path),
+      .index = read_file(index_path),
+  };
+  std::remove(path.c_str());
+  std::remove(index_path.c_str());
+  return result;
+}
+}  // namespace
+
+// note! the pipeline only moves work to other threads, the output must not change
+TEST(processor, pipeline) {
+  for (auto encoding : {
+           Processor::Encoding::BINARY,
+           Processor::Encoding::BASE64,
+           Processor::Encoding::LZ4,
+           Processor::Encoding::ZSTD,
+       }) {
+    SCOPED_TRACE(::testing::Message() << "encoding=" << static_cast<int>(encoding));
+    auto lhs = process(encoding, false);
+    auto rhs = process(encoding, true);
+    ASSERT_FALSE(lhs.data.empty());
+    ASSERT_FALSE(lhs.index.empty());
+    // note! not EXPECT_EQ, the output is too large to be printed
+    EXPECT_EQ(lhs.data.size(), rhs.data.size());
+    EXPECT_TRUE(lhs.data == rhs.data);
+    EXPECT_TRUE(lhs.index == rhs.index);
+  }
+}
@@ -0,0 +1,195 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "roq/api.h"
+
+#include "roq/samples/import/handler.h"
+#include "roq/samples/import/snapshotter.h"
+
+using namespace roq;
+using namespace roq::samples::import;
+
+namespace {
+static const std::chrono::nanoseconds INTERVAL{10};
+
+struct Entry final {
+  int64_t timestamp_utc;
+  std::string symbol;
+  bool snapshot;
+  double bid;  // note! best bid (or zero)
+};
+
+// market by price updates emitted
+struct Collector final : public Handler {
+  void operator()(const GatewaySettings &, std::chrono::nanoseconds) override {}
+  void operator()(const ReferenceData &, std::chrono::nanoseconds) override {}
+  void operator()(const MarketStatus &, std::chrono::nanoseconds) override {}
+  void operator()(
+      const MarketByPriceUpdate &market_by_price_update,
+      std::chrono::nanoseconds timestamp_utc) override {
+    auto &bids = market_by_price_update.bids;
+    result.push_back({
+        .timestamp_utc = timestamp_utc.count(),
+        .symbol = std::string{market_by_price_update.symbol},
+        .snapshot = market_by_price_update.snapshot,
+        .bid = std::empty(bids) ? 0.0 : bids[0].price,
+    });
+  }
+  void operator()(const MarketByOrderUpdate &, std::chrono::nanoseconds) override {}
+  void operator()(const TradeSummary &, std::chrono::nanoseconds) override {}
+  std::vector<Entry> result;
+};
+
+// note! replaces the best bid (the price is the timestamp)
+void update(
+    Handler &handler, const std::string_view &symbol, int64_t timestamp_utc, int64_t previous) {
+  MBPUpdate bids[] = {
+      {.price = static_cast<double>(timestamp_utc), .quantity = 1.0},
+      {.price = static_cast<double>(previous), .quantity = 0.0},
+  };
+  handler(
+      MarketByPriceUpdate{
+          .stream_id = {},
+          .exchange = "CME",
+          .symbol = symbol,
+          .bids = {bids, std::size(bids)},
+          .asks = {},
+          .snapshot = false,
+          .exchange_time_utc = {},
+      },
+      std::chrono::nanoseconds{timestamp_utc});
+}
+
+// same as the merge: ordered by timestamp, ties are broken by shard index
+std::vector<Entry> merge(const std::vector<std::vector<Entry>> &shards) {
+  std::vector<std::tuple<int64_t, size_t, size_t>> order;
+  for (size_t i = 0; i < shards.size(); ++i)
+    for (size_t j = 0; j < shards[i].size(); ++j)
+      order.emplace_back(shards[i][j].timestamp_utc, i, j);
+  std::sort(order.begin(), order.end());
+  std::vector<Entry> result;
+  for (auto &[_, i, j] : order)
+    result.push_back(shards[i][j]);
+  return result;
+}
+}  // namespace
+
+TEST(snapshotter, interval) {
+  Collector collector;
+  Snapshotter snapshotter(collector, INTERVAL, 0u);
+  update(snapshotter, "A", 5, 0);
+  update(snapshotter, "A", 10, 5);  // note! at the boundary
+  update(snapshotter, "A", 12, 10);
+  update(snapshotter, "A", 45, 12);  // note! several boundaries
+  std::vector<std::tuple<int64_t, bool, double>> result;
+  for (auto &entry : collector.result)
+    result.emplace_back(entry.timestamp_utc, entry.snapshot, entry.bid);
+  EXPECT_EQ(
+      result,
+      (std::vector<std::tuple<int64_t, bool, double>>{
+          {5, false, 5.0},
+          {10, false, 10.0},  // note! at the boundary
+          {10, true, 10.0},  // note! the snapshot of the boundary includes the update
+          {12, false, 12.0},
+          {40, true, 12.0},  // note! only the last boundary
+          {45, false, 45.0},
+      }));
+  EXPECT_EQ(snapshotter.timestamp_utc().count(), 45);
+}
+
+TEST(snapshotter, events) {
+  Collector collector;
+  Snapshotter snapshotter(collector, {}, 3u);
+  for (int64_t i = 1; i <= 7; ++i)
+    update(snapshotter, "A", i, i - 1);
+  std::vector<std::pair<int64_t, bool>> result;
+  for (auto &entry : collector.result)
+    result.emplace_back(entry.timestamp_utc, entry.snapshot);
+  // note! the snapshot is injected before the 4th (7th) event and uses its timestamp
+  EXPECT_EQ(
+      result,
+      (std::vector<std::pair<int64_t, bool>>{
+          {1, false},
+          {2, false},
+          {3, false},
+          {4, true},
+          {4, false},
+          {5, false},
+          {6, false},
+          {7, true},
+          {7, false},
+      }));
+}
+
+// a shard may be idle across boundaries or end before the others
+TEST(snapshotter, aligned_shards) {
+  // symbol => shard
+  std::vector<std::pair<std::string, std::vector<int64_t>>> inputs{
+      {"A", {1, 5, 10, 12, 25, 31, 45, 60, 61}},
+      {"B", {3, 10, 14}},  // note! idle and ends before the others
+      {"C", {20, 21, 40, 62}},  // note! starts after the first boundary
+  };
+  std::vector<std::unique_ptr<Collector>> collectors;
+  std::vector<std::unique_ptr<Snapshotter>> snapshotters;
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    collectors.emplace_back(std::make_unique<Collector>());
+    snapshotters.emplace_back(
+        std::make_unique<Snapshotter>(*collectors.back(), INTERVAL, 0u, true));
+    auto &[symbol, timestamps] = inputs[i];
+    int64_t previous = 0;
+    for (auto timestamp_utc : timestamps)
+      update(*snapshotters.back(), symbol, timestamp_utc, std::exchange(previous, timestamp_utc));
+  }
+  std::chrono::nanoseconds end = {};
+  for (auto &snapshotter : snapshotters)
+    end = std::max(end, (*snapshotter).timestamp_utc());
+  ASSERT_EQ(end.count(), 62);
+  for (auto &snapshotter : snapshotters)
+    (*snapshotter).flush(end);
+  std::vector<std::vector<Entry>> shards;
+  for (auto &collector : collectors)
+    shards.push_back((*collector).result);
+  auto result = merge(shards);
+  // each shard must be ordered by time (the merge relies on it)
+  for (auto &shard : shards)
+    EXPECT_TRUE(std::is_sorted(shard.begin(), shard.end(), [](auto &lhs, auto &rhs) {
+      return lhs.timestamp_utc < rhs.timestamp_utc;
+    }));
+  // every book existing at a boundary must be snapshotted before the first event after the
+  // boundary and the snapshot must include all events up to (and including) the boundary
+  for (int64_t boundary = 10; boundary < end.count(); boundary += 10) {
+    SCOPED_TRACE(::testing::Message() << "boundary=" << boundary);
+    auto first = std::find_if(result.begin(), result.end(), [&](auto &entry) {
+      return entry.timestamp_utc > boundary;
+    });
+    ASSERT_NE(first, result.end());
+    for (auto &[symbol, timestamps] : inputs) {
+      auto last = std::upper_bound(timestamps.begin(), timestamps.end(), boundary);
+      if (last == timestamps.begin())
+        continue;  // note! no book yet
+      auto expected = static_cast<double>(*(last - 1));
+      auto iter = std::find_if(result.begin(), first, [&](auto &entry) {
+        return entry.snapshot && entry.symbol == symbol && entry.timestamp_utc == boundary &&
+               entry.bid == expected;
+      });
+      EXPECT_NE(iter, first) << "symbol=" << symbol;
+    }
+  }
+  // note! snapshots are only injected at the boundaries
+  for (auto &entry : result) {
+    if (entry.snapshot) {
+      EXPECT_EQ(entry.timestamp_utc % 10, 0) << "symbol=" << entry.symbol;
+    }
+  }
+}
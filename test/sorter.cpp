@@ -0,0 +1,106 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#include <gtest/gtest.h>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "roq/api.h"
+
+#include "roq/samples/import/handler.h"
+#include "roq/samples/import/sorter.h"
+
+using namespace roq;
+using namespace roq::samples::import;
+
+namespace {
+static const size_t LINES = 2000;
+static const size_t RUN_SIZE = 1024;  // note! tiny, i.e. many runs
+
+// (timestamp, trade_id)
+using Item = std::pair<int64_t, std::string>;
+
+struct Collector final : public Handler {
+  void operator()(const GatewaySettings &, std::chrono::nanoseconds) override {}
+  void operator()(const ReferenceData &, std::chrono::nanoseconds) override {}
+  void operator()(const MarketStatus &, std::chrono::nanoseconds) override {}
+  void operator()(const MarketByPriceUpdate &, std::chrono::nanoseconds) override {}
+  void operator()(const MarketByOrderUpdate &, std::chrono::nanoseconds) override {}
+  void operator()(
+      const TradeSummary &trade_summary, std::chrono::nanoseconds timestamp_utc) override {
+    for (auto &trade : trade_summary.trades)
+      result.emplace_back(timestamp_utc.count(), std::string{trade.trade_id});
+  }
+  std::vector<Item> result;
+};
+
+// note! unordered timestamps with many duplicates (stability)
+std::vector<Item> create_input(const std::string &path, size_t seed) {
+  std::vector<Item> result;
+  std::ofstream file(path, std::ios::trunc);
+  file << "# unordered\n";
+  uint64_t state = seed;
+  for (size_t i = 0; i < LINES; ++i) {
+    state = state * 6364136223846793005u + 1442695040888963407u;  // lcg
+    auto timestamp = static_cast<int64_t>(1000 + (state >> 33) % 500);
+    auto trade_id = fmt::format("{}-{}", seed, i);
+    file << fmt::format("T,{},CME,GEZ1,B,99.785,1,{}\n", timestamp, trade_id);
+    if (i % 100 == 0)
+      file << "\n";
+    result.emplace_back(timestamp, trade_id);
+  }
+  return result;
+}
+}  // namespace
+
+TEST(sorter, spilled_runs) {
+  auto path = ::testing::TempDir() + "roq-samples-test-sorter";
+  std::vector<std::string> paths{path + ".input-0", path + ".input-1"};
+  auto expected = create_input(paths[0], 1u);
+  auto other = create_input(paths[1], 2u);
+  expected.insert(expected.end(), other.begin(), other.end());
+  // note! ties keep the input order (first file before second file)
+  std::stable_sort(std::begin(expected), std::end(expected), [](auto &lhs, auto &rhs) {
+    return lhs.first < rhs.first;
+  });
+  std::vector<std::string_view> inputs{paths[0], paths[1]};
+  Collector collector;
+  {
+    Sorter sorter(path, inputs, 3u, RUN_SIZE);
+    sorter.dispatch(collector);
+    // note! each input (roughly 60 KB) is split into many runs
+    EXPECT_TRUE(std::filesystem::exists(path + ".run-0"));
+    EXPECT_TRUE(std::filesystem::exists(path + ".run-50"));
+  }
+  // runs are removed
+  EXPECT_FALSE(std::filesystem::exists(path + ".run-0"));
+  ASSERT_EQ(collector.result.size(), expected.size());
+  EXPECT_EQ(collector.result, expected);
+  for (auto &item : paths)
+    std::remove(item.c_str());
+}
+
+TEST(sorter, single_run) {
+  auto path = ::testing::TempDir() + "roq-samples-test-sorter-single";
+  std::vector<std::string> paths{path + ".input-0"};
+  auto expected = create_input(paths[0], 3u);
+  std::stable_sort(std::begin(expected), std::end(expected), [](auto &lhs, auto &rhs) {
+    return lhs.first < rhs.first;
+  });
+  std::vector<std::string_view> inputs{paths[0]};
+  Collector collector;
+  Sorter(path, inputs, 1u, 1u << 30).dispatch(collector);
+  EXPECT_EQ(collector.result, expected);
+  for (auto &item : paths)
+    std::remove(item.c_str());
+}
@@ -0,0 +1,136 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "roq/api.h"
+
+#include "roq/samples/import/csv_reader.h"
+#include "roq/samples/import/handler.h"
+#include "roq/samples/import/validator.h"
+
+using namespace roq;
+using namespace roq::samples::import;
+
+namespace {
+// timestamps of everything emitted
+struct Collector final : public Handler {
+  void operator()(const GatewaySettings &, std::chrono::nanoseconds) override {}
+  void operator()(const ReferenceData &, std::chrono::nanoseconds) override {}
+  void operator()(const MarketStatus &, std::chrono::nanoseconds) override {}
+  void operator()(const MarketByPriceUpdate &, std::chrono::nanoseconds) override {}
+  void operator()(const MarketByOrderUpdate &, std::chrono::nanoseconds) override {}
+  void operator()(const TradeSummary &, std::chrono::nanoseconds timestamp_utc) override {
+    result.push_back(timestamp_utc.count());
+  }
+  std::vector<int64_t> result;
+};
+
+std::string read_file(const std::string &path) {
+  std::ifstream file(path);
+  std::stringstream result;
+  result << file.rdbuf();
+  return result.str();
+}
+}  // namespace
+
+TEST(validator, sequence) {
+  Validator validator(16u, {});
+  EXPECT_TRUE(validator("A", 1u, "a1"));
+  EXPECT_TRUE(validator("A", 2u, "a2"));
+  EXPECT_TRUE(validator("A", 3u, "a3"));
+  // note! the first sequence number of a channel can be anything
+  EXPECT_TRUE(validator("B", 1000u, "b1000"));
+  EXPECT_TRUE(validator("B", 1001u, "b1001"));
+  EXPECT_TRUE(validator("A", 4u, "a4"));
+}
+
+TEST(validator, gap_duplicate_late) {
+  auto path = ::testing::TempDir() + "roq-samples-test-validator.gaps";
+  {
+    Validator validator(16u, path);
+    EXPECT_TRUE(validator("A", 1u, "a1"));
+    EXPECT_TRUE(validator("A", 2u, "a2"));
+    EXPECT_TRUE(validator("A", 3u, "a3"));
+    // gap (4 and 5 are missing)
+    EXPECT_TRUE(validator("A", 6u, "a6"));
+    EXPECT_TRUE(validator("A", 7u, "a7"));
+    // duplicate
+    EXPECT_FALSE(validator("A", 2u, "a2"));
+    EXPECT_FALSE(validator("A", 7u, "a7"));
+    // late (would fill the gap), newer lines have already been accepted
+    EXPECT_FALSE(validator("A", 4u, "a4"));
+    EXPECT_FALSE(validator("A", 5u, "a5"));
+    // conflict (same sequence number, different content)
+    EXPECT_FALSE(validator("A", 3u, "x3"));
+    // the channel continues after the gap
+    EXPECT_TRUE(validator("A", 8u, "a8"));
+    // other channels are not affected
+    EXPECT_TRUE(validator("B", 1u, "b1"));
+    EXPECT_FALSE(validator("B", 1u, "b1"));
+    validator.close();
+  }
+  EXPECT_EQ(read_file(path), "channel,first_missing_seqno,last_missing_seqno\nA,4,5\n");
+  std::remove(path.c_str());
+}
+
+TEST(validator, stale) {
+  Validator validator(16u, {});
+  EXPECT_TRUE(validator("A", 1u, "a1"));
+  for (uint64_t seqno = 2u; seqno <= 100u; ++seqno)
+    EXPECT_TRUE(validator("A", seqno, std::to_string(seqno)));
+  // note! older than the window, i.e. the content is unknown
+  EXPECT_FALSE(validator("A", 50u, "50"));
+  EXPECT_FALSE(validator("A", 1u, "a1"));
+  // within the window
+  EXPECT_FALSE(validator("A", 90u, "90"));
+}
+
+// note! anything before the first sequence number is unknown
+TEST(validator, before_first) {
+  Validator validator(16u, {});
+  EXPECT_TRUE(validator("A", 1000u, "a1000"));
+  EXPECT_TRUE(validator("A", 1001u, "a1001"));
+  EXPECT_FALSE(validator("A", 999u, "a999"));
+  EXPECT_FALSE(validator("A", 990u, "a990"));
+  EXPECT_TRUE(validator("A", 1002u, "a1002"));
+}
+
+TEST(validator, large_gap) {
+  Validator validator(16u, {});
+  EXPECT_TRUE(validator("A", 1u, "a1"));
+  // note! the gap is larger than the window
+  EXPECT_TRUE(validator("A", 1000u, "a1000"));
+  EXPECT_FALSE(validator("A", 995u, "a995"));  // note! late
+  EXPECT_TRUE(validator("A", 1001u, "a1001"));
+}
+
+// the output must stay ordered by time (late lines carry older timestamps)
+TEST(validator, monotonic) {
+  auto path = ::testing::TempDir() + "roq-samples-test-validator.input";
+  {
+    std::ofstream file(path, std::ios::trunc);
+    file << "A,10,T,1000,CME,GEZ1,B,99.785,1,T10\n"
+            "A,11,T,1001,CME,GEZ1,B,99.785,1,T11\n"
+            "A,14,T,1004,CME,GEZ1,B,99.785,1,T14\n"  // note! gap
+            "A,12,T,1002,CME,GEZ1,B,99.785,1,T12\n"  // note! late
+            "A,11,T,1001,CME,GEZ1,B,99.785,1,T11\n"  // note! duplicate
+            "A,9,T,999,CME,GEZ1,B,99.785,1,T9\n"     // note! before first
+            "B,1,T,1004,CME,GEH2,B,99.785,1,T1\n"
+            "A,15,T,1005,CME,GEZ1,B,99.785,1,T15\n";
+  }
+  Validator validator(16u, {});
+  Collector collector;
+  CSVReader(path, validator).dispatch(collector);
+  EXPECT_EQ(collector.result, (std::vector<int64_t>{1000, 1001, 1004, 1004, 1005}));
+  EXPECT_TRUE(std::is_sorted(collector.result.begin(), collector.result.end()));
+  std::remove(path.c_str());
+}
@@ -0,0 +1,93 @@
+/* Copyright (c) 2017-2021, Hans Erik Thrane */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <string>
+#include <vector>
+
+#include "roq/api.h"
+
+#include "roq/samples/import/base64.h"
+#include "roq/samples/import/codec.h"
+#include "roq/samples/import/compressor.h"
+#include "roq/samples/import/verifier.h"
+#include "roq/samples/import/writer.h"
+
+#include "frames.h"
+
+using namespace roq;
+using namespace roq::samples::import;
+
+namespace {
+static const size_t FRAMES = 1000;
+
+std::string base64(const std::vector<std::string> &frames) {
+  std::string result;
+  for (auto &frame : frames) {
+    std::string buffer(Base64::encoded_length(frame.size()), '\0');
+    buffer.resize(Base64::encode(buffer.data(), frame.data(), frame.size()));
+    result += buffer;
+  }
+  return result;
+}
+
+void compress(const std::string &path, const std::vector<std::string> &frames) {
+  Writer writer(path, 4096u, false, 0u);
+  Compressor compressor(writer, Codec::ZSTD, 1, 4096u, 0u, 0u);
+  for (auto &frame : frames)
+    compressor.write(frame.data(), frame.size());
+  compressor.flush();
+  writer.close();
+}
+
+void verify(const std::string &path, size_t threads) {
+  Verifier(path, threads, true).dispatch();
+}
+}  // namespace
+
+TEST(verifier, binary) {
+  auto path = ::testing::TempDir() + "roq-samples-test-verifier-binary";
+  auto data = test::binary(test::create_frames(FRAMES));
+  test::write_file(path, data);
+  EXPECT_NO_THROW(verify(path, 1u));
+  EXPECT_NO_THROW(verify(path, 4u));
+  // truncated
+  test::write_file(path, data.substr(0, data.size() - 1));
+  EXPECT_THROW(verify(path, 4u), std::exception);
+  std::remove(path.c_str());
+}
+
+TEST(verifier, base64) {
+  auto path = ::testing::TempDir() + "roq-samples-test-verifier-base64";
+  auto data = base64(test::create_frames(FRAMES));
+  test::write_file(path, data);
+  EXPECT_NO_THROW(verify(path, 1u));
+  EXPECT_NO_THROW(verify(path, 4u));
+  // truncated
+  test::write_file(path, data.substr(0, data.size() - 1));
+  EXPECT_THROW(verify(path, 4u), std::exception);
+  std::remove(path.c_str());
+}
+
+TEST(verifier, compressed) {
+  auto path = ::testing::TempDir() + "roq-samples-test-verifier-compressed";
+  compress(path, test::create_frames(FRAMES));
+  EXPECT_NO_THROW(verify(path, 1u));
+  EXPECT_NO_THROW(verify(path, 4u));
+  std::remove(path.c_str());
+}
+
+TEST(verifier, invalid) {
+  auto path = ::testing::TempDir() + "roq-samples-test-verifier-invalid";
+  auto frames = test::create_frames(FRAMES);
+  // note! root offset (after the size prefix) pointing outside the frame
+  auto &frame = frames[FRAMES / 2];
+  for (size_t i = 0; i < 4; ++i)
+    frame[4 + i] = '\xff';
+  test::write_file(path, test::binary(frames));
+  EXPECT_THROW(verify(path, 4u), std::exception);
+  std::remove(path.c_str());
+}